@@ -0,0 +1,110 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by the Gambatte-Speedrun contributors              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License version 2 as     *
+ *   published by the Free Software Foundation.                            *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License version 2 for more details.                *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   version 2 along with this program; if not, write to the               *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+#ifndef FIRDOT_H
+#define FIRDOT_H
+
+#include <cstddef>
+
+#ifndef GAMBATTE_NO_SIMD
+#if defined __AVX2__
+#include <immintrin.h>
+#define FIR_DOT_AVX2
+#elif defined __SSE2__
+#include <emmintrin.h>
+#define FIR_DOT_SSE2
+#endif
+#endif
+
+// Adds the products of the n kernel taps k with the left and right samples of the n
+// interleaved stereo frames s to accl and accr.
+inline void firDotStereoPortable(long &accl, long &accr,
+                                 short const *k, short const *s, std::size_t n)
+{
+	for (; n; --n) {
+		accl += *k * s[0];
+		accr += *k * s[1];
+		++k;
+		s += 2;
+	}
+}
+
+#if defined FIR_DOT_AVX2 || defined FIR_DOT_SSE2
+
+namespace fir_dot_detail {
+
+// Orders the frames of each 4 as L0 L1 R0 R1 L2 L3 R2 R3, for pmaddwd against the taps
+// in pairs, k0 k1 k0 k1 k2 k3 k2 k3, to sum a pair of taps for each channel.
+inline __m128i pairChannels(__m128i const x) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 1, 2, 0)),
+	                           _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+#if defined FIR_DOT_AVX2
+inline __m256i pairChannels(__m256i const x) {
+	return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 1, 2, 0)),
+	                              _MM_SHUFFLE(3, 1, 2, 0));
+}
+#endif
+
+}
+
+// The sums are done in 32-bit lanes, as they are where long is 32 bits, which the kernels
+// made by makeSincKernel are scaled to stay within.
+inline void firDotStereo(long &accl, long &accr,
+                         short const *k, short const *s, std::size_t n)
+{
+	using namespace fir_dot_detail;
+
+#if defined FIR_DOT_AVX2
+	__m256i acc8 = _mm256_setzero_si256();
+	for (; n >= 8; n -= 8, k += 8, s += 16) {
+		__m256i const x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(s));
+		__m128i const k8 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(k));
+		__m256i const kp = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_unpacklo_epi32(k8, k8)), _mm_unpackhi_epi32(k8, k8), 1);
+		acc8 = _mm256_add_epi32(acc8, _mm256_madd_epi16(pairChannels(x), kp));
+	}
+
+	__m128i acc = _mm_add_epi32(_mm256_castsi256_si128(acc8), _mm256_extracti128_si256(acc8, 1));
+#else
+	__m128i acc = _mm_setzero_si128();
+#endif
+
+	for (; n >= 4; n -= 4, k += 4, s += 8) {
+		__m128i const x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s));
+		__m128i const k4 = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(k));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(pairChannels(x), _mm_unpacklo_epi32(k4, k4)));
+	}
+
+	acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+	accl += _mm_cvtsi128_si32(acc);
+	accr += _mm_cvtsi128_si32(_mm_srli_si128(acc, 4));
+	firDotStereoPortable(accl, accr, k, s, n);
+}
+
+#else
+
+inline void firDotStereo(long &accl, long &accr,
+                         short const *k, short const *s, std::size_t n)
+{
+	firDotStereoPortable(accl, accr, k, s, n);
+}
+
+#endif
+
+#endif
@@ -19,7 +19,6 @@
 #ifndef HAMMINGSINC_H
 #define HAMMINGSINC_H
 
-#include "array.h"
 #include "cic3.h"
 #include "makesinckernel.h"
 #include "polyphasefir.h"
@@ -58,17 +57,15 @@ public:
 	};
 
 	HammingSinc(unsigned div, unsigned phaseLen, double fc)
-	: kernel_(phaseLen * phases)
+	: kernel_(sharedSincKernel(phases, phaseLen, fc, hammingWin, 1.0))
 	, polyfir_(kernel_, phaseLen, div)
 	{
-		makeSincKernel(kernel_, phases, phaseLen, fc, hammingWin, 1.0);
 	}
 
 	HammingSinc(unsigned div, RollOff ro, double gain)
-	: kernel_(ro.taps * phases)
+	: kernel_(sharedSincKernel(phases, ro.taps, ro.fc, hammingWin, gain))
 	, polyfir_(kernel_, ro.taps, div)
 	{
-		makeSincKernel(kernel_, phases, ro.taps, ro.fc, hammingWin, gain);
 	}
 
 	virtual std::size_t resample(short *out, short const *in, std::size_t inlen) {
@@ -80,7 +77,7 @@ public:
 	virtual unsigned div() const { return polyfir_.div(); }
 
 private:
-	Array<short> const kernel_;
+	short const *const kernel_;
 	PolyphaseFir<channels, phases> polyfir_;
 
 	static double hammingWin(long i, long M) {
@@ -19,7 +19,6 @@
 #ifndef KAISER50SINC_H
 #define KAISER50SINC_H
 
-#include "array.h"
 #include "cic3.h"
 #include "makesinckernel.h"
 #include "polyphasefir.h"
@@ -60,17 +59,15 @@ public:
 	};
 
 	Kaiser50Sinc(unsigned div, unsigned phaseLen, double fc)
-	: kernel_(phaseLen * phases)
+	: kernel_(sharedSincKernel(phases, phaseLen, fc, kaiser50SincWin, 1.0))
 	, polyfir_(kernel_, phaseLen, div)
 	{
-		makeSincKernel(kernel_, phases, phaseLen, fc, kaiser50SincWin, 1.0);
 	}
 
 	Kaiser50Sinc(unsigned div, RollOff ro, double gain)
-	: kernel_(ro.taps * phases)
+	: kernel_(sharedSincKernel(phases, ro.taps, ro.fc, kaiser50SincWin, gain))
 	, polyfir_(kernel_, ro.taps, div)
 	{
-		makeSincKernel(kernel_, phases, ro.taps, ro.fc, kaiser50SincWin, gain);
 	}
 
 	virtual std::size_t resample(short *out, short const *in, std::size_t inlen) {
@@ -82,7 +79,7 @@ public:
 	virtual unsigned div() const { return polyfir_.div(); }
 
 private:
-	Array<short> const kernel_;
+	short const *const kernel_;
 	PolyphaseFir<channels, phases> polyfir_;
 };
 
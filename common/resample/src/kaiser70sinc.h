@@ -19,7 +19,6 @@
 #ifndef KAISER70SINC_H
 #define KAISER70SINC_H
 
-#include "array.h"
 #include "cic4.h"
 #include "makesinckernel.h"
 #include "polyphasefir.h"
@@ -60,17 +59,15 @@ public:
 	};
 
 	Kaiser70Sinc(unsigned div, unsigned phaseLen, double fc)
-	: kernel_(phaseLen * phases)
+	: kernel_(sharedSincKernel(phases, phaseLen, fc, kaiser70SincWin, 1.0))
 	, polyfir_(kernel_, phaseLen, div)
 	{
-		makeSincKernel(kernel_, phases, phaseLen, fc, kaiser70SincWin, 1.0);
 	}
 
 	Kaiser70Sinc(unsigned div, RollOff ro, double gain)
-	: kernel_(ro.taps * phases)
+	: kernel_(sharedSincKernel(phases, ro.taps, ro.fc, kaiser70SincWin, gain))
 	, polyfir_(kernel_, ro.taps, div)
 	{
-		makeSincKernel(kernel_, phases, ro.taps, ro.fc, kaiser70SincWin, gain);
 	}
 
 	virtual std::size_t resample(short *out, short const *in, std::size_t inlen) {
@@ -82,7 +79,7 @@ public:
 	virtual unsigned div() const { return polyfir_.div(); }
 
 private:
-	Array<short> const kernel_;
+	short const *const kernel_;
 	PolyphaseFir<channels, phases> polyfir_;
 };
 
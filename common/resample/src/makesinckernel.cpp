@@ -18,7 +18,22 @@
  ***************************************************************************/
 #include "makesinckernel.h"
 #include "array.h"
+#include "uncopyable.h"
+#include <algorithm>
 #include <cmath>
+#include <complex>
+#include <functional>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 void makeSincKernel(short *const kernel, int const phases, int const phaseLen, double fc,
                     double (*const win)(long m, long M), double const maxAllowedGain)
@@ -128,3 +143,263 @@ void makeSincKernel(short *const kernel, int const phases, int const phaseLen, d
 			*km-- = *k++ = static_cast<short>(std::floor(*dk++ * gain + 0.5));
 	}
 }
+
+namespace {
+
+double const pi = 3.14159265358979323846;
+
+typedef std::complex<double> Complex;
+
+// In place radix-2 DFT of a, whose size is a power of 2. The inverse is not scaled.
+void fft(std::vector<Complex> &a, bool const inverse) {
+	std::size_t const n = a.size();
+	for (std::size_t i = 1, j = 0; i < n; ++i) {
+		std::size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+
+		j ^= bit;
+		if (i < j)
+			std::swap(a[i], a[j]);
+	}
+
+	std::vector<Complex> twiddles(n / 2);
+	for (std::size_t i = 0; i < n / 2; ++i)
+		twiddles[i] = std::polar(1.0, (inverse ? 2 : -2) * pi * i / n);
+
+	for (std::size_t len = 2; len <= n; len *= 2) {
+		std::size_t const step = n / len;
+		for (std::size_t i = 0; i < n; i += len) {
+			for (std::size_t k = 0; k < len / 2; ++k) {
+				// written out, as the complex operator* checks for infinities
+				Complex const u = a[i + k], w = a[i + k + len / 2], t = twiddles[k * step];
+				Complex const v(w.real() * t.real() - w.imag() * t.imag(),
+				                w.real() * t.imag() + w.imag() * t.real());
+				a[i + k] = u + v;
+				a[i + k + len / 2] = u - v;
+			}
+		}
+	}
+}
+
+// Replaces the linear phase filter h with the minimum phase filter of the same magnitude
+// response, by zeroing the anti-causal part of its real cepstrum. The DFT is made 4 times
+// the length of h to keep the cepstrum from wrapping around into what is kept, and the
+// magnitude is floored well below the stop band to keep the log finite.
+void toMinPhase(std::vector<double> &h) {
+	std::size_t n = 1;
+	while (n < h.size() * 4)
+		n *= 2;
+
+	std::vector<Complex> a(n);
+	std::copy(h.begin(), h.end(), a.begin());
+	fft(a, false);
+
+	double peak = 0;
+	for (std::size_t i = 0; i < n; ++i)
+		peak = std::max(peak, std::abs(a[i]));
+
+	for (std::size_t i = 0; i < n; ++i)
+		a[i] = std::log(std::max(std::abs(a[i]), peak * 1.0e-9));
+
+	fft(a, true);
+	for (std::size_t i = 1; i < n / 2; ++i) {
+		a[i] = 2.0 * a[i].real() / double(n);
+		a[n - i] = 0;
+	}
+
+	a[0] = a[0].real() / n;
+	a[n / 2] = a[n / 2].real() / n;
+	fft(a, false);
+	for (std::size_t i = 0; i < n; ++i)
+		a[i] = std::exp(a[i]);
+
+	fft(a, true);
+	for (std::size_t i = 0; i < h.size(); ++i)
+		h[i] = a[i].real() / n;
+}
+
+// Minimum phase prototypes are made with at most this many phases. The DFTs of
+// toMinPhase would otherwise take a good part of a second for the 2048 phase kernels of
+// ChainResampler, at some million points. The pass band is then still less than a 64th
+// of the prototype rate, which cubic interpolation gets to well within the rounding of
+// the taps.
+enum { max_prototype_phases = 32 };
+
+// Cubic (4 point Lagrange) interpolation of h at x, taking h as 0 outside of it.
+double interpolate(std::vector<double> const &h, double const x) {
+	long const j = long(std::floor(x));
+	double const t = x - j;
+	double const c[4] = {
+		-t * (t - 1) * (t - 2) / 6,
+		(t + 1) * (t - 1) * (t - 2) / 2,
+		-(t + 1) * t * (t - 2) / 2,
+		(t + 1) * t * (t - 1) / 6
+	};
+
+	double sum = 0;
+	for (int k = 0; k < 4; ++k) {
+		if (j - 1 + k >= 0 && j - 1 + k < long(h.size()))
+			sum += c[k] * h[j - 1 + k];
+	}
+
+	return sum;
+}
+
+typedef void (*MakeKernel)(short *kernel, int phases, int phaseLen,
+                           double fc, double (*win)(long m, long M), double gain);
+
+struct SincKernelKey {
+	MakeKernel make;
+	double (*win)(long m, long M);
+	int phases;
+	int phaseLen;
+	double fc;
+	double gain;
+
+	bool operator<(SincKernelKey const &k) const {
+		if (make != k.make)
+			return std::less<MakeKernel>()(make, k.make);
+		if (win != k.win)
+			return std::less<double (*)(long, long)>()(win, k.win);
+		if (phases != k.phases)
+			return phases < k.phases;
+		if (phaseLen != k.phaseLen)
+			return phaseLen < k.phaseLen;
+		if (fc != k.fc)
+			return fc < k.fc;
+
+		return gain < k.gain;
+	}
+};
+
+class SincKernelCache : Uncopyable {
+public:
+	typedef std::map<SincKernelKey, short *> Map;
+
+	Map kernels;
+
+	~SincKernelCache() {
+		for (Map::iterator it = kernels.begin(); it != kernels.end(); ++it)
+			delete[] it->second;
+	}
+};
+
+// Holds the lock of the kernel cache for its scope. The lock needs no set up, so that it
+// works for the first kernel made by any thread.
+class SincKernelCacheLock : Uncopyable {
+public:
+#ifdef _WIN32
+	SincKernelCacheLock() {
+		while (InterlockedCompareExchange(&locked_, 1, 0))
+			Sleep(0);
+	}
+
+	~SincKernelCacheLock() { InterlockedExchange(&locked_, 0); }
+
+private:
+	static LONG volatile locked_;
+#else
+	SincKernelCacheLock() { pthread_mutex_lock(&mutex_); }
+	~SincKernelCacheLock() { pthread_mutex_unlock(&mutex_); }
+
+private:
+	static pthread_mutex_t mutex_;
+#endif
+};
+
+#ifdef _WIN32
+LONG volatile SincKernelCacheLock::locked_ = 0;
+#else
+pthread_mutex_t SincKernelCacheLock::mutex_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+short const * sharedKernel(MakeKernel const make, int const phases, int const phaseLen,
+                           double const fc, double (*const win)(long m, long M), double const gain)
+{
+	// resamplers can be created on several threads at once, for several emulators
+	SincKernelCacheLock const lock;
+	static SincKernelCache cache;
+	SincKernelKey const key = { make, win, phases, phaseLen, fc, gain };
+	SincKernelCache::Map::iterator it = cache.kernels.find(key);
+	if (it == cache.kernels.end()) {
+		short *const kernel = new short[std::size_t(phaseLen) * phases];
+		make(kernel, phases, phaseLen, fc, win, gain);
+		it = cache.kernels.insert(std::make_pair(key, kernel)).first;
+	}
+
+	return it->second;
+}
+
+}
+
+void makeMinPhaseSincKernel(short *const kernel, int const phases, int const phaseLen, double const fc,
+                            double (*const win)(long m, long M), double const maxAllowedGain)
+{
+	// As the concise version of makeSincKernel, with the filter made minimum phase
+	// before it is split into phases. The prototype is made minimum phase with at most
+	// max_prototype_phases phases and interpolated to the rest, see interpolate.
+	int const protoPhases = std::min<int>(phases, max_prototype_phases);
+	long const protoM = long(phaseLen) * protoPhases - 1;
+	std::vector<double> proto(protoM + 1);
+	for (long i = 0; i < protoM + 1; ++i) {
+		double const sinc = i * 2 == protoM
+		                  ? pi * fc / protoPhases
+		                  : std::sin(pi * fc / protoPhases * (i * 2 - protoM)) / (i * 2 - protoM);
+		proto[i] = win(i, protoM) * sinc;
+	}
+
+	toMinPhase(proto);
+
+	long const M = long(phaseLen) * phases - 1;
+	std::vector<double> h(M + 1);
+	for (long i = 0; i < M + 1; ++i)
+		h[i] = interpolate(proto, double(i) * protoPhases / phases);
+
+	// PolyphaseFir applies the last tap to the newest sample, which makes no difference
+	// to the symmetric linear phase kernels, but here the energy must be at that end.
+	std::reverse(h.begin(), h.end());
+
+	Array<double> const dkernel(M + 1);
+	for (long i = 0; i < M + 1; ++i)
+		dkernel[std::size_t((phases - (i % phases)) % phases) * phaseLen + i / phases] = h[i];
+
+	double maxabsgain = 0;
+	for (int ph = 0; ph < phases; ++ph) {
+		double gain = 0;
+		double absgain = 0;
+		for (int i = 0; i < phaseLen; ++i) {
+			gain += dkernel[std::size_t(ph) * phaseLen + i];
+			absgain += std::abs(dkernel[std::size_t(ph) * phaseLen + i]);
+		}
+
+		gain = 1.0 / gain;
+		// Per phase normalization to avoid DC fluctuations.
+		for (int i = 0; i < phaseLen; ++i)
+			dkernel[std::size_t(ph) * phaseLen + i] *= gain;
+
+		absgain *= gain;
+		if (absgain > maxabsgain)
+			maxabsgain = absgain;
+	}
+
+	// With its energy at the start, a minimum phase kernel has a larger sum of absolute
+	// taps in a phase than the linear phase one (2.4 against 1.9 for the big stage at
+	// 44.1 kHz), so it is scaled down more to keep that sum from overflowing, and the
+	// rounding of its taps costs up to about 2 dB more SNR.
+	double const gain = (0x10000 - 0.5 * phaseLen) * maxAllowedGain / maxabsgain;
+	for (long i = 0; i < M + 1; ++i)
+		kernel[i] = static_cast<short>(std::floor(dkernel[i] * gain + 0.5));
+}
+
+short const * sharedSincKernel(int const phases, int const phaseLen, double const fc,
+                               double (*const win)(long m, long M), double const gain)
+{
+	return sharedKernel(makeSincKernel, phases, phaseLen, fc, win, gain);
+}
+
+short const * sharedMinPhaseSincKernel(int const phases, int const phaseLen, double const fc,
+                                       double (*const win)(long m, long M), double const gain)
+{
+	return sharedKernel(makeMinPhaseSincKernel, phases, phaseLen, fc, win, gain);
+}
@@ -22,4 +22,25 @@
 void makeSincKernel(short *kernel, int phases, int phaseLen,
                     double fc, double (*win)(long m, long M), double gain);
 
+/**
+  * Returns a kernel made by makeSincKernel with these arguments. It is made on the first
+  * call with them and kept for the rest of the process, so that resamplers sharing it can
+  * be recreated on a rate change or audio reset without making it again.
+  * Thread safe, a kernel being made holds up other threads getting one.
+  */
+short const * sharedSincKernel(int phases, int phaseLen,
+                               double fc, double (*win)(long m, long M), double gain);
+
+/**
+  * Like makeSincKernel, but for a minimum phase filter with the same magnitude response,
+  * which has its energy as early as it can be, for less latency at the cost of a phase
+  * response that is not linear.
+  */
+void makeMinPhaseSincKernel(short *kernel, int phases, int phaseLen,
+                            double fc, double (*win)(long m, long M), double gain);
+
+/** Like sharedSincKernel, for makeMinPhaseSincKernel. */
+short const * sharedMinPhaseSincKernel(int phases, int phaseLen,
+                                       double fc, double (*win)(long m, long M), double gain);
+
 #endif
@@ -0,0 +1,62 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by the Gambatte-Speedrun contributors              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License version 2 as     *
+ *   published by the Free Software Foundation.                            *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License version 2 for more details.                *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   version 2 along with this program; if not, write to the               *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+#ifndef MINPHASEKAISER70SINC_H
+#define MINPHASEKAISER70SINC_H
+
+#include "kaiser70sinc.h"
+#include "makesinckernel.h"
+#include "polyphasefir.h"
+#include "subresampler.h"
+#include <cstddef>
+
+// Kaiser70Sinc with the minimum phase version of its kernel (see makeMinPhaseSincKernel),
+// which has the same magnitude response and much less delay.
+template<unsigned channels, unsigned phases>
+class MinPhaseKaiser70Sinc : public SubResampler {
+public:
+	enum { MUL = phases };
+	typedef typename Kaiser70Sinc<channels, phases>::Cic Cic;
+	typedef typename Kaiser70Sinc<channels, phases>::RollOff RollOff;
+	static float cicLimit() { return Kaiser70Sinc<channels, phases>::cicLimit(); }
+
+	MinPhaseKaiser70Sinc(unsigned div, unsigned phaseLen, double fc)
+	: kernel_(sharedMinPhaseSincKernel(phases, phaseLen, fc, kaiser70SincWin, 1.0))
+	, polyfir_(kernel_, phaseLen, div)
+	{
+	}
+
+	MinPhaseKaiser70Sinc(unsigned div, RollOff ro, double gain)
+	: kernel_(sharedMinPhaseSincKernel(phases, ro.taps, ro.fc, kaiser70SincWin, gain))
+	, polyfir_(kernel_, ro.taps, div)
+	{
+	}
+
+	virtual std::size_t resample(short *out, short const *in, std::size_t inlen) {
+		return polyfir_.filter(out, in, inlen);
+	}
+
+	virtual void adjustDiv(unsigned div) { polyfir_.adjustDiv(div); }
+	virtual unsigned mul() const { return MUL; }
+	virtual unsigned div() const { return polyfir_.div(); }
+
+private:
+	short const *const kernel_;
+	PolyphaseFir<channels, phases> polyfir_;
+};
+
+#endif
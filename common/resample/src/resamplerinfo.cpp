@@ -20,6 +20,7 @@
 #include "chainresampler.h"
 #include "kaiser50sinc.h"
 #include "kaiser70sinc.h"
+#include "minphasekaiser70sinc.h"
 // #include "hammingsinc.h"
 // #include "blackmansinc.h"
 #include "rectsinc.h"
@@ -36,6 +37,7 @@ ResamplerInfo const ResamplerInfo::resamplers_[] = {
 // 	{ "Blackman windowed sinc (~70 dB SNR)", ChainResampler::create<BlackmanSinc> },
 	{ "Very high quality (polyphase FIR)", ChainResampler::create<Kaiser50Sinc> },
 	{ "Highest quality (polyphase FIR)", ChainResampler::create<Kaiser70Sinc> },
+	{ "Highest quality, low latency (minimum phase FIR)", ChainResampler::create<MinPhaseKaiser70Sinc> },
 };
 
 std::size_t const ResamplerInfo::num_ =
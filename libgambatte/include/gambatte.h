@@ -84,10 +84,13 @@ public:
 	  * The return value indicates whether a new video frame has been drawn, and the
 	  * exact time (in number of samples) at which it was completed.
 	  *
-	  * @param videoBuf 160x144 RGB32 (native endian) video frame buffer or 0
+	  * @param videoBuf 160x144 RGB32 (native endian) video frame buffer or 0.
+	  *                 For other video formats, a buffer of that format's pixels
+	  *                 cast to uint_least32_t *. See setVideoFormat.
 	  * @param pitch distance in number of pixels (not bytes) from the start of one line
 	  *              to the next in videoBuf.
-	  * @param audioBuf buffer with space >= samples + 2064
+	  * @param audioBuf buffer with space >= samples + 2064, or 0 while setAudioOutputRate
+	  *                 or the NO_SOUND speedup flag is in effect, which leave it alone.
 	  * @param samples  in: number of stereo samples to produce,
 	  *                out: actual number of samples produced
 	  * @return sample offset in audioBuf at which the video frame was completed, or -1
@@ -96,6 +99,60 @@ public:
 	std::ptrdiff_t runFor(gambatte::uint_least32_t *videoBuf, std::ptrdiff_t pitch,
 	                      gambatte::uint_least32_t *audioBuf, std::size_t &samples);
 
+	/**
+	  * Synthesizes audio directly at rate Hz (e.g. 48000, below 1048576), to be read with
+	  * readAudio, instead of putting 2097152 Hz samples in the runFor audio buffer to be
+	  * resampled. Steps in the output are band-limited, which delays it by 16
+	  * samples. The samples argument of runFor still counts 2097152 Hz samples.
+	  * 0 (the default) goes back to the runFor audio buffer.
+	  */
+	void setAudioOutputRate(long rate);
+
+	/**
+	  * Reads up to maxSamples stereo samples synthesized since setAudioOutputRate, in the
+	  * runFor audio buffer sample format. Samples not read stay for the next call,
+	  * up to the last 30720 of them.
+	  *
+	  * @return number of samples read
+	  */
+	std::size_t readAudio(gambatte::uint_least32_t *dest, std::size_t maxSamples);
+
+	/**
+	  * Makes runFor also write the output of each of the four sound channels, before
+	  * NR50 volume and NR51 panning, to its own buffer. Each buffer is written from its
+	  * start on every runFor call. A stem sample is the mean of decimation (1 to 65536)
+	  * 2097152 Hz samples, as a 2s complement 16-bit value of 2048 times the channel's
+	  * level (-15 to 15, or 0 with its DAC off). The mixed output is unchanged.
+	  * Stems are still produced with the NO_SOUND speedup flag, which then only skips
+	  * the mixing, so that they stay cheap to keep on.
+	  *
+	  * @param stems 4 buffers, for channels 1 to 4, each with space for
+	  *              (samples + 2064) / decimation + 1 stem samples, or 0 to turn stems off.
+	  */
+	void setAudioStems(gambatte::uint_least16_t *const *stems, unsigned decimation = 1);
+
+	/** @return number of samples written to each stem buffer by the last runFor call. */
+	std::size_t audioStemSamples() const;
+
+	/**
+	  * Starts or stops logging the writes to the sound registers and wave RAM, with
+	  * their timing, and the sound state at the start and at every state load. A
+	  * SoundLogRenderer (soundlog.h) turns the log back into the exact audio of the run,
+	  * later or on another thread. This works with the NO_SOUND speedup flag, so that
+	  * fast runs can still have their audio rendered on demand. Starting or stopping
+	  * discards any log not read yet, but for the rest of a record partly read. A log
+	  * left with more than 1 MiB unread at the end of a runFor call starts over there,
+	  * from the sound state, so that it does not grow without bound.
+	  */
+	void setSoundLogging(bool on);
+
+	/**
+	  * Moves up to size bytes from the start of the sound log into dest.
+	  *
+	  * @return number of bytes moved
+	  */
+	std::size_t readSoundLog(char *dest, std::size_t size);
+
 	/**
 	  * Reset to initial state.
 	  * Equivalent to reloading a ROM image, or turning a Game Boy Color off and on again.
@@ -111,12 +168,132 @@ public:
 	/** Use GBP color conversion instead of GBC-screen approximation. */
 	void setTrueColors(bool trueColors);
 
+	enum VideoFormat {
+		RGB32,    /**< 32-bit native endian xRGB pixels (default). */
+		INDEXED8, /**< 8-bit pixel values, see getIndexedPalette. */
+		RGB565,   /**< 16-bit native endian pixels, red in the top 5 bits. */
+		BGR555    /**< 16-bit native endian pixels, red in the low 5 bits. */
+	};
+
+	enum {
+		/** Number of INDEXED8 pixel values, see getIndexedPalette. */
+		INDEXED_PALETTE_SIZE = 0x42
+	};
+
+	/**
+	  * Sets the pixel format runFor writes video frames in. Snapshots passed to
+	  * saveState must still be RGB32 (or 0).
+	  */
+	void setVideoFormat(VideoFormat format);
+
+	/**
+	  * Only draws lines firstLine to lastLine (0 to 143, the default is all of them) of
+	  * the video frames runFor and renderLastFrame produce, for frontends that only read
+	  * part of the screen. Other lines of the video buffer are left alone, except on the
+	  * SGB, which still puts whole frames there. Emulation, including timing, is the same
+	  * for any window, and firstLine > lastLine draws nothing.
+	  */
+	void setRenderWindow(unsigned firstLine, unsigned lastLine);
+
+	/**
+	  * Gets the RGB32 color of each INDEXED8 pixel value, as currently set by the game.
+	  * Pixel values are:
+	  *   CGB: palette number * 4 + color number, plus 0x20 for sprite palettes.
+	  *   DMG: palNum * 4 + shade, where palNum is as for setDmgPaletteColor.
+	  *   SGB: SGB palette number * 4 + shade.
+	  *   0x40: LCD off white (CGB), 0x41: black (no frame drawn).
+	  * Colors can change mid-frame, in which case lines drawn earlier may have used
+	  * different ones. Writes to the CGB palette registers by a DMG game running on the
+	  * CGB (which change its colors in RGB32) are not seen in INDEXED8.
+	  *
+	  * @param dest length of at least INDEXED_PALETTE_SIZE
+	  */
+	void getIndexedPalette(gambatte::uint_least32_t *dest);
+
+	/** A copy of what the VRAM viewers draw from, see getVideoSnapshot. */
+	struct VideoSnapshot {
+		unsigned char vram[0x4000];      /**< Both banks, the second one is unused on DMG. */
+		unsigned char oam[0xA0];
+		uint_least32_t bgPalette[8 * 4]; /**< RGB32. DMG: BGP in the first 4 entries. */
+		uint_least32_t spPalette[8 * 4]; /**< RGB32. DMG: OBP0 then OBP1 in the first 8 entries. */
+		unsigned char lcdc, scy, scx, wy, wx;
+		bool cgb;                        /**< Tile maps have CGB attributes in bank 1. */
+	};
+
+	/**
+	  * Copies VRAM, OAM, palettes and the scroll registers as they are now. The
+	  * drawTileSheet, drawTileMap and drawSprites functions only read the snapshot, so
+	  * they can run on another thread while emulation goes on. DMG palettes are those
+	  * of setDmgPaletteColor, SGB colors are not applied.
+	  */
+	void getVideoSnapshot(VideoSnapshot &dest);
+
+	/**
+	  * Draws the 384 tiles of a VRAM bank as a 128x192 RGB32 image, 16 tiles per row.
+	  *
+	  * @param bank 0, or 1 on CGB
+	  * @param palette 0-7 for a BG palette, 8-15 for a sprite palette
+	  */
+	static void drawTileSheet(VideoSnapshot const &snapshot, uint_least32_t *dest,
+	                          std::ptrdiff_t pitch, unsigned bank, unsigned palette);
+
+	/**
+	  * Draws a whole 256x256 tile map as RGB32, using the tile data LCDC selects. If
+	  * outline is set, the visible area is outlined by inverting its border: the screen
+	  * at SCX, SCY for the map LCDC selects for the BG, and the window area for the map
+	  * it selects for the window (if the window is enabled).
+	  *
+	  * @param map 0 for the map at 0x9800, 1 for the one at 0x9C00
+	  */
+	static void drawTileMap(VideoSnapshot const &snapshot, uint_least32_t *dest,
+	                        std::ptrdiff_t pitch, unsigned map, bool outline);
+
+	/**
+	  * Draws the 40 sprites in OAM order as a 64x80 RGB32 image of 8x16 cells, 8 per
+	  * row, with their own palettes and flips. 8x8 sprites take the top of their cell.
+	  * Transparent pixels are left as they are, so dest can be cleared to any color first.
+	  */
+	static void drawSprites(VideoSnapshot const &snapshot, uint_least32_t *dest, std::ptrdiff_t pitch);
+
 	/** Use cycle-based RTC instead of real-time. */
 	void setTimeMode(bool useCycles);
 
 	/** Sets the callback used for getting input state. */
 	void setInputGetter(InputGetter *getInput, void *p);
 
+	/**
+	  * Sets a sequence of input states, one per video frame, to be used instead of the
+	  * InputGetter, so that runFor need not be split at input changes. inputs[0] applies
+	  * immediately, also to the joypad register as read by externalRead, and the next
+	  * entry is applied each time a video frame is completed as reported by runFor. That
+	  * includes the blank frames completed while the LCD is off, but not the partial
+	  * frame in which it is turned off. Once all n entries have been used, input is read
+	  * from the InputGetter again.
+	  * The inputs array must stay valid until then, or until replaced by another call.
+	  * The schedule position is not part of savestates. n = 0 clears the schedule.
+	  *
+	  * @param inputs A|B|SELECT|START|RIGHT|LEFT|UP|DOWN bits, as returned by InputGetter
+	  */
+	void setInputSchedule(unsigned char const *inputs, std::size_t n);
+
+	/**
+	  * Like runFor, but does not return at the video frames completed while entries of
+	  * the setInputSchedule schedule are left, so that a whole schedule can be played
+	  * with one call. It returns at the frame that uses up the schedule, which is the one
+	  * left in videoBuf, or like runFor when there is no schedule. The frames before it
+	  * are drawn to videoBuf too, and overwritten. It is run as runFor calls of a few
+	  * frames each, so setAudioStems buffers only get the audio of the last of them.
+	  *
+	  * @param audioBuf buffer with space >= samples + 2064, or 0 while
+	  *                 setAudioOutputRate or the NO_SOUND speedup flag is in effect.
+	  *                 The audio of all the frames run goes in it, so to play the
+	  *                 schedule at once, samples must cover them, about 35112 per frame.
+	  * @return sample offset in audioBuf at which the last video frame was completed, or
+	  *         -1 if samples ran out first.
+	  */
+	std::ptrdiff_t runSchedule(gambatte::uint_least32_t *videoBuf, std::ptrdiff_t pitch,
+	                           gambatte::uint_least32_t *audioBuf, std::size_t &samples);
+
 	/**
 	  * Sets the directory used for storing save data. The default is the same directory as
 	  * the ROM Image file.
@@ -268,12 +445,98 @@ public:
 	enum SpeedupFlag {
 		NO_SOUND    = 1,  /**< Skip generating sound samples. */
 		NO_PPU_CALL = 2,  /**< Skip PPU calls. (breaks LCD interrupt) */
-		NO_VIDEO    = 4   /**< Skip writing to the video buffer. */
+		NO_VIDEO    = 4,  /**< Skip writing to the video buffer. */
+		DEFER_VIDEO = 8,  /**< Only log what is needed to draw a frame, see renderLastFrame(). */
+		/**
+		  * Draw frames on a worker thread while the next one is emulated (in place, without
+		  * a worker, unless the library was built with threads=1). runFor() puts each frame
+		  * in the video buffer once the next one is done, so the frames shown lag one behind,
+		  * except on the SGB. renderLastFrame() has nothing to draw while this is set.
+		  */
+		THREADED_VIDEO = 16
 	};
 
 	/** Sets flags to control non-critical processes for CPU-concerned emulation. */
 	void setSpeedupFlags(unsigned flags);
 
+	/**
+	  * Draws the last completed frame from what was logged while the DEFER_VIDEO speedup
+	  * flag was set, for frontends that only show some of the frames they emulate.
+	  * Emulation is exactly the same as without the flag, but runFor() leaves the video
+	  * buffer alone (except on the SGB, which needs every frame).
+	  *
+	  * Can be called until the first line of the next frame is drawn, which is any time
+	  * after runFor() returned a completed frame and before it is called again.
+	  * Lines the LCD did not draw are left as they are, and no OSD is drawn.
+	  *
+	  * @param videoBuf 160x144 buffer in the current video format, like for runFor()
+	  * @param pitch distance in pixels between the starts of two lines in videoBuf
+	  * @return false if there is no complete frame to draw
+	  */
+	bool renderLastFrame(uint_least32_t *videoBuf, std::ptrdiff_t pitch);
+
+	/** A video register write recorded while the raster trace is enabled. */
+	struct RasterWrite {
+		unsigned char reg;        /**< Register address minus 0xFF00, e.g. 0x43 for SCX. */
+		unsigned char data;       /**< Value written. */
+		unsigned char ly;         /**< Line the LCD was on (0-153, 0 while it is off). */
+		unsigned short lineCycle; /**< Single speed cycles into the line (0-455). */
+	};
+
+	enum {
+		/** Number of writes kept per frame by the raster trace. */
+		RASTER_TRACE_SIZE = 4096
+	};
+
+	/**
+	  * Starts or stops recording writes to LCDC, STAT, SCY, SCX, BGP, OBP0, OBP1, WY, WX,
+	  * BCPS, BCPD, OCPS and OCPD, for looking into raster effects. Writes are collected per
+	  * frame, starting over when runFor() completes a frame. Enabling or disabling clears
+	  * the trace.
+	  *
+	  * Mode 3 starts at line cycle 80 of lines 0-143, so writes from there until about
+	  * cycle 252 land while the line is being drawn. These are the ones that keep lines
+	  * from being rendered in one go.
+	  */
+	void setRasterTrace(bool enable);
+
+	/**
+	  * Gets the register writes made during the last completed frame in the order they
+	  * happened. At most RASTER_TRACE_SIZE writes are kept per frame.
+	  *
+	  * @param dest room for size writes
+	  * @return number of writes made during the frame, which can be more than were stored
+	  */
+	std::size_t getRasterTrace(RasterWrite *dest, std::size_t size);
+
+	/**
+	  * Indices into the statistics filled in by getEventStats(). The EVENT_ ones count
+	  * CPU-level scheduler events, the EVENT_LCD_ ones count the LCD's internal events
+	  * (which are run by EVENT_VIDEO as well as by video register accesses).
+	  * EVENT_BLIT happens once per video frame.
+	  */
+	enum EventStat {
+		EVENT_UNHALT, EVENT_END, EVENT_BLIT, EVENT_SERIAL, EVENT_OAM, EVENT_DMA,
+		EVENT_TIMA, EVENT_VIDEO, EVENT_INTERRUPTS,
+		EVENT_LCD_LY, EVENT_LCD_STATIRQ, EVENT_LCD_UPDATEWY2, EVENT_LCD_M1IRQ,
+		EVENT_LCD_LYCIRQ, EVENT_LCD_SPRITEMAP, EVENT_LCD_HDMA, EVENT_LCD_M2IRQ,
+		EVENT_LCD_M0IRQ,
+		INSTRUCTIONS,      /**< CPU instructions executed. */
+		NUM_EVENTSTATS
+	};
+
+	/**
+	  * Get event counts since the last resetEventStats(). These are only gathered if
+	  * libgambatte is built with GAMBATTE_EVENT_STATS (scons eventstats=1),
+	  * otherwise they are all 0.
+	  *
+	  * @param dest length of at least NUM_EVENTSTATS, indexed by EventStat
+	  */
+	void getEventStats(unsigned long *dest);
+
+	/** Sets all event counts to 0. */
+	void resetEventStats();
+
 private:
 	struct Priv;
 	Priv *const p_;
@@ -0,0 +1,63 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef GAMBATTE_SOUNDLOG_H
+#define GAMBATTE_SOUNDLOG_H
+
+#include "gbint.h"
+#include <cstddef>
+
+namespace gambatte {
+
+/**
+  * Turns a sound log, as read with GB::readSoundLog, back into the audio of the run
+  * it was logged from. It holds its own sound hardware, independent of any GB, so it
+  * may be used on another thread than the GB, or long after it.
+  */
+class SoundLogRenderer {
+public:
+	SoundLogRenderer();
+	~SoundLogRenderer();
+
+	/**
+	  * Appends log bytes to render. The log may be split anywhere between calls.
+	  */
+	void write(char const *data, std::size_t size);
+
+	/**
+	  * Renders up to maxSamples (at least 2) stereo samples of the log written so far,
+	  * in the format of the GB::runFor audio buffer. Audio up to the end of the last
+	  * GB::runFor call logged is available. Anything logged before the first state
+	  * in the log (put there when logging starts) is skipped. Rendering stops at a
+	  * record that is not one GB::readSoundLog could have given.
+	  *
+	  * @return number of samples rendered
+	  */
+	std::size_t render(gambatte::uint_least32_t *audioBuf, std::size_t maxSamples);
+
+private:
+	struct Priv;
+	Priv *const p_;
+
+	SoundLogRenderer(SoundLogRenderer const &);
+	SoundLogRenderer & operator=(SoundLogRenderer const &);
+};
+
+}
+
+#endif
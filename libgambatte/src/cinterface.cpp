@@ -18,6 +18,7 @@
 
 #include "cinterface.h"
 #include "gambatte.h"
+#include "soundlog.h"
 
 namespace {
 
@@ -47,6 +48,46 @@ GBEXPORT int gambatte_runfor(GB *g, unsigned *videoBuf, int pitch, unsigned *aud
 	return g->runFor(videoBuf, pitch, audioBuf, *(std::size_t *)samples);
 }
 
+GBEXPORT void gambatte_setaudiooutputrate(GB *g, long rate) {
+	g->setAudioOutputRate(rate);
+}
+
+GBEXPORT unsigned gambatte_readaudio(GB *g, unsigned *dest, unsigned maxSamples) {
+	return g->readAudio(dest, maxSamples);
+}
+
+GBEXPORT void gambatte_setaudiostems(GB *g, unsigned short **stems, unsigned decimation) {
+	g->setAudioStems(stems, decimation);
+}
+
+GBEXPORT unsigned gambatte_audiostemsamples(GB *g) {
+	return g->audioStemSamples();
+}
+
+GBEXPORT void gambatte_setsoundlogging(GB *g, bool on) {
+	g->setSoundLogging(on);
+}
+
+GBEXPORT unsigned gambatte_readsoundlog(GB *g, char *dest, unsigned size) {
+	return g->readSoundLog(dest, size);
+}
+
+GBEXPORT SoundLogRenderer * gambatte_createsoundlogrenderer() {
+	return new SoundLogRenderer();
+}
+
+GBEXPORT void gambatte_destroysoundlogrenderer(SoundLogRenderer *r) {
+	delete r;
+}
+
+GBEXPORT void gambatte_writesoundlog(SoundLogRenderer *r, char const *data, unsigned size) {
+	r->write(data, size);
+}
+
+GBEXPORT unsigned gambatte_rendersoundlog(SoundLogRenderer *r, unsigned *audioBuf, unsigned maxSamples) {
+	return r->render(audioBuf, maxSamples);
+}
+
 GBEXPORT void gambatte_reset(GB *g, unsigned samplesToStall) {
 	g->reset(samplesToStall);
 }
@@ -55,6 +96,14 @@ GBEXPORT void gambatte_setinputgetter(GB *g, InputGetter *getInput, void *p) {
 	g->setInputGetter(getInput, p);
 }
 
+GBEXPORT void gambatte_setinputschedule(GB *g, unsigned char const *inputs, std::size_t n) {
+	g->setInputSchedule(inputs, n);
+}
+
+GBEXPORT int gambatte_runschedule(GB *g, unsigned *videoBuf, int pitch, unsigned *audioBuf, std::size_t *samples) {
+	return g->runSchedule(videoBuf, pitch, audioBuf, *samples);
+}
+
 GBEXPORT unsigned gambatte_savestate(GB *g, unsigned const *videoBuf, int pitch, char *stateBuf) {
 	return g->saveState(videoBuf, pitch, stateBuf);
 }
@@ -99,4 +148,62 @@ GBEXPORT void gambatte_setspeedupflags(GB *g, unsigned flags) {
 	g->setSpeedupFlags(flags);
 }
 
+GBEXPORT bool gambatte_renderlastframe(GB *g, unsigned *videoBuf, int pitch) {
+	return g->renderLastFrame(videoBuf, pitch);
+}
+
+GBEXPORT GB::VideoSnapshot * gambatte_newvideosnapshot() {
+	return new GB::VideoSnapshot();
+}
+
+GBEXPORT void gambatte_deletevideosnapshot(GB::VideoSnapshot *s) {
+	delete s;
+}
+
+GBEXPORT void gambatte_getvideosnapshot(GB *g, GB::VideoSnapshot *s) {
+	g->getVideoSnapshot(*s);
+}
+
+GBEXPORT void gambatte_drawtilesheet(GB::VideoSnapshot const *s, unsigned *dest, int pitch,
+		unsigned bank, unsigned palette) {
+	GB::drawTileSheet(*s, dest, pitch, bank, palette);
+}
+
+GBEXPORT void gambatte_drawtilemap(GB::VideoSnapshot const *s, unsigned *dest, int pitch,
+		unsigned map, bool outline) {
+	GB::drawTileMap(*s, dest, pitch, map, outline);
+}
+
+GBEXPORT void gambatte_drawsprites(GB::VideoSnapshot const *s, unsigned *dest, int pitch) {
+	GB::drawSprites(*s, dest, pitch);
+}
+
+GBEXPORT void gambatte_setrastertrace(GB *g, bool enable) {
+	g->setRasterTrace(enable);
+}
+
+GBEXPORT std::size_t gambatte_getrastertrace(GB *g, GB::RasterWrite *dest, std::size_t size) {
+	return g->getRasterTrace(dest, size);
+}
+
+GBEXPORT void gambatte_setvideoformat(GB *g, int format) {
+	g->setVideoFormat(static_cast<GB::VideoFormat>(format));
+}
+
+GBEXPORT void gambatte_setrenderwindow(GB *g, unsigned firstLine, unsigned lastLine) {
+	g->setRenderWindow(firstLine, lastLine);
+}
+
+GBEXPORT void gambatte_getindexedpalette(GB *g, unsigned *dest) {
+	g->getIndexedPalette(dest);
+}
+
+GBEXPORT void gambatte_geteventstats(GB *g, unsigned long *dest) {
+	g->getEventStats(dest);
+}
+
+GBEXPORT void gambatte_reseteventstats(GB *g) {
+	g->resetEventStats();
+}
+
 }
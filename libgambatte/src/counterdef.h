@@ -3,7 +3,14 @@
 
 namespace gambatte {
 
+#ifdef GAMBATTE_64BIT_CC
+// cycle counters are never rebased (see Memory::resetCounters).
+typedef unsigned long long cc_t;
+cc_t const disabled_time = ~0ull;
+#else
+typedef unsigned long cc_t;
 enum { disabled_time = 0xfffffffful };
+#endif
 
 }
 
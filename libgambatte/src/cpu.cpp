@@ -17,6 +17,7 @@
 //
 
 #include "cpu.h"
+#include "gambatte.h"
 #include "memory.h"
 #include "savestate.h"
 
@@ -42,15 +43,18 @@ CPU::CPU()
 , prefetched_(false)
 , numInterruptAddresses(0)
 {
+	resetEventStats();
 }
 
-long CPU::runFor(unsigned long const cycles) {
+long CPU::runFor(cc_t const cycles) {
 	process(cycles);
 
 	long const csb = mem_.cyclesSinceBlit(cycleCounter_);
 
+#ifndef GAMBATTE_64BIT_CC
 	if (cycleCounter_ & 0x80000000)
 		cycleCounter_ = mem_.resetCounters(cycleCounter_);
+#endif
 
 	return csb;
 }
@@ -497,10 +501,10 @@ void CPU::loadState(SaveState const &state) {
 
 namespace {
 
-unsigned long freeze(Memory &mem, unsigned long cc) {
+cc_t freeze(Memory &mem, cc_t cc) {
 	mem.freeze(cc);
 	if (cc < mem.nextEventTime()) {
-		unsigned long cycles = mem.nextEventTime() - cc;
+		cc_t cycles = mem.nextEventTime() - cc;
 		cc += cycles + (-cycles & 3);
 	}
 
@@ -509,21 +513,21 @@ unsigned long freeze(Memory &mem, unsigned long cc) {
 
 }
 
-void CPU::process(unsigned long const cycles) {
+void CPU::process(cc_t const cycles) {
 	mem_.setEndtime(cycleCounter_, cycles);
 	mem_.updateInput();
 
 	hitInterruptAddress = -1;
 
 	unsigned char a = a_;
-	unsigned long cycleCounter = cycleCounter_;
+	cc_t cycleCounter = cycleCounter_;
 
 	while (mem_.isActive()) {
 		unsigned short pc = pc_;
 
 		if (mem_.halted()) {
 			if (cycleCounter < mem_.nextEventTime()) {
-				unsigned long cycles = mem_.nextEventTime() - cycleCounter;
+				cc_t cycles = mem_.nextEventTime() - cycleCounter;
 				cycleCounter += cycles + (-cycles & 3);
 			}
 		} else while (cycleCounter < mem_.nextEventTime()) {
@@ -544,6 +548,10 @@ void CPU::process(unsigned long const cycles) {
 			if (hitInterruptAddress != -1)
 				break;
 
+#ifdef GAMBATTE_EVENT_STATS
+			++numInstructions_;
+#endif
+
 			if (!prefetched_) {
 				PC_READ(opcode);
 			} else {
@@ -632,7 +640,7 @@ void CPU::process(unsigned long const cycles) {
 				PC_READ(opcode_);
 				cycleCounter = mem_.stop(cycleCounter - 4, prefetched_);
 				if (cycleCounter < mem_.nextEventTime()) {
-					unsigned long cycles = mem_.nextEventTime() - cycleCounter;
+					cc_t cycles = mem_.nextEventTime() - cycleCounter;
 					cycleCounter += cycles + (-cycles & 3);
 				}
 
@@ -1042,7 +1050,7 @@ void CPU::process(unsigned long const cycles) {
 					prefetched_ = mem_.halt(cycleCounter);
 					cycleCounter += 4 + 4 * !mem_.isCgb();
 					if (cycleCounter < mem_.nextEventTime()) {
-						unsigned long cycles = mem_.nextEventTime() - cycleCounter;
+						cc_t cycles = mem_.nextEventTime() - cycleCounter;
 						cycleCounter += cycles + (-cycles & 3);
 					}
 				}
@@ -2070,4 +2078,20 @@ int CPU::getHitInterruptAddress() {
 	return hitInterruptAddress;
 }
 
+void CPU::getEventStats(unsigned long *dest) const {
+	mem_.getEventStats(dest);
+#ifdef GAMBATTE_EVENT_STATS
+	dest[GB::INSTRUCTIONS] = numInstructions_;
+#else
+	dest[GB::INSTRUCTIONS] = 0;
+#endif
+}
+
+void CPU::resetEventStats() {
+	mem_.resetEventStats();
+#ifdef GAMBATTE_EVENT_STATS
+	numInstructions_ = 0;
+#endif
+}
+
 }
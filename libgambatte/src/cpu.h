@@ -26,7 +26,7 @@ namespace gambatte {
 class CPU {
 public:
 	CPU();
-	long runFor(unsigned long cycles);
+	long runFor(cc_t cycles);
 	void setStatePtrs(SaveState &state);
 	void saveState(SaveState &state);
 	void loadState(SaveState const &state);
@@ -41,6 +41,12 @@ public:
 		mem_.setInputGetter(getInput, p);
 	}
 
+	void setInputSchedule(unsigned char const *inputs, std::size_t n) {
+		mem_.setInputSchedule(inputs, n);
+	}
+
+	void setRunThroughSchedule(bool on) { mem_.setRunThroughSchedule(on); }
+
 	void setSaveDir(std::string const &sdir) {
 		mem_.setSaveDir(sdir);
 	}
@@ -62,7 +68,17 @@ public:
 	PakInfo const pakInfo(bool multicartCompat) const { return mem_.pakInfo(multicartCompat); }
 	void setSoundBuffer(uint_least32_t *buf) { mem_.setSoundBuffer(buf); }
 	std::size_t fillSoundBuffer() { return mem_.fillSoundBuffer(cycleCounter_); }
-	void stall(unsigned long cycles) { mem_.stall(cycleCounter_, cycles); }
+	void setAudioOutputRate(long rate) { mem_.setAudioOutputRate(rate); }
+	std::size_t readAudio(uint_least32_t *dest, std::size_t maxSamples) {
+		return mem_.readAudio(dest, maxSamples);
+	}
+	void setAudioStems(uint_least16_t *const *stems, unsigned decimation) {
+		mem_.setAudioStems(stems, decimation);
+	}
+	std::size_t audioStemSamples() const { return mem_.audioStemSamples(); }
+	void setSoundLogging(bool on) { mem_.setSoundLogging(on, cycleCounter_); }
+	std::size_t readSoundLog(char *dest, std::size_t size) { return mem_.readSoundLog(dest, size); }
+	void stall(cc_t cycles) { mem_.stall(cycleCounter_, cycles); }
 	bool isCgb() const { return mem_.isCgb(); }
 
 	void setDmgPaletteColor(int palNum, int colorNum, unsigned long rgb32) {
@@ -70,6 +86,9 @@ public:
 	}
 
 	void setTrueColors(bool trueColors) { mem_.setTrueColors(trueColors); }
+	void setVideoFormat(GB::VideoFormat format) { mem_.setVideoFormat(format); }
+	void setRenderWindow(unsigned firstLine, unsigned lastLine) { mem_.setRenderWindow(firstLine, lastLine); }
+	void getIndexedPalette(uint_least32_t *dest) const { mem_.getIndexedPalette(dest); }
 	void setTimeMode(bool useCycles) { mem_.setTimeMode(useCycles, cycleCounter_); }
 
 	void setGameGenie(std::string const &codes) { mem_.setGameGenie(codes); }
@@ -91,15 +110,29 @@ public:
 
 	unsigned timeNow() const { return mem_.timeNow(cycleCounter_); }
 
-	unsigned long getCycleCounter() { return cycleCounter_; }
-	unsigned long getDivLastUpdate() { return mem_.getDivLastUpdate(); }
+	cc_t getCycleCounter() { return cycleCounter_; }
+	cc_t getDivLastUpdate() { return mem_.getDivLastUpdate(); }
 	unsigned char getRawIOAMHRAM(int offset) { return mem_.getRawIOAMHRAM(offset); }
 
 	void setSpeedupFlags(unsigned flags) { mem_.setSpeedupFlags(flags); }
 
+	bool renderLastFrame(uint_least32_t *videoBuf, std::ptrdiff_t pitch) {
+		return mem_.renderLastFrame(videoBuf, pitch);
+	}
+
+	void getVideoSnapshot(GB::VideoSnapshot &dest) const { mem_.getVideoSnapshot(dest); }
+	void setRasterTrace(bool enable) { mem_.setRasterTrace(enable); }
+
+	std::size_t getRasterTrace(GB::RasterWrite *dest, std::size_t size) const {
+		return mem_.getRasterTrace(dest, size);
+	}
+
+	void getEventStats(unsigned long *dest) const;
+	void resetEventStats();
+
 private:
 	Memory mem_;
-	unsigned long cycleCounter_;
+	cc_t cycleCounter_;
 	unsigned short pc_;
 	unsigned short sp;
 	unsigned hf1, hf2, zf, cf;
@@ -110,8 +143,11 @@ private:
 	int *interruptAddresses;
 	int numInterruptAddresses;
 	int hitInterruptAddress;
+#ifdef GAMBATTE_EVENT_STATS
+	unsigned long numInstructions_;
+#endif
 
-	void process(unsigned long cycles);
+	void process(cc_t cycles);
 };
 
 }
@@ -23,7 +23,9 @@
 #include "state_osd_elements.h"
 #include "statesaver.h"
 #include "file/file.h"
+#include "video/vram_viewer.h"
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <zlib.h>
@@ -86,6 +88,59 @@ std::ptrdiff_t GB::runFor(gambatte::uint_least32_t *const videoBuf, std::ptrdiff
 	     : cyclesSinceBlit;
 }
 
+std::ptrdiff_t GB::runSchedule(gambatte::uint_least32_t *const videoBuf, std::ptrdiff_t const pitch,
+                               gambatte::uint_least32_t *const soundBuf, std::size_t &samples) {
+	if (!p_->cpu.loaded()) {
+		samples = 0;
+		return -1;
+	}
+
+	// a few frames at a time, so that runFor keeps its cycle counts small and rebases
+	// the counters between chunks like it does between calls.
+	std::size_t const chunk_samples = 8 * 35112;
+	std::size_t const total = samples;
+	std::ptrdiff_t frameSample = -1;
+	samples = 0;
+	p_->cpu.setRunThroughSchedule(true);
+
+	while (samples < total && frameSample < 0) {
+		std::size_t n = std::min(total - samples, chunk_samples);
+		std::ptrdiff_t const chunkFrameSample =
+			runFor(videoBuf, pitch, soundBuf ? soundBuf + samples : 0, n);
+		if (chunkFrameSample >= 0)
+			frameSample = samples + chunkFrameSample;
+
+		samples += n;
+	}
+
+	p_->cpu.setRunThroughSchedule(false);
+	return frameSample;
+}
+
+void GB::setAudioOutputRate(long rate) {
+	p_->cpu.setAudioOutputRate(rate);
+}
+
+std::size_t GB::readAudio(gambatte::uint_least32_t *dest, std::size_t maxSamples) {
+	return p_->cpu.readAudio(dest, maxSamples);
+}
+
+void GB::setAudioStems(gambatte::uint_least16_t *const *stems, unsigned decimation) {
+	p_->cpu.setAudioStems(stems, decimation);
+}
+
+std::size_t GB::audioStemSamples() const {
+	return p_->cpu.audioStemSamples();
+}
+
+void GB::setSoundLogging(bool on) {
+	p_->cpu.setSoundLogging(on);
+}
+
+std::size_t GB::readSoundLog(char *dest, std::size_t size) {
+	return p_->cpu.readSoundLog(dest, size);
+}
+
 void GB::reset(std::size_t samplesToStall, std::string const &build) {
 	if (p_->cpu.loaded()) {
 		if (p_->implicitSave())
@@ -109,6 +164,10 @@ void GB::setInputGetter(InputGetter *getInput, void *p) {
 	p_->cpu.setInputGetter(getInput, p);
 }
 
+void GB::setInputSchedule(unsigned char const *inputs, std::size_t n) {
+	p_->cpu.setInputSchedule(inputs, n);
+}
+
 void GB::setSaveDir(std::string const &sdir) {
 	p_->cpu.setSaveDir(sdir);
 }
@@ -186,6 +245,18 @@ void GB::setTrueColors(bool trueColors) {
 	p_->cpu.setTrueColors(trueColors);
 }
 
+void GB::setVideoFormat(VideoFormat format) {
+	p_->cpu.setVideoFormat(format);
+}
+
+void GB::setRenderWindow(unsigned firstLine, unsigned lastLine) {
+	p_->cpu.setRenderWindow(firstLine, lastLine);
+}
+
+void GB::getIndexedPalette(gambatte::uint_least32_t *dest) {
+	p_->cpu.getIndexedPalette(dest);
+}
+
 void GB::setTimeMode(bool useCycles) {
 	p_->cpu.setTimeMode(useCycles);
 }
@@ -338,3 +409,41 @@ int GB::getDivState() {
 void GB::setSpeedupFlags(unsigned flags) {
 	p_->cpu.setSpeedupFlags(flags);
 }
+
+bool GB::renderLastFrame(gambatte::uint_least32_t *videoBuf, std::ptrdiff_t pitch) {
+	return p_->cpu.renderLastFrame(videoBuf, pitch);
+}
+
+void GB::getVideoSnapshot(VideoSnapshot &dest) {
+	p_->cpu.getVideoSnapshot(dest);
+}
+
+void GB::drawTileSheet(VideoSnapshot const &snapshot, gambatte::uint_least32_t *dest,
+		std::ptrdiff_t pitch, unsigned bank, unsigned palette) {
+	gambatte::drawTileSheet(snapshot, dest, pitch, bank, palette);
+}
+
+void GB::drawTileMap(VideoSnapshot const &snapshot, gambatte::uint_least32_t *dest,
+		std::ptrdiff_t pitch, unsigned map, bool outline) {
+	gambatte::drawTileMap(snapshot, dest, pitch, map, outline);
+}
+
+void GB::drawSprites(VideoSnapshot const &snapshot, gambatte::uint_least32_t *dest, std::ptrdiff_t pitch) {
+	gambatte::drawSprites(snapshot, dest, pitch);
+}
+
+void GB::setRasterTrace(bool enable) {
+	p_->cpu.setRasterTrace(enable);
+}
+
+std::size_t GB::getRasterTrace(RasterWrite *dest, std::size_t size) {
+	return p_->cpu.getRasterTrace(dest, size);
+}
+
+void GB::getEventStats(unsigned long *dest) {
+	p_->cpu.getEventStats(dest);
+}
+
+void GB::resetEventStats() {
+	p_->cpu.resetEventStats();
+}
@@ -1170,7 +1170,7 @@ void gambatte::setInitState(SaveState &state, bool const cgb, bool const sgb) {
 		0x83, 0x40, 0x0B, 0x77
 	};
 
-	unsigned long cc = state.cpu.cycleCounter;
+	cc_t cc = state.cpu.cycleCounter;
 
 	state.cpu.cycleCounter = 8;
 	state.cpu.pc = 0;
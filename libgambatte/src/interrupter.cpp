@@ -29,7 +29,7 @@ Interrupter::Interrupter(unsigned short &sp, unsigned short &pc, unsigned char &
 {
 }
 
-void Interrupter::prefetch(unsigned long cc, Memory &mem) {
+void Interrupter::prefetch(cc_t cc, Memory &mem) {
 	if (!prefetched_) {
 		opcode_ = mem.read(pc_, cc);
 		pc_ = (pc_ + 1) & 0xFFFF;
@@ -37,7 +37,7 @@ void Interrupter::prefetch(unsigned long cc, Memory &mem) {
 	}
 }
 
-unsigned long Interrupter::interrupt(unsigned long cc, Memory &memory) {
+cc_t Interrupter::interrupt(cc_t cc, Memory &memory) {
 	// undo prefetch (presumably unconditional on hw).
 	if (prefetched_) {
 		pc_ = (pc_ - 1) & 0xFFFF;
@@ -92,7 +92,7 @@ void Interrupter::setGameShark(std::string const &codes) {
 	}
 }
 
-void Interrupter::applyVblankCheats(unsigned long const cc, Memory &memory) {
+void Interrupter::applyVblankCheats(cc_t const cc, Memory &memory) {
 	for (std::size_t i = 0, size = gsCodes_.size(); i < size; ++i) {
 		if (gsCodes_[i].type == 0x01)
 			memory.write(gsCodes_[i].address, gsCodes_[i].value, cc);
@@ -19,6 +19,7 @@
 #ifndef INTERRUPTER_H
 #define INTERRUPTER_H
 
+#include "counterdef.h"
 #include <string>
 #include <vector>
 
@@ -35,8 +36,8 @@ class Memory;
 class Interrupter {
 public:
 	Interrupter(unsigned short &sp, unsigned short &pc, unsigned char &opcode, bool &prefetched);
-	void prefetch(unsigned long cc, Memory &mem);
-	unsigned long interrupt(unsigned long cycleCounter, Memory &memory);
+	void prefetch(cc_t cc, Memory &mem);
+	cc_t interrupt(cc_t cycleCounter, Memory &memory);
 	void setGameShark(std::string const &codes);
 
 private:
@@ -46,7 +47,7 @@ private:
 	bool &prefetched_;
 	std::vector<GsCode> gsCodes_;
 
-	void applyVblankCheats(unsigned long cc, Memory &mem);
+	void applyVblankCheats(cc_t cc, Memory &mem);
 };
 
 }
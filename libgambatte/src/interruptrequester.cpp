@@ -43,17 +43,17 @@ void InterruptRequester::loadState(SaveState const &state) {
 
 	eventTimes_.setValue<intevent_interrupts>(intFlags_.imeOrHalted() && pendingIrqs()
 		? minIntTime_
-		: static_cast<unsigned long>(disabled_time));
+		: static_cast<cc_t>(disabled_time));
 }
 
-void InterruptRequester::resetCc(unsigned long oldCc, unsigned long newCc) {
+void InterruptRequester::resetCc(cc_t oldCc, cc_t newCc) {
 	minIntTime_ = minIntTime_ < oldCc ? 0 : minIntTime_ - (oldCc - newCc);
 
 	if (eventTimes_.value(intevent_interrupts) != disabled_time)
 		eventTimes_.setValue<intevent_interrupts>(minIntTime_);
 }
 
-void InterruptRequester::ei(unsigned long cc) {
+void InterruptRequester::ei(cc_t cc) {
 	intFlags_.setIme();
 	minIntTime_ = cc + 1;
 
@@ -89,7 +89,7 @@ void InterruptRequester::flagIrq(unsigned bit) {
 		eventTimes_.setValue<intevent_interrupts>(minIntTime_);
 }
 
-void InterruptRequester::flagIrq(unsigned bit, unsigned long cc) {
+void InterruptRequester::flagIrq(unsigned bit, cc_t cc) {
 	unsigned const prevPending = pendingIrqs();
 	ifreg_ |= bit;
 
@@ -105,7 +105,7 @@ void InterruptRequester::setIereg(unsigned iereg) {
 	if (intFlags_.imeOrHalted()) {
 		eventTimes_.setValue<intevent_interrupts>(pendingIrqs()
 			? minIntTime_
-			: static_cast<unsigned long>(disabled_time));
+			: static_cast<cc_t>(disabled_time));
 	}
 }
 
@@ -115,11 +115,11 @@ void InterruptRequester::setIfreg(unsigned ifreg) {
 	if (intFlags_.imeOrHalted()) {
 		eventTimes_.setValue<intevent_interrupts>(pendingIrqs()
 			? minIntTime_
-			: static_cast<unsigned long>(disabled_time));
+			: static_cast<cc_t>(disabled_time));
 	}
 }
 
-void InterruptRequester::setMinIntTime(unsigned long cc) {
+void InterruptRequester::setMinIntTime(cc_t cc) {
 	minIntTime_ = cc;
 
 	if (eventTimes_.value(intevent_interrupts) < minIntTime_)
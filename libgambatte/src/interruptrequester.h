@@ -41,27 +41,27 @@ public:
 	InterruptRequester();
 	void saveState(SaveState &) const;
 	void loadState(SaveState const &);
-	void resetCc(unsigned long oldCc, unsigned long newCc);
+	void resetCc(cc_t oldCc, cc_t newCc);
 	unsigned ifreg() const { return ifreg_; }
 	unsigned pendingIrqs() const { return ifreg_ & iereg_; }
 	bool ime() const { return intFlags_.ime(); }
 	bool halted() const { return intFlags_.halted(); }
-	void ei(unsigned long cc);
+	void ei(cc_t cc);
 	void di();
 	void halt();
 	void unhalt();
 	void flagIrq(unsigned bit);
-	void flagIrq(unsigned bit, unsigned long cc);
+	void flagIrq(unsigned bit, cc_t cc);
 	void ackIrq(unsigned bit) { ifreg_ &= ~bit; }
 	void setIereg(unsigned iereg);
 	void setIfreg(unsigned ifreg);
-	void setMinIntTime(unsigned long cc);
+	void setMinIntTime(cc_t cc);
 
 	IntEventId minEventId() const { return static_cast<IntEventId>(eventTimes_.min()); }
-	unsigned long minEventTime() const { return eventTimes_.minValue(); }
-	template<IntEventId id> void setEventTime(unsigned long value) { eventTimes_.setValue<id>(value); }
-	void setEventTime(IntEventId id, unsigned long value) { eventTimes_.setValue(id, value); }
-	unsigned long eventTime(IntEventId id) const { return eventTimes_.value(id); }
+	cc_t minEventTime() const { return eventTimes_.minValue(); }
+	template<IntEventId id> void setEventTime(cc_t value) { eventTimes_.setValue<id>(value); }
+	void setEventTime(IntEventId id, cc_t value) { eventTimes_.setValue(id, value); }
+	cc_t eventTime(IntEventId id) const { return eventTimes_.value(id); }
 
 private:
 	class IntFlags {
@@ -82,7 +82,7 @@ private:
 	};
 
 	MinKeeper<intevent_last + 1> eventTimes_;
-	unsigned long minIntTime_;
+	cc_t minIntTime_;
 	unsigned ifreg_;
 	unsigned iereg_;
 	IntFlags intFlags_;
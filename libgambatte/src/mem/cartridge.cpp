@@ -57,7 +57,7 @@ public:
 		return !enableRam_;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const /*cc*/) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const /*cc*/) {
 		if (p < 0x2000) {
 			enableRam_ = (data & 0xF) == 0xA;
 			memptrs_.setRambank(enableRam_ ? MemPtrs::read_en | MemPtrs::write_en : MemPtrs::disabled, 0);
@@ -105,7 +105,7 @@ public:
 		return !enableRam_;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const /*cc*/) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const /*cc*/) {
 		switch (p >> 13 & 3) {
 		case 0:
 			enableRam_ = (data & 0xF) == 0xA;
@@ -183,7 +183,7 @@ public:
 		return !enableRam_;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const /*cc*/) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const /*cc*/) {
 		switch (p >> 13 & 3) {
 		case 0:
 			enableRam_ = (data & 0xF) == 0xA;
@@ -261,7 +261,7 @@ public:
 		return !enableRam_;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const /*cc*/) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const /*cc*/) {
 		switch (p & 0x6100) {
 		case 0x0000:
 			enableRam_ = (data & 0xF) == 0xA;
@@ -312,7 +312,7 @@ public:
 		return !enableRam_;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const cc) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const cc) {
 		switch (p >> 13 & 3) {
 		case 0:
 			enableRam_ = (data & 0xF) == 0xA;
@@ -397,7 +397,7 @@ public:
 		return false;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const /*cc*/) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const /*cc*/) {
 		switch (p >> 13 & 3) {
 		case 0:
 			enableRam_ = (data & 0xF) == 0xA;
@@ -472,7 +472,7 @@ public:
 		return false;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const /*cc*/) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const /*cc*/) {
 		switch (p >> 13 & 3) {
 		case 0:
 			ramflag_ = data;
@@ -559,7 +559,7 @@ public:
 		return !enableRam_;
 	}
 
-	virtual void romWrite(unsigned const p, unsigned const data, unsigned long const /*cc*/) {
+	virtual void romWrite(unsigned const p, unsigned const data, cc_t const /*cc*/) {
 		switch (p >> 13 & 3) {
 		case 0:
 			enableRam_ = (data & 0xF) == 0xA;
@@ -694,7 +694,7 @@ void Cartridge::setStatePtrs(SaveState &state) {
 	state.mem.wram.set(memptrs_.wramdata(0), memptrs_.wramdataend() - memptrs_.wramdata(0));
 }
 
-void Cartridge::saveState(SaveState &state, unsigned long const cc) {
+void Cartridge::saveState(SaveState &state, cc_t const cc) {
 	mbc_->saveState(state.mem);
 	time_.saveState(state, cc);
 	rtc_.saveState(state);
@@ -852,7 +852,7 @@ LoadRes Cartridge::loadROM(std::string const &romfile,
 	return LOADRES_OK;
 }
 
-void Cartridge::loadSavedata(unsigned long const cc) {
+void Cartridge::loadSavedata(cc_t const cc) {
 	std::string const &sbp = saveBasePath();
 
 	if (hasBattery(memptrs_.romdata()[0x147])) {
@@ -887,7 +887,7 @@ void Cartridge::loadSavedata(unsigned long const cc) {
 	}
 }
 
-void Cartridge::saveSavedata(unsigned long const cc) {
+void Cartridge::saveSavedata(cc_t const cc) {
 	std::string const &sbp = saveBasePath();
 
 	if (hasBattery(memptrs_.romdata()[0x147])) {
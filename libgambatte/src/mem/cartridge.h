@@ -37,7 +37,7 @@ public:
 	virtual ~Mbc() {}
 	virtual unsigned char curRomBank() const = 0;
 	virtual bool disabledRam() const = 0;
-	virtual void romWrite(unsigned P, unsigned data, unsigned long cycleCounter) = 0;
+	virtual void romWrite(unsigned P, unsigned data, cc_t cycleCounter) = 0;
 	virtual void saveState(SaveState::Mem &ss) const = 0;
 	virtual void loadState(SaveState::Mem const &ss) = 0;
 	virtual bool isAddressWithinAreaRombankCanBeMappedTo(unsigned address, unsigned rombank) const = 0;
@@ -47,7 +47,7 @@ class Cartridge {
 public:
 	Cartridge();
 	void setStatePtrs(SaveState &);
-	void saveState(SaveState &, unsigned long cycleCounter);
+	void saveState(SaveState &, cc_t cycleCounter);
 	void loadState(SaveState const &);
 	bool loaded() const { return mbc_.get(); }
 	unsigned char const * rmem(unsigned area) const { return memptrs_.rmem(area); }
@@ -66,16 +66,16 @@ public:
 	void setOamDmaSrc(OamDmaSrc oamDmaSrc) { memptrs_.setOamDmaSrc(oamDmaSrc); }
 	unsigned char curRomBank() const { return mbc_->curRomBank(); }
 	bool disabledRam() const { return mbc_->disabledRam(); }
-	void mbcWrite(unsigned addr, unsigned data, unsigned long const cc) { mbc_->romWrite(addr, data, cc); }
+	void mbcWrite(unsigned addr, unsigned data, cc_t const cc) { mbc_->romWrite(addr, data, cc); }
 	bool isCgb() const { return gambatte::isCgb(memptrs_); }
-	void resetCc(unsigned long const oldCc, unsigned long const newCc) { time_.resetCc(oldCc, newCc); }
-	void speedChange(unsigned long const cc) { time_.speedChange(cc); }
-	void setTimeMode(bool useCycles, unsigned long const cc) { time_.setTimeMode(useCycles, cc); }
-	unsigned timeNow(unsigned long const cc) const { return time_.timeNow(cc); }
-	void rtcWrite(unsigned data, unsigned long const cc) { rtc_.write(data, cc); }
+	void resetCc(cc_t const oldCc, cc_t const newCc) { time_.resetCc(oldCc, newCc); }
+	void speedChange(cc_t const cc) { time_.speedChange(cc); }
+	void setTimeMode(bool useCycles, cc_t const cc) { time_.setTimeMode(useCycles, cc); }
+	unsigned timeNow(cc_t const cc) const { return time_.timeNow(cc); }
+	void rtcWrite(unsigned data, cc_t const cc) { rtc_.write(data, cc); }
 	unsigned char rtcRead() const { return *rtc_.activeData(); }
-	void loadSavedata(unsigned long cycleCounter);
-	void saveSavedata(unsigned long cycleCounter);
+	void loadSavedata(cc_t cycleCounter);
+	void saveSavedata(cc_t cycleCounter);
 	std::string const saveBasePath() const;
 	void setSaveDir(std::string const &dir);
 	LoadRes loadROM(std::string const &romfile, bool cgbMode, bool multicartCompat);
@@ -83,8 +83,8 @@ public:
 	class PakInfo const pakInfo(bool multicartCompat) const;
 	void setGameGenie(std::string const &codes);
 	bool isHuC3() const { return huc3_.isHuC3(); }
-	unsigned char HuC3Read(unsigned p, unsigned long const cc) { return huc3_.read(p, cc); }
-	void HuC3Write(unsigned p, unsigned data, unsigned long const cc) { huc3_.write(p, data, cc); }
+	unsigned char HuC3Read(unsigned p, cc_t const cc) { return huc3_.read(p, cc); }
+	void HuC3Write(unsigned p, unsigned data, cc_t const cc) { huc3_.write(p, data, cc); }
 
 private:
 	struct AddrData {
@@ -39,7 +39,7 @@ HuC3Chip::HuC3Chip(Time &time)
 {
 }
 
-void HuC3Chip::doLatch(unsigned long const cc) {
+void HuC3Chip::doLatch(cc_t const cc) {
 	std::time_t tmp = time(cc);
     
 	unsigned minute = (tmp / 60) % 1440;
@@ -71,7 +71,7 @@ void HuC3Chip::loadState(SaveState const &state) {
 	irReceivingPulse_ = state.huc3.irReceivingPulse;
 }
 
-unsigned char HuC3Chip::read(unsigned /*p*/, unsigned long const cc) {
+unsigned char HuC3Chip::read(unsigned /*p*/, cc_t const cc) {
 	// should only reach here with ramflag = 0B-0E
 	if(ramflag_ == 0x0E) {
 		// INFRARED
@@ -119,7 +119,7 @@ unsigned char HuC3Chip::read(unsigned /*p*/, unsigned long const cc) {
 	else return ramValue_;
 }
 
-void HuC3Chip::write(unsigned /*p*/, unsigned data, unsigned long const cc) {
+void HuC3Chip::write(unsigned /*p*/, unsigned data, cc_t const cc) {
 	// as above
 	if(ramflag_ == 0x0B) {
 		// command
@@ -177,7 +177,7 @@ void HuC3Chip::write(unsigned /*p*/, unsigned data, unsigned long const cc) {
 	// do nothing for 0C/0D yet
 }
 
-void HuC3Chip::updateTime(unsigned long const cc) {
+void HuC3Chip::updateTime(cc_t const cc) {
 	unsigned minute = (writingTime_ & 0xFFF) % 1440;
 	unsigned day = (writingTime_ & 0xFFF000) >> 12;
 	std::time_t seconds = minute*60 + day*86400;
@@ -45,8 +45,8 @@ public:
 		enabled_ = enabled;
 	}
     
-	unsigned char read(unsigned p, unsigned long const cc);
-	void write(unsigned p, unsigned data, unsigned long cycleCounter);
+	unsigned char read(unsigned p, cc_t const cc);
+	void write(unsigned p, unsigned data, cc_t cycleCounter);
 
 private:
 	Time &time_;
@@ -57,16 +57,16 @@ private:
 	unsigned char shift_;
 	unsigned char ramflag_;
 	unsigned char modeflag_;
-	unsigned long irBaseCycle_;
+	cc_t irBaseCycle_;
 	bool enabled_;
 	bool lastLatchData_;
 	bool halted_;
 	bool irReceivingPulse_;
 
-	void doLatch(unsigned long cycleCounter);
-	void updateTime(unsigned long cycleCounter);
+	void doLatch(cc_t cycleCounter);
+	void updateTime(cc_t cycleCounter);
 
-	std::time_t time(unsigned long const cc) {
+	std::time_t time(cc_t const cc) {
 		return halted_ ? haltTime_ : time_.get(cc);
 	}
 };
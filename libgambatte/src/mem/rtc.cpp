@@ -37,7 +37,7 @@ Rtc::Rtc(Time &time)
 {
 }
 
-void Rtc::doLatch(unsigned long const cc) {
+void Rtc::doLatch(cc_t const cc) {
 	std::time_t tmp = time(cc);
 
 	if (tmp >= 0x200 * 86400) {
@@ -109,7 +109,7 @@ void Rtc::loadState(SaveState const &state) {
 	doSwapActive();
 }
 
-void Rtc::setDh(unsigned const newDh, unsigned const long cc) {
+void Rtc::setDh(unsigned const newDh, cc_t const cc) {
 	std::time_t seconds = time(cc);
 	std::time_t const oldHighdays = (seconds / 86400) & 0x100;
 	seconds -= oldHighdays * 86400;
@@ -124,7 +124,7 @@ void Rtc::setDh(unsigned const newDh, unsigned const long cc) {
 	}
 }
 
-void Rtc::setDl(unsigned const newLowdays, unsigned const long cc) {
+void Rtc::setDl(unsigned const newLowdays, cc_t const cc) {
 	std::time_t seconds = time(cc);
 	std::time_t const oldLowdays = (seconds / 86400) & 0xFF;
 	seconds -= oldLowdays * 86400;
@@ -132,7 +132,7 @@ void Rtc::setDl(unsigned const newLowdays, unsigned const long cc) {
 	time_.set(seconds, cc);
 }
 
-void Rtc::setH(unsigned const newHours, unsigned const long cc) {
+void Rtc::setH(unsigned const newHours, cc_t const cc) {
 	std::time_t seconds = time(cc);
 	std::time_t const oldHours = (seconds / 3600) % 24;
 	seconds -= oldHours * 3600;
@@ -140,7 +140,7 @@ void Rtc::setH(unsigned const newHours, unsigned const long cc) {
 	time_.set(seconds, cc);
 }
 
-void Rtc::setM(unsigned const newMinutes, unsigned const long cc) {
+void Rtc::setM(unsigned const newMinutes, cc_t const cc) {
 	std::time_t seconds = time(cc);
 	std::time_t const oldMinutes = (seconds / 60) % 60;
 	seconds -= oldMinutes * 60;
@@ -148,7 +148,7 @@ void Rtc::setM(unsigned const newMinutes, unsigned const long cc) {
 	time_.set(seconds, cc);
 }
 
-void Rtc::setS(unsigned const newSeconds, unsigned const long cc) {
+void Rtc::setS(unsigned const newSeconds, cc_t const cc) {
 	std::time_t seconds = time(cc);
 	seconds -= seconds % 60;
 	seconds += newSeconds;
@@ -30,7 +30,7 @@ public:
 	Rtc(Time &time);
 	unsigned char const * activeData() const { return activeData_; }
 
-	void latch(unsigned data, unsigned long const cc) {
+	void latch(unsigned data, cc_t const cc) {
 		if (!lastLatchData_ && data == 1)
 			doLatch(cc);
 
@@ -49,7 +49,7 @@ public:
 		doSwapActive();
 	}
 
-	void write(unsigned data, unsigned long const cc) {
+	void write(unsigned data, cc_t const cc) {
 		(this->*activeSet_)(data, cc);
 		*activeData_ = data;
 	}
@@ -57,7 +57,7 @@ public:
 private:
 	Time &time_;
 	unsigned char *activeData_;
-	void (Rtc::*activeSet_)(unsigned, unsigned long);
+	void (Rtc::*activeSet_)(unsigned, cc_t);
 	std::time_t haltTime_;
 	unsigned char index_;
 	unsigned char dataDh_;
@@ -68,15 +68,15 @@ private:
 	bool enabled_;
 	bool lastLatchData_;
 
-	void doLatch(unsigned long cycleCounter);
+	void doLatch(cc_t cycleCounter);
 	void doSwapActive();
-	void setDh(unsigned newDh, unsigned long cycleCounter);
-	void setDl(unsigned newLowdays, unsigned long cycleCounter);
-	void setH(unsigned newHours, unsigned long cycleCounter);
-	void setM(unsigned newMinutes, unsigned long cycleCounter);
-	void setS(unsigned newSeconds, unsigned long cycleCounter);
+	void setDh(unsigned newDh, cc_t cycleCounter);
+	void setDl(unsigned newLowdays, cc_t cycleCounter);
+	void setH(unsigned newHours, cc_t cycleCounter);
+	void setM(unsigned newMinutes, cc_t cycleCounter);
+	void setS(unsigned newSeconds, cc_t cycleCounter);
 
-	std::time_t time(unsigned long const cc) {
+	std::time_t time(cc_t const cc) {
 		return dataDh_ & 0x40 ? haltTime_ : time_.get(cc);
 	}
 };
@@ -18,6 +18,7 @@
 
 #include "sgb.h"
 #include "../savestate.h"
+#include "../video/video_format.h"
 #include <cstring>
 
 namespace gambatte {
@@ -38,6 +39,7 @@ static unsigned long gbcToRgb32(unsigned const bgr15, bool trueColor) {
 
 Sgb::Sgb()
 : transfer(0xFF)
+, videoFormat_(GB::RGB32)
 , pending(0xFF)
 {
 }
@@ -81,22 +83,59 @@ void Sgb::onJoypad(unsigned data) {
 
 void Sgb::updateScreen() {
 	unsigned char frame[160 * 144];
-	
-	for (int j = 0; j < 144; j++) {
-		for (int i = 0; i < 160; i++)
-			frame[j * 160 + i] = 3 - (videoBuf_[j * pitch_ + i] >> 4 & 3);
-	}
+	readScreen(frame, videoBuf_, pitch_);
 
 	if (pending != 0xFF && --pendingCount == 0)
 		onTransfer(frame);
 
+	drawScreen(frame, videoBuf_, pitch_);
+}
+
+void Sgb::refreshScreen(uint_least32_t *const videoBuf, std::ptrdiff_t const pitch) const {
+	unsigned char frame[160 * 144];
+	readScreen(frame, videoBuf, pitch);
+	drawScreen(frame, videoBuf, pitch);
+}
+
+void Sgb::readScreen(unsigned char *const frame, uint_least32_t const *const videoBuf, std::ptrdiff_t const pitch) const {
+	unsigned char const *const buf8 = reinterpret_cast<unsigned char const *>(videoBuf);
+	uint_least16_t const *const buf16 = reinterpret_cast<uint_least16_t const *>(videoBuf);
+
+	// recover the DMG shades from the (grey) frame drawn by the LCD
+	for (int j = 0; j < 144; j++) {
+		for (int i = 0; i < 160; i++) {
+			std::ptrdiff_t const pos = j * pitch + i;
+			switch (videoFormat_) {
+			case GB::INDEXED8: frame[j * 160 + i] = buf8[pos] & 3; break;
+			case GB::RGB565: frame[j * 160 + i] = 3 - (buf16[pos] >>  1 & 3); break;
+			case GB::BGR555: frame[j * 160 + i] = 3 - (buf16[pos] >> 11 & 3); break;
+			default: frame[j * 160 + i] = 3 - (videoBuf[pos] >> 4 & 3); break;
+			}
+		}
+	}
+}
+
+void Sgb::drawScreen(unsigned char *const frame, uint_least32_t *const videoBuf, std::ptrdiff_t const pitch) const {
+	unsigned char *const buf8 = reinterpret_cast<unsigned char *>(videoBuf);
+	uint_least16_t *const buf16 = reinterpret_cast<uint_least16_t *>(videoBuf);
+
 	if (mask != 0)
-		std::memset(frame, 0, sizeof frame);
+		std::memset(frame, 0, 160 * 144);
+
+	unsigned long outPalette[4 * 4];
+	for (int i = 0; i < 16; i++)
+		outPalette[i] = videoFormat_ == GB::INDEXED8 ? i : rgb32ToVideoFormat(palette[i], videoFormat_);
 
 	for (int j = 0; j < 144; j++) {
 		for (int i = 0; i < 160; i++) {
 			unsigned attribute = attributes[(j / 8) * 20 + (i / 8)];
-			videoBuf_[j * pitch_ + i] = palette[attribute * 4 + frame[j * 160 + i]];
+			unsigned long const pixel = outPalette[attribute * 4 + frame[j * 160 + i]];
+			std::ptrdiff_t const pos = j * pitch + i;
+			switch (videoFormat_) {
+			case GB::RGB32: videoBuf[pos] = pixel; break;
+			case GB::INDEXED8: buf8[pos] = pixel; break;
+			default: buf16[pos] = pixel; break;
+			}
 		}
 	}
 }
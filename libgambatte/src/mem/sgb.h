@@ -19,6 +19,7 @@
 #ifndef SGB_H
 #define SGB_H
 
+#include "gambatte.h"
 #include "gbint.h"
 #include <cstddef>
 
@@ -45,8 +46,17 @@ public:
 		refreshPalettes();
 	}
 
+	void setVideoFormat(GB::VideoFormat format) { videoFormat_ = format; }
+
+	void getIndexedPalette(uint_least32_t *dest) const {
+		for (int i = 0; i < 4 * 4; ++i)
+			dest[i] = palette[i];
+	}
+
 	void onJoypad(unsigned data);
 	void updateScreen();
+	// Colors a frame drawn by the LCD again, without looking for transfers in it.
+	void refreshScreen(uint_least32_t *videoBuf, std::ptrdiff_t pitch) const;
 
 private:
 	unsigned char transfer;
@@ -60,6 +70,7 @@ private:
 	uint_least32_t *videoBuf_;
 	std::ptrdiff_t pitch_;
 	bool trueColors_;
+	GB::VideoFormat videoFormat_;
 
 	unsigned short systemColors[512 * 4];
 	unsigned short colors[4 * 4];
@@ -82,6 +93,8 @@ private:
 		MASK_EN  = 0x17
 	};
 
+	void readScreen(unsigned char *frame, uint_least32_t const *videoBuf, std::ptrdiff_t pitch) const;
+	void drawScreen(unsigned char *frame, uint_least32_t *videoBuf, std::ptrdiff_t pitch) const;
 	void handleTransfer(unsigned data);
 	void onCommand();
 	void onTransfer(unsigned char *frame);
@@ -39,7 +39,7 @@ Time::Time()
 {
 }
 
-void Time::saveState(SaveState &state, unsigned long const cc) {
+void Time::saveState(SaveState &state, cc_t const cc) {
 	if (useCycles_)
 		timeFromCycles(cc);
 	else
@@ -59,39 +59,39 @@ void Time::loadState(SaveState const &state) {
 	ds_ = state.mem.ioamhram.get()[0x14D] >> 7;
 }
 
-std::time_t Time::get(unsigned long const cc) {
+std::time_t Time::get(cc_t const cc) {
 	update(cc);
 	return seconds_;
 }
 
-void Time::set(std::time_t seconds, unsigned long const cc) {
+void Time::set(std::time_t seconds, cc_t const cc) {
 	update(cc);
 	seconds_ = seconds;
 }
 
-void Time::reset(std::time_t seconds, unsigned long const cc) {
+void Time::reset(std::time_t seconds, cc_t const cc) {
 	set(seconds, cc);
 	lastTime_ = now();
 	lastCycles_ = cc;
 }
 
-void Time::resetCc(unsigned long const oldCc, unsigned long const newCc) {
+void Time::resetCc(cc_t const oldCc, cc_t const newCc) {
 	update(oldCc);
 	lastCycles_ -= oldCc - newCc;
 }
 
-void Time::speedChange(unsigned long const cc) {
+void Time::speedChange(cc_t const cc) {
 	update(cc);
 
 	if (useCycles_) {
-		unsigned long diff = cc - lastCycles_;
+		cc_t diff = cc - lastCycles_;
 		lastCycles_ = cc - (ds_ ? diff >> 1 : diff << 1);
 	}
 
 	ds_ = !ds_;
 }
 
-timeval Time::baseTime(unsigned long const cc) {
+timeval Time::baseTime(cc_t const cc) {
 	if (useCycles_)
 		timeFromCycles(cc);
 
@@ -100,7 +100,7 @@ timeval Time::baseTime(unsigned long const cc) {
 	return baseTime;
 }
 
-void Time::setBaseTime(timeval baseTime, unsigned long const cc) {
+void Time::setBaseTime(timeval baseTime, cc_t const cc) {
 	seconds_ = (now() - baseTime).tv_sec;
 	lastTime_ = baseTime;
 	lastTime_.tv_sec += seconds_;
@@ -109,7 +109,7 @@ void Time::setBaseTime(timeval baseTime, unsigned long const cc) {
 		cyclesFromTime(cc);
 }
 
-void Time::setTimeMode(bool useCycles, unsigned long const cc) {
+void Time::setTimeMode(bool useCycles, cc_t const cc) {
 	if (useCycles != useCycles_) {
 		if (useCycles_)
 			timeFromCycles(cc);
@@ -120,11 +120,11 @@ void Time::setTimeMode(bool useCycles, unsigned long const cc) {
 	}
 }
 
-unsigned Time::timeNow(unsigned long const cc) const {
+unsigned Time::timeNow(cc_t const cc) const {
 	return (seconds_ * rtc_divisor + ((cc - lastCycles_) >> ds_)) >> 1;
 }
 
-void Time::update(unsigned long const cc) {
+void Time::update(cc_t const cc) {
 	if (useCycles_) {
 		std::time_t diff = (cc - lastCycles_) / (rtc_divisor << ds_);
 		seconds_ += diff;
@@ -136,15 +136,15 @@ void Time::update(unsigned long const cc) {
 	}
 }
 
-void Time::cyclesFromTime(unsigned long const cc) {
+void Time::cyclesFromTime(cc_t const cc) {
 	update(cc);
 	timeval diff = now() - lastTime_;
 	lastCycles_ = cc - diff.tv_usec * ((rtc_divisor << ds_) / 1000000.0f);
 }
 
-void Time::timeFromCycles(unsigned long const cc) {
+void Time::timeFromCycles(cc_t const cc) {
 	update(cc);
-	unsigned long diff = cc - lastCycles_;
+	cc_t diff = cc - lastCycles_;
 	timeval usec = { 0, (long)(diff / ((rtc_divisor << ds_) / 1000000.0f)) };
 	lastTime_ = now() - usec;
 }
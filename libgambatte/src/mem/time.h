@@ -19,6 +19,7 @@
 #ifndef TIME_H
 #define TIME_H
 
+#include "../counterdef.h"
 #include <ctime>
 #include <sys/time.h>
 
@@ -35,31 +36,31 @@ public:
 	}
 
 	Time();
-	void saveState(SaveState &state, unsigned long cycleCounter);
+	void saveState(SaveState &state, cc_t cycleCounter);
 	void loadState(SaveState const &state);
 
-	std::time_t get(unsigned long cycleCounter);
-	void set(std::time_t seconds, unsigned long cycleCounter);
-	void reset(std::time_t seconds, unsigned long cycleCounter);
-	void resetCc(unsigned long oldCc, unsigned long newCc);
-	void speedChange(unsigned long cycleCounter);
+	std::time_t get(cc_t cycleCounter);
+	void set(std::time_t seconds, cc_t cycleCounter);
+	void reset(std::time_t seconds, cc_t cycleCounter);
+	void resetCc(cc_t oldCc, cc_t newCc);
+	void speedChange(cc_t cycleCounter);
 
-	timeval baseTime(unsigned long cycleCounter);
-	void setBaseTime(timeval baseTime, unsigned long cycleCounter);
-	void setTimeMode(bool useCycles, unsigned long cycleCounter);
+	timeval baseTime(cc_t cycleCounter);
+	void setBaseTime(timeval baseTime, cc_t cycleCounter);
+	void setTimeMode(bool useCycles, cc_t cycleCounter);
 
-	unsigned timeNow(unsigned long cycleCounter) const;
+	unsigned timeNow(cc_t cycleCounter) const;
 
 private:
 	std::time_t seconds_;
 	timeval lastTime_;
-	unsigned long lastCycles_;
+	cc_t lastCycles_;
 	bool useCycles_;
 	bool ds_;
 
-	void update(unsigned long cycleCounter);
-	void cyclesFromTime(unsigned long cycleCounter);
-	void timeFromCycles(unsigned long cycleCounter);
+	void update(cc_t cycleCounter);
+	void cyclesFromTime(cc_t cycleCounter);
+	void timeFromCycles(cc_t cycleCounter);
 };
 
 }
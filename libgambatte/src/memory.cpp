@@ -32,7 +32,7 @@ namespace {
 
 int const oam_size = 4 * lcd_num_oam_entries;
 
-void decCycles(unsigned long &counter, unsigned long dec) {
+void decCycles(cc_t &counter, cc_t dec) {
 	if (counter != disabled_time)
 		counter -= dec;
 }
@@ -45,7 +45,11 @@ int serialCntFrom(unsigned long cyclesUntilDone, bool cgbFast) {
 
 Memory::Memory(Interrupter const &interrupter)
 : bios_(0)
+, biosSize_(0)
 , getInput_(0)
+, inputSchedule_(0)
+, inputScheduleSize_(0)
+, runThroughSchedule_(false)
 , divLastUpdate_(0)
 , lastOamDmaUpdate_(disabled_time)
 , lcd_(ioamhram_, 0, VideoInterruptRequester(intreq_))
@@ -60,6 +64,7 @@ Memory::Memory(Interrupter const &interrupter)
 {
 	intreq_.setEventTime<intevent_blit>(1l * lcd_vres * lcd_cycles_per_line);
 	intreq_.setEventTime<intevent_end>(0);
+	resetEventStats();
 }
 
 Memory::~Memory() {
@@ -75,7 +80,7 @@ void Memory::setStatePtrs(SaveState &state) {
 	psg_.setStatePtrs(state);
 }
 
-unsigned long Memory::saveState(SaveState &state, unsigned long cc) {
+cc_t Memory::saveState(SaveState &state, cc_t cc) {
 	cc = resetCounters(cc);
 	ioamhram_[0x104] = 0;
 	nontrivial_ff_read(0x05, cc);
@@ -110,6 +115,7 @@ void Memory::loadState(SaveState const &state) {
 	stopped_ = state.mem.stopped;
 	psg_.loadState(state);
 	lcd_.loadState(state, state.mem.oamDmaPos < oam_size ? cart_.rdisabledRam() : ioamhram_);
+	rasterTrace_.clear();
 	tima_.loadState(state, TimaInterruptRequester(intreq_));
 	sgb_.loadState(state);
 	cart_.loadState(state);
@@ -155,7 +161,7 @@ void Memory::loadState(SaveState const &state) {
 		std::fill_n(cart_.vramdata() + vrambank_size(), vrambank_size(), 0);
 }
 
-void Memory::setEndtime(unsigned long cc, unsigned long inc) {
+void Memory::setEndtime(cc_t cc, cc_t inc) {
 	if (intreq_.eventTime(intevent_blit) <= cc) {
 		intreq_.setEventTime<intevent_blit>(intreq_.eventTime(intevent_blit)
 			+ (lcd_cycles_per_frame << isDoubleSpeed()));
@@ -164,7 +170,7 @@ void Memory::setEndtime(unsigned long cc, unsigned long inc) {
 	intreq_.setEventTime<intevent_end>(cc + (inc << isDoubleSpeed()));
 }
 
-void Memory::updateSerial(unsigned long const cc) {
+void Memory::updateSerial(cc_t const cc) {
 	if (intreq_.eventTime(intevent_serial) != disabled_time) {
 		if (intreq_.eventTime(intevent_serial) <= cc) {
 			ioamhram_[0x101] = (((ioamhram_[0x101] + 1) << serialCnt_) - 1) & 0xFF;
@@ -180,21 +186,25 @@ void Memory::updateSerial(unsigned long const cc) {
 	}
 }
 
-void Memory::updateTimaIrq(unsigned long cc) {
+void Memory::updateTimaIrq(cc_t cc) {
 	while (intreq_.eventTime(intevent_tima) <= cc)
 		tima_.doIrqEvent(TimaInterruptRequester(intreq_));
 }
 
-void Memory::updateIrqs(unsigned long cc) {
+void Memory::updateIrqs(cc_t cc) {
 	updateSerial(cc);
 	updateTimaIrq(cc);
 	lcd_.update(cc);
 }
 
-unsigned long Memory::event(unsigned long cc) {
+cc_t Memory::event(cc_t cc) {
 	if (lastOamDmaUpdate_ != disabled_time)
 		updateOamDma(cc);
 
+#ifdef GAMBATTE_EVENT_STATS
+	++intEventCounts_[intreq_.minEventId()];
+#endif
+
 	switch (intreq_.minEventId()) {
 	case intevent_unhalt:
 		if ((lcd_.hdmaIsEnabled() && lcd_.isHdmaPeriod(cc) && haltHdmaState_ == hdma_low)
@@ -220,23 +230,42 @@ unsigned long Memory::event(unsigned long cc) {
 	case intevent_blit:
 		{
 			bool const lcden = ioamhram_[0x140] & lcdc_en;
-			unsigned long blitTime = intreq_.eventTime(intevent_blit);
+			cc_t blitTime = intreq_.eventTime(intevent_blit);
 
 			if (lcden | blanklcd_) {
+				bool scheduleLeft = false;
+				if (inputScheduleSize_) {
+					++inputSchedule_;
+					if (--inputScheduleSize_) {
+						updateInput();
+						scheduleLeft = runThroughSchedule_;
+					}
+				}
+
 				if (intreq_.eventTime(intevent_unhalt) == disabled_time) {
 					lcd_.updateScreen(blanklcd_, cc, 0);
-					if (isSgb())
+					if (isSgb()) {
+						// the SGB looks for transfers in every frame
+						lcd_.drawDeferredFrame();
 						sgb_.updateScreen();
+					}
 					lcd_.updateScreen(blanklcd_, cc, 1);
 				} else {
 					lcd_.blackScreen();
 				}
 
-				intreq_.setEventTime<intevent_blit>(disabled_time);
-				intreq_.setEventTime<intevent_end>(disabled_time);
+				rasterTrace_.endFrame();
+
+				if (scheduleLeft) {
+					// keep going like the next runFor call would (see setEndtime).
+					blitTime += lcd_cycles_per_frame << isDoubleSpeed();
+				} else {
+					intreq_.setEventTime<intevent_blit>(disabled_time);
+					intreq_.setEventTime<intevent_end>(disabled_time);
 
-				while (cc >= intreq_.minEventTime())
-					cc = event(cc);
+					while (cc >= intreq_.minEventTime())
+						cc = event(cc);
+				}
 			} else
 				blitTime += lcd_cycles_per_frame << isDoubleSpeed();
 
@@ -306,7 +335,7 @@ unsigned long Memory::event(unsigned long cc) {
 	return cc;
 }
 
-unsigned long Memory::dma(unsigned long cc) {
+cc_t Memory::dma(cc_t cc) {
 	bool const doubleSpeed = isDoubleSpeed();
 	unsigned dmaSrc = dmaSource_;
 	unsigned dmaDest = dmaDestination_;
@@ -323,9 +352,21 @@ unsigned long Memory::dma(unsigned long cc) {
 	if (!(ioamhram_[0x140] & lcdc_en))
 		dmaLength = 0;
 
-	unsigned long lOamDmaUpdate = lastOamDmaUpdate_;
+	cc_t lOamDmaUpdate = lastOamDmaUpdate_;
 	lastOamDmaUpdate_ = disabled_time;
 
+	if (lOamDmaUpdate == disabled_time && isPlainDmaSrc(dmaSrc, length)) {
+		cc_t const end = cc + length * (2 + 2 * doubleSpeed);
+		if (lcd_.vramWritableUntil(cc + 2 + 2 * doubleSpeed, end)) {
+			lcd_.vramChange(end);
+			bulkDmaCopy(dmaSrc, dmaDest, length);
+			dmaSrc += length;
+			dmaDest += length;
+			length = 0;
+			cc = end;
+		}
+	}
+
 	while (length--) {
 		unsigned const src = dmaSrc++ & 0xFFFF;
 		unsigned const data = (src & -vrambank_size()) == mm_vram_begin || src >= mm_oam_begin
@@ -372,7 +413,44 @@ unsigned long Memory::dma(unsigned long cc) {
 	return cc;
 }
 
-void Memory::freeze(unsigned long cc) {
+bool Memory::isPlainDmaSrc(unsigned const src, unsigned const length) const {
+	if (biosMode_ || src + length > mm_oam_begin)
+		return false;
+
+	for (unsigned p = src & -0x1000u; p < src + length; p += 0x1000) {
+		if ((p & -vrambank_size()) == mm_vram_begin || !cart_.rmem(p >> 12))
+			return false;
+	}
+
+	return true;
+}
+
+void Memory::bulkDmaCopy(unsigned src, unsigned dest, unsigned length) {
+	while (length) {
+		unsigned const destPos = dest % vrambank_size();
+		unsigned const n = std::min(std::min(0x1000 - (src & 0xFFF),
+			unsigned(vrambank_size()) - destPos), length);
+		lcd_.vramWrite(cart_.vrambankptr() + (mm_vram_begin | destPos), cart_.rmem(src >> 12) + src, n);
+		std::memcpy(cart_.vrambankptr() + (mm_vram_begin | destPos), cart_.rmem(src >> 12) + src, n);
+		src += n;
+		dest += n;
+		length -= n;
+	}
+}
+
+void Memory::getVideoSnapshot(GB::VideoSnapshot &dest) const {
+	std::memcpy(dest.vram, cart_.vramdata(), sizeof dest.vram);
+	std::memcpy(dest.oam, ioamhram_, sizeof dest.oam);
+	lcd_.getRgb32Palettes(dest.bgPalette, dest.spPalette);
+	dest.lcdc = ioamhram_[0x140];
+	dest.scy = ioamhram_[0x142];
+	dest.scx = ioamhram_[0x143];
+	dest.wy = ioamhram_[0x14A];
+	dest.wx = ioamhram_[0x14B];
+	dest.cgb = isCgb() && !isCgbDmg();
+}
+
+void Memory::freeze(cc_t cc) {
 	// permanently halt CPU.
 	// simply halt and clear IE to avoid unhalt from occuring,
 	// which avoids additional state to represent a "frozen" state.
@@ -381,7 +459,7 @@ void Memory::freeze(unsigned long cc) {
 	intreq_.halt();
 }
 
-bool Memory::halt(unsigned long cc) {
+bool Memory::halt(cc_t cc) {
 	if (lastOamDmaUpdate_ != disabled_time)
 		updateOamDma(cc);
 
@@ -398,7 +476,7 @@ bool Memory::halt(unsigned long cc) {
 	return hdmaReq;
 }
 
-unsigned Memory::pendingIrqs(unsigned long cc) {
+unsigned Memory::pendingIrqs(cc_t cc) {
 	if (lastOamDmaUpdate_ != disabled_time)
 		updateOamDma(cc);
 
@@ -406,7 +484,7 @@ unsigned Memory::pendingIrqs(unsigned long cc) {
 	return intreq_.pendingIrqs();
 }
 
-void Memory::ackIrq(unsigned bit, unsigned long cc) {
+void Memory::ackIrq(unsigned bit, cc_t cc) {
 	if (lastOamDmaUpdate_ != disabled_time)
 		updateOamDma(cc);
 
@@ -418,7 +496,7 @@ void Memory::ackIrq(unsigned bit, unsigned long cc) {
 	intreq_.ackIrq(bit);
 }
 
-unsigned long Memory::stop(unsigned long cc, bool &skip) {
+cc_t Memory::stop(cc_t cc, bool &skip) {
 	// FIXME: this is incomplete.
 	intreq_.setEventTime<intevent_unhalt>(cc + 0x20000 + 4);
 
@@ -432,7 +510,7 @@ unsigned long Memory::stop(unsigned long cc, bool &skip) {
 		skip = hdmaReqFlagged(intreq_);
 		if (skip && isDoubleSpeed())
 			haltHdmaState_ = hdma_requested;
-		unsigned long const cc_ = cc + 8 * !isDoubleSpeed();
+		cc_t const cc_ = cc + 8 * !isDoubleSpeed();
 		if (cc_ >= cc + 4) {
 			if (lastOamDmaUpdate_ != disabled_time)
 				updateOamDma(cc + 4);
@@ -476,25 +554,30 @@ unsigned long Memory::stop(unsigned long cc, bool &skip) {
 	return cc;
 }
 
-void Memory::stall(unsigned long cc, unsigned long cycles) {
+void Memory::stall(cc_t cc, cc_t cycles) {
 	intreq_.halt();
 	intreq_.setEventTime<intevent_unhalt>(cc + cycles);
 }
 
-void Memory::decEventCycles(IntEventId eventId, unsigned long dec) {
+void Memory::decEventCycles(IntEventId eventId, cc_t dec) {
 	if (intreq_.eventTime(eventId) != disabled_time)
 		intreq_.setEventTime(eventId, intreq_.eventTime(eventId) - dec);
 }
 
-unsigned long Memory::resetCounters(unsigned long cc) {
+cc_t Memory::resetCounters(cc_t cc) {
 	if (lastOamDmaUpdate_ != disabled_time)
 		updateOamDma(cc);
 
 	updateIrqs(cc);
 
-	unsigned long const dec = cc < 0x20000
+#ifdef GAMBATTE_64BIT_CC
+	// only brings everything up to date, as is needed for saving state.
+	cc_t const dec = 0;
+#else
+	cc_t const dec = cc < 0x20000
 		? 0
 		: (cc & -0x10000l) - 0x10000;
+#endif
 	decCycles(lastOamDmaUpdate_, dec);
 	decEventCycles(intevent_serial, dec);
 	decEventCycles(intevent_oam, dec);
@@ -502,7 +585,7 @@ unsigned long Memory::resetCounters(unsigned long cc) {
 	decEventCycles(intevent_end, dec);
 	decEventCycles(intevent_unhalt, dec);
 
-	unsigned long const oldCC = cc;
+	cc_t const oldCC = cc;
 	cc -= dec;
 	intreq_.resetCc(oldCC, cc);
 	cart_.resetCc(oldCC, cc);
@@ -512,12 +595,38 @@ unsigned long Memory::resetCounters(unsigned long cc) {
 	return cc;
 }
 
+void Memory::getEventStats(unsigned long *const dest) const {
+	for (int i = 0; i <= intevent_last; ++i) {
+#ifdef GAMBATTE_EVENT_STATS
+		dest[GB::EVENT_UNHALT + i] = intEventCounts_[i];
+#else
+		dest[GB::EVENT_UNHALT + i] = 0;
+#endif
+	}
+
+	lcd_.getEventStats(dest);
+}
+
+void Memory::resetEventStats() {
+#ifdef GAMBATTE_EVENT_STATS
+	std::fill_n(intEventCounts_, intevent_last + 1, 0);
+#endif
+	lcd_.resetEventStats();
+}
+
+void Memory::setInputSchedule(unsigned char const *inputs, std::size_t n) {
+	inputSchedule_ = n ? inputs : 0;
+	inputScheduleSize_ = n;
+	if (n)
+		updateInput();
+}
+
 void Memory::updateInput() {
 	unsigned state = 0xF;
 
 	if ((ioamhram_[0x100] & 0x30) != 0x30) {
-		if (getInput_) {
-			unsigned input = (*getInput_)(getInputP_);
+		if (getInput_ || inputScheduleSize_) {
+			unsigned input = inputScheduleSize_ ? *inputSchedule_ : (*getInput_)(getInputP_);
 			unsigned dpad_state = ~input >> 4;
 			unsigned button_state = ~input;
 			if (!(ioamhram_[0x100] & 0x10))
@@ -534,7 +643,7 @@ void Memory::updateInput() {
 	ioamhram_[0x100] = (ioamhram_[0x100] & -0x10u) | state;
 }
 
-void Memory::updateOamDma(unsigned long const cc) {
+void Memory::updateOamDma(cc_t const cc) {
 	unsigned char const *const oamDmaSrc = oamDmaSrcPtr();
 	unsigned cycles = (cc - lastOamDmaUpdate_) >> 2;
 
@@ -587,13 +696,13 @@ unsigned char const * Memory::oamDmaSrcPtr() const {
 	return cart_.rdisabledRam();
 }
 
-void Memory::startOamDma(unsigned long cc) {
+void Memory::startOamDma(cc_t cc) {
 	oamDmaPos_ = 0;
 	oamDmaStartPos_ = 0;
 	lcd_.oamChange(cart_.rdisabledRam(), cc);
 }
 
-void Memory::endOamDma(unsigned long cc) {
+void Memory::endOamDma(cc_t cc) {
 	if (oamDmaStartPos_ == 0) {
 		oamDmaPos_ = -2u & 0xFF;
 		cart_.setOamDmaSrc(oam_dma_src_off);
@@ -601,7 +710,7 @@ void Memory::endOamDma(unsigned long cc) {
 	lcd_.oamChange(ioamhram_, cc);
 }
 
-unsigned Memory::nontrivial_ff_read(unsigned const p, unsigned long const cc) {
+unsigned Memory::nontrivial_ff_read(unsigned const p, cc_t const cc) {
 	if (lastOamDmaUpdate_ != disabled_time)
 		updateOamDma(cc);
 
@@ -663,7 +772,7 @@ unsigned Memory::nontrivial_ff_read(unsigned const p, unsigned long const cc) {
 	return ioamhram_[p + 0x100];
 }
 
-unsigned Memory::nontrivial_read(unsigned const p, unsigned long const cc) {
+unsigned Memory::nontrivial_read(unsigned const p, cc_t const cc) {
 	if (p < mm_hram_begin) {
 		if (lastOamDmaUpdate_ != disabled_time) {
 			updateOamDma(cc);
@@ -713,10 +822,16 @@ unsigned Memory::nontrivial_read(unsigned const p, unsigned long const cc) {
 	return ioamhram_[p - mm_oam_begin];
 }
 
-void Memory::nontrivial_ff_write(unsigned const p, unsigned data, unsigned long const cc) {
+void Memory::nontrivial_ff_write(unsigned const p, unsigned data, cc_t const cc) {
 	if (lastOamDmaUpdate_ != disabled_time)
 		updateOamDma(cc);
 
+	if (rasterTrace_.enabled() && RasterTrace::traced(p & 0xFF)) {
+		unsigned ly, lineCycle;
+		lcd_.getRasterPos(cc, ly, lineCycle);
+		rasterTrace_.write(p & 0xFF, data, ly, lineCycle);
+	}
+
 	switch (p & 0xFF) {
 	case 0x00:
 		if ((data ^ ioamhram_[0x100]) & 0x30) {
@@ -748,8 +863,8 @@ void Memory::nontrivial_ff_write(unsigned const p, unsigned data, unsigned long
 	case 0x04:
 		if (intreq_.eventTime(intevent_serial) != disabled_time
 				&& intreq_.eventTime(intevent_serial) > cc) {
-			unsigned long const t = intreq_.eventTime(intevent_serial);
-			unsigned long const n = ioamhram_[0x102] & isCgb() * 2
+			cc_t const t = intreq_.eventTime(intevent_serial);
+			cc_t const n = ioamhram_[0x102] & isCgb() * 2
 				? t + (cc - t) % 8 - 2 * ((cc - t) & 4)
 				: t + (cc - t) % 0x100 - 2 * ((cc - t) & 0x80);
 			intreq_.setEventTime<intevent_serial>(std::max(cc, n));
@@ -1170,7 +1285,7 @@ void Memory::nontrivial_ff_write(unsigned const p, unsigned data, unsigned long
 	ioamhram_[p + 0x100] = data;
 }
 
-void Memory::nontrivial_write(unsigned const p, unsigned const data, unsigned long const cc) {
+void Memory::nontrivial_write(unsigned const p, unsigned const data, cc_t const cc) {
 	if (lastOamDmaUpdate_ != disabled_time) {
 		updateOamDma(cc);
 
@@ -1196,6 +1311,7 @@ void Memory::nontrivial_write(unsigned const p, unsigned const data, unsigned lo
 				cart_.mbcWrite(p, data, cc);
 			} else if (lcd_.vramWritable(cc)) {
 				lcd_.vramChange(cc);
+				lcd_.vramWrite(cart_.vrambankptr() + p, data);
 				cart_.vrambankptr()[p] = data;
 			}
 		} else if (p < mm_wram_begin) {
@@ -1238,7 +1354,25 @@ LoadRes Memory::loadROM(std::string const &romfile, unsigned const flags) {
 	return LOADRES_OK;
 }
 
-std::size_t Memory::fillSoundBuffer(unsigned long cc) {
+// A sound log left unread for long starts over, from the sound state at the end of the run.
+std::size_t Memory::fillSoundBuffer(cc_t cc) {
 	psg_.generateSamples(cc, isDoubleSpeed());
+	if (psg_.logFull())
+		startSoundLog();
+
 	return psg_.fillBuffer();
 }
+
+void Memory::setSoundLogging(bool on, cc_t cc) {
+	psg_.generateSamples(cc, isDoubleSpeed());
+	if (on)
+		startSoundLog();
+	else
+		psg_.stopLog();
+}
+
+void Memory::startSoundLog() {
+	SaveState state;
+	state.mem.ioamhram.set(ioamhram_, sizeof ioamhram_);
+	psg_.startLog(state);
+}
@@ -26,6 +26,7 @@ static unsigned char const agbOverride[0xD] = { 0xFF, 0x00, 0xCD, 0x03, 0x35, 0x
 #include "inputgetter.h"
 #include "interrupter.h"
 #include "pakinfo.h"
+#include "rastertrace.h"
 #include "sound.h"
 #include "tima.h"
 #include "video.h"
@@ -45,39 +46,39 @@ public:
 	char const * romTitle() const { return cart_.romTitle(); }
 	PakInfo const pakInfo(bool multicartCompat) const { return cart_.pakInfo(multicartCompat); }
 	void setStatePtrs(SaveState &state);
-	unsigned long saveState(SaveState &state, unsigned long cc);
+	cc_t saveState(SaveState &state, cc_t cc);
 	void loadState(SaveState const &state);
-	void loadSavedata(unsigned long const cc) { cart_.loadSavedata(cc); }
-	void saveSavedata(unsigned long const cc) { cart_.saveSavedata(cc); }
+	void loadSavedata(cc_t const cc) { cart_.loadSavedata(cc); }
+	void saveSavedata(cc_t const cc) { cart_.saveSavedata(cc); }
 	std::string const saveBasePath() const { return cart_.saveBasePath(); }
 
 	void setOsdElement(transfer_ptr<OsdElement> osdElement) {
 		lcd_.setOsdElement(osdElement);
 	}
 
-	unsigned long stop(unsigned long cycleCounter, bool &skip);
-	void stall(unsigned long cycleCounter, unsigned long cycles);
+	cc_t stop(cc_t cycleCounter, bool &skip);
+	void stall(cc_t cycleCounter, cc_t cycles);
 	bool isCgb() const { return lcd_.isCgb(); }
 	bool isCgbDmg() const { return lcd_.isCgbDmg(); }
 	bool isSgb() const { return gbIsSgb_; }
 	bool ime() const { return intreq_.ime(); }
 	bool halted() const { return intreq_.halted(); }
-	unsigned long nextEventTime() const { return intreq_.minEventTime(); }
+	cc_t nextEventTime() const { return intreq_.minEventTime(); }
 	bool isActive() const { return intreq_.eventTime(intevent_end) != disabled_time; }
 
-	long cyclesSinceBlit(unsigned long cc) const {
+	long cyclesSinceBlit(cc_t cc) const {
 		if (cc < intreq_.eventTime(intevent_blit))
 			return -1;
 
 		return (cc - intreq_.eventTime(intevent_blit)) >> isDoubleSpeed();
 	}
 
-	void freeze(unsigned long cc);
-	bool halt(unsigned long cc);
-	void ei(unsigned long cycleCounter) { if (!ime()) { intreq_.ei(cycleCounter); } }
+	void freeze(cc_t cc);
+	bool halt(cc_t cc);
+	void ei(cc_t cycleCounter) { if (!ime()) { intreq_.ei(cycleCounter); } }
 	void di() { intreq_.di(); }
-	unsigned pendingIrqs(unsigned long cc);
-	void ackIrq(unsigned bit, unsigned long cc);
+	unsigned pendingIrqs(cc_t cc);
+	void ackIrq(unsigned bit, cc_t cc);
 
 	unsigned readBios(unsigned p) {
 		if(agbFlag_ && p >= 0xF3 && p < 0x100)
@@ -86,33 +87,33 @@ public:
 		return bios_[p];
 	}
 
-	unsigned ff_read(unsigned p, unsigned long cc) {
+	unsigned ff_read(unsigned p, cc_t cc) {
 		return p < 0x80 ? nontrivial_ff_read(p, cc) : ioamhram_[p + 0x100];
 	}
 
-	unsigned read(unsigned p, unsigned long cc) {
+	unsigned read(unsigned p, cc_t cc) {
 		if(biosMode_ && (p < biosSize_ && !(p >= 0x100 && p < 0x200)))
 			return readBios(p);
 
 		return cart_.rmem(p >> 12) ? cart_.rmem(p >> 12)[p] : nontrivial_read(p, cc);
 	}
 
-	void write(unsigned p, unsigned data, unsigned long cc) {
+	void write(unsigned p, unsigned data, cc_t cc) {
 		if (cart_.wmem(p >> 12)) {
 			cart_.wmem(p >> 12)[p] = data;
 		} else
 			nontrivial_write(p, data, cc);
 	}
 
-	void ff_write(unsigned p, unsigned data, unsigned long cc) {
+	void ff_write(unsigned p, unsigned data, cc_t cc) {
 		if (p - 0x80u < 0x7Fu) {
 			ioamhram_[p + 0x100] = data;
 		} else
 			nontrivial_ff_write(p, data, cc);
 	}
 
-	unsigned long event(unsigned long cycleCounter);
-	unsigned long resetCounters(unsigned long cycleCounter);
+	cc_t event(cc_t cycleCounter);
+	cc_t resetCounters(cc_t cycleCounter);
 	LoadRes loadROM(std::string const &romfile, unsigned flags);
 	void setSaveDir(std::string const &dir) { cart_.setSaveDir(dir); }
 
@@ -121,9 +122,22 @@ public:
 		getInputP_ = p;
 	}
 
-	void setEndtime(unsigned long cc, unsigned long inc);
+	void setInputSchedule(unsigned char const *inputs, std::size_t n);
+	void setRunThroughSchedule(bool on) { runThroughSchedule_ = on; }
+
+	void setEndtime(cc_t cc, cc_t inc);
 	void setSoundBuffer(uint_least32_t *buf) { psg_.setBuffer(buf); }
-	std::size_t fillSoundBuffer(unsigned long cc);
+	std::size_t fillSoundBuffer(cc_t cc);
+	void setAudioOutputRate(long rate) { psg_.setSynthRate(rate); }
+	std::size_t readAudio(uint_least32_t *dest, std::size_t maxSamples) {
+		return psg_.readSynthSamples(dest, maxSamples);
+	}
+	void setAudioStems(uint_least16_t *const *stems, unsigned decimation) {
+		psg_.setStems(stems, decimation);
+	}
+	std::size_t audioStemSamples() const { return psg_.stemSamples(); }
+	void setSoundLogging(bool on, cc_t cc);
+	std::size_t readSoundLog(char *dest, std::size_t size) { return psg_.readLog(dest, size); }
 
 	void setVideoBuffer(uint_least32_t *videoBuf, std::ptrdiff_t pitch) {
 		lcd_.setVideoBuffer(videoBuf, pitch);
@@ -144,7 +158,20 @@ public:
 		sgb_.setTrueColors(trueColors);
 	}
 
-	void setTimeMode(bool useCycles, unsigned long const cc) {
+	void setVideoFormat(GB::VideoFormat format) {
+		lcd_.setVideoFormat(format);
+		sgb_.setVideoFormat(format);
+	}
+
+	void setRenderWindow(unsigned firstLine, unsigned lastLine) { lcd_.setRenderWindow(firstLine, lastLine); }
+
+	void getIndexedPalette(uint_least32_t *dest) const {
+		lcd_.getIndexedPalette(dest);
+		if (gbIsSgb_)
+			sgb_.getIndexedPalette(dest);
+	}
+
+	void setTimeMode(bool useCycles, cc_t const cc) {
 		cart_.setTimeMode(useCycles, cc);
 	}
 
@@ -159,9 +186,9 @@ public:
 		biosSize_ = size;
 	}
 
-	unsigned timeNow(unsigned long const cc) const { return cart_.timeNow(cc); }
+	unsigned timeNow(cc_t const cc) const { return cart_.timeNow(cc); }
 
-	unsigned long getDivLastUpdate() { return divLastUpdate_; }
+	cc_t getDivLastUpdate() { return divLastUpdate_; }
 	unsigned char getRawIOAMHRAM(int offset) { return ioamhram_[offset]; }
 
 	void setSpeedupFlags(unsigned flags) {
@@ -169,6 +196,26 @@ public:
 		psg_.setSpeedupFlags(flags);
 	}
 
+	bool renderLastFrame(uint_least32_t *videoBuf, std::ptrdiff_t pitch) {
+		if (!lcd_.renderLastFrame(videoBuf, pitch))
+			return false;
+
+		if (gbIsSgb_)
+			sgb_.refreshScreen(videoBuf, pitch);
+
+		return true;
+	}
+
+	void getVideoSnapshot(GB::VideoSnapshot &dest) const;
+	void setRasterTrace(bool enable) { rasterTrace_.setEnabled(enable); }
+
+	std::size_t getRasterTrace(GB::RasterWrite *dest, std::size_t size) const {
+		return rasterTrace_.get(dest, size);
+	}
+
+	void getEventStats(unsigned long *dest) const;
+	void resetEventStats();
+
 private:
 	Cartridge cart_;
 	Sgb sgb_;
@@ -177,13 +224,17 @@ private:
 	std::size_t biosSize_;
 	InputGetter *getInput_;
 	void *getInputP_;
-	unsigned long divLastUpdate_;
-	unsigned long lastOamDmaUpdate_;
+	unsigned char const *inputSchedule_;
+	std::size_t inputScheduleSize_;
+	bool runThroughSchedule_;
+	cc_t divLastUpdate_;
+	cc_t lastOamDmaUpdate_;
 	InterruptRequester intreq_;
 	Tima tima_;
 	LCD lcd_;
 	PSG psg_;
 	Interrupter interrupter_;
+	RasterTrace rasterTrace_;
 	unsigned short dmaSource_;
 	unsigned short dmaDestination_;
 	unsigned char oamDmaPos_;
@@ -195,21 +246,27 @@ private:
 	bool gbIsSgb_;
 	bool stopped_;
 	enum HdmaState { hdma_low, hdma_high, hdma_requested } haltHdmaState_;
+#ifdef GAMBATTE_EVENT_STATS
+	unsigned long intEventCounts_[intevent_last + 1];
+#endif
 
-	void decEventCycles(IntEventId eventId, unsigned long dec);
+	void decEventCycles(IntEventId eventId, cc_t dec);
 	void oamDmaInitSetup();
-	void updateOamDma(unsigned long cycleCounter);
-	void startOamDma(unsigned long cycleCounter);
-	void endOamDma(unsigned long cycleCounter);
+	void updateOamDma(cc_t cycleCounter);
+	void startOamDma(cc_t cycleCounter);
+	void endOamDma(cc_t cycleCounter);
 	unsigned char const * oamDmaSrcPtr() const;
-	unsigned long dma(unsigned long cc);
-	unsigned nontrivial_ff_read(unsigned p, unsigned long cycleCounter);
-	unsigned nontrivial_read(unsigned p, unsigned long cycleCounter);
-	void nontrivial_ff_write(unsigned p, unsigned data, unsigned long cycleCounter);
-	void nontrivial_write(unsigned p, unsigned data, unsigned long cycleCounter);
-	void updateSerial(unsigned long cc);
-	void updateTimaIrq(unsigned long cc);
-	void updateIrqs(unsigned long cc);
+	cc_t dma(cc_t cc);
+	bool isPlainDmaSrc(unsigned src, unsigned length) const;
+	void bulkDmaCopy(unsigned src, unsigned dest, unsigned length);
+	unsigned nontrivial_ff_read(unsigned p, cc_t cycleCounter);
+	unsigned nontrivial_read(unsigned p, cc_t cycleCounter);
+	void nontrivial_ff_write(unsigned p, unsigned data, cc_t cycleCounter);
+	void nontrivial_write(unsigned p, unsigned data, cc_t cycleCounter);
+	void updateSerial(cc_t cc);
+	void updateTimaIrq(cc_t cc);
+	void updateIrqs(cc_t cc);
+	void startSoundLog();
 	bool isDoubleSpeed() const { return lcd_.isDoubleSpeed(); }
 };
 
@@ -19,7 +19,11 @@
 #ifndef MINKEEPER_H
 #define MINKEEPER_H
 
+#include "counterdef.h"
 #include <algorithm>
+#ifdef GAMBATTE_MINKEEPER_TRACE
+#include <cstdio>
+#endif
 
 namespace min_keeper_detail {
 
@@ -33,31 +37,51 @@ template<int v> struct CeiledDiv2n<v, 0> { enum { r = v }; };
 template<template<int> class T, int n> struct Sum { enum { r = T<n-1>::r + Sum<T, n-1>::r }; };
 template<template<int> class T> struct Sum<T, 0> { enum { r = 0 }; };
 
+#ifdef GAMBATTE_MINKEEPER_TRACE
+// Appends an (ids, id, value) record to minkeeper.trace in the working directory.
+// id is 0xff for construction. Replayed by test/minkeeperbench.
+inline void trace(int ids, int id, gambatte::cc_t value) {
+	static std::FILE *const file = std::fopen("minkeeper.trace", "wb");
+	if (!file)
+		return;
+
+	unsigned char rec[10] = { static_cast<unsigned char>(ids), static_cast<unsigned char>(id) };
+	for (int i = 9; i >= 2; --i) {
+		rec[i] = value & 0xff;
+		value >>= 8;
+	}
+
+	std::fwrite(rec, 1, sizeof rec, file);
+}
+#endif
+
 }
 
 // Keeps track of minimum value identified by id as values change.
 // Higher ids prioritized (as min value) if values are equal. (Can be inverted by swapping < for <=).
+//
+// TreeMinKeeper keeps a tournament tree, so every change costs log2(ids) compares.
 // Higher ids can be faster to change when the number of ids isn't a power of 2.
 // Thus, the ones that change more frequently should have higher ids if priority allows for it.
 template<int ids>
-class MinKeeper {
+class TreeMinKeeper {
 public:
-	explicit MinKeeper(unsigned long initValue);
+	explicit TreeMinKeeper(gambatte::cc_t initValue);
 	int min() const { return a_[0]; }
-	unsigned long minValue() const { return minValue_; }
+	gambatte::cc_t minValue() const { return minValue_; }
 
 	template<int id>
-	void setValue(unsigned long cnt) {
+	void setValue(gambatte::cc_t cnt) {
 		values_[id] = cnt;
 		updateValue<id / 2>(*this);
 	}
 
-	void setValue(int id, unsigned long cnt) {
+	void setValue(int id, gambatte::cc_t cnt) {
 		values_[id] = cnt;
 		updateValueLut.call(id >> 1, *this);
 	}
 
-	unsigned long value(int id) const { return values_[id]; }
+	gambatte::cc_t value(int id) const { return values_[id]; }
 
 private:
 	enum { height = min_keeper_detail::CeiledLog2<ids>::r };
@@ -69,7 +93,7 @@ private:
 		enum { p = Sum<depth - 1>::r + id
 		    , c0 = Sum<depth>::r + id * 2
 		    , c1 = id * 2 + 1 < Num<depth>::r ? c0 + 1 : c0 };
-		static void updateValue(MinKeeper<ids> &m) {
+		static void updateValue(TreeMinKeeper<ids> &m) {
 			m.a_[p] = m.values_[m.a_[c0]] < m.values_[m.a_[c1]] ? m.a_[c0] : m.a_[c1];
 			UpdateValue<id / 2, depth - 1>::updateValue(m);
 		}
@@ -77,7 +101,7 @@ private:
 
 	template<int id>
 	struct UpdateValue<id, 0> {
-		static void updateValue(MinKeeper<ids> &m) {
+		static void updateValue(TreeMinKeeper<ids> &m) {
 			m.minValue_ = m.values_[m.a_[0]];
 		}
 	};
@@ -85,7 +109,7 @@ private:
 	class UpdateValueLut {
 	public:
 		UpdateValueLut() { FillLut<Num<height - 1>::r - 1, 0>::fillLut(*this); }
-		void call(int id, MinKeeper<ids> &mk) const { lut_[id](mk); }
+		void call(int id, TreeMinKeeper<ids> &mk) const { lut_[id](mk); }
 
 	private:
 		template<int id, int dummy>
@@ -101,21 +125,21 @@ private:
 			static void fillLut(UpdateValueLut &) {}
 		};
 
-		void (*lut_[Num<height - 1>::r])(MinKeeper<ids> &);
+		void (*lut_[Num<height - 1>::r])(TreeMinKeeper<ids> &);
 	};
 
 	static UpdateValueLut updateValueLut;
-	unsigned long values_[ids];
-	unsigned long minValue_;
+	gambatte::cc_t values_[ids];
+	gambatte::cc_t minValue_;
 	int a_[Sum<height>::r];
 
-	template<int id> static void updateValue(MinKeeper<ids> &m);
+	template<int id> static void updateValue(TreeMinKeeper<ids> &m);
 };
 
-template<int ids> typename MinKeeper<ids>::UpdateValueLut MinKeeper<ids>::updateValueLut;
+template<int ids> typename TreeMinKeeper<ids>::UpdateValueLut TreeMinKeeper<ids>::updateValueLut;
 
 template<int ids>
-MinKeeper<ids>::MinKeeper(unsigned long const initValue) {
+TreeMinKeeper<ids>::TreeMinKeeper(gambatte::cc_t const initValue) {
 	std::fill(values_, values_ + ids, initValue);
 
 	// todo: simplify/less template bloat.
@@ -146,11 +170,98 @@ MinKeeper<ids>::MinKeeper(unsigned long const initValue) {
 
 template<int ids>
 template<int id>
-void MinKeeper<ids>::updateValue(MinKeeper<ids> &m) {
+void TreeMinKeeper<ids>::updateValue(TreeMinKeeper<ids> &m) {
 	enum { c0 = id * 2
 	     , c1 = c0 + 1 < ids ? c0 + 1 : c0 };
 	m.a_[Sum<height - 1>::r + id] = m.values_[c0] < m.values_[c1] ? c0 : c1;
 	UpdateValue<id / 2, height - 1>::updateValue(m);
 }
 
+// Keeps the current min in place and only rescans all values when the min is raised.
+// Same semantics as TreeMinKeeper, but cheaper on the common change (one compare) for
+// the small id counts used here, at the cost of an occasional linear scan.
+template<int ids>
+class LinearMinKeeper {
+public:
+	explicit LinearMinKeeper(gambatte::cc_t initValue)
+	: minValue_(initValue), min_(ids - 1)
+	{
+		std::fill(values_, values_ + ids, initValue);
+	}
+
+	int min() const { return min_; }
+	gambatte::cc_t minValue() const { return minValue_; }
+
+	template<int id>
+	void setValue(gambatte::cc_t cnt) { setValue(id, cnt); }
+
+	void setValue(int id, gambatte::cc_t cnt) {
+		values_[id] = cnt;
+		if (cnt < minValue_ || (cnt == minValue_ && id >= min_)) {
+			minValue_ = cnt;
+			min_ = id;
+		} else if (id == min_)
+			rescan();
+	}
+
+	gambatte::cc_t value(int id) const { return values_[id]; }
+
+private:
+	gambatte::cc_t values_[ids];
+	gambatte::cc_t minValue_;
+	int min_;
+
+	void rescan() {
+		int m = 0;
+		gambatte::cc_t mv = values_[0];
+		for (int i = 1; i < ids; ++i) {
+			bool const le = values_[i] <= mv;
+			m = le ? i : m;
+			mv = le ? values_[i] : mv;
+		}
+
+		minValue_ = mv;
+		min_ = m;
+	}
+};
+
+// Implementation is picked at compile time (GAMBATTE_LINEAR_MINKEEPER),
+// since which one is faster depends on the host. See test/minkeeperbench.cpp.
+template<int ids>
+class MinKeeper : public
+#ifdef GAMBATTE_LINEAR_MINKEEPER
+	LinearMinKeeper<ids>
+#else
+	TreeMinKeeper<ids>
+#endif
+{
+public:
+#ifdef GAMBATTE_LINEAR_MINKEEPER
+	typedef LinearMinKeeper<ids> Base;
+#else
+	typedef TreeMinKeeper<ids> Base;
+#endif
+
+	explicit MinKeeper(gambatte::cc_t initValue)
+	: Base(initValue)
+	{
+#ifdef GAMBATTE_MINKEEPER_TRACE
+		min_keeper_detail::trace(ids, 0xff, initValue);
+#endif
+	}
+
+#ifdef GAMBATTE_MINKEEPER_TRACE
+	template<int id>
+	void setValue(gambatte::cc_t cnt) {
+		min_keeper_detail::trace(ids, id, cnt);
+		Base::template setValue<id>(cnt);
+	}
+
+	void setValue(int id, gambatte::cc_t cnt) {
+		min_keeper_detail::trace(ids, id, cnt);
+		Base::setValue(id, cnt);
+	}
+#endif
+};
+
 #endif
@@ -0,0 +1,93 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef RASTERTRACE_H
+#define RASTERTRACE_H
+
+#include "gambatte.h"
+#include <algorithm>
+#include <vector>
+
+namespace gambatte {
+
+// Video register writes of the frame being drawn and of the last completed one
+// (see GB::setRasterTrace). Space for GB::RASTER_TRACE_SIZE writes is allocated
+// up front, writes past that are only counted.
+class RasterTrace {
+public:
+	RasterTrace() : enabled_(false), count_(0), lastCount_(0) {}
+	bool enabled() const { return enabled_; }
+
+	void setEnabled(bool enabled) {
+		enabled_ = enabled;
+		if (enabled) {
+			writes_.reserve(GB::RASTER_TRACE_SIZE);
+			lastWrites_.reserve(GB::RASTER_TRACE_SIZE);
+		} else {
+			// reserve never shrinks, so swap with empty vectors to free the memory
+			std::vector<GB::RasterWrite>().swap(writes_);
+			std::vector<GB::RasterWrite>().swap(lastWrites_);
+		}
+
+		clear();
+	}
+
+	static bool traced(unsigned p) {
+		return (p >= 0x40 && p <= 0x4B && p != 0x44 && p != 0x45 && p != 0x46)
+		    || (p >= 0x68 && p <= 0x6B);
+	}
+
+	void write(unsigned p, unsigned data, unsigned ly, unsigned lineCycle) {
+		if (++count_ <= GB::RASTER_TRACE_SIZE) {
+			GB::RasterWrite const w = { static_cast<unsigned char>(p),
+			                            static_cast<unsigned char>(data),
+			                            static_cast<unsigned char>(ly),
+			                            static_cast<unsigned short>(lineCycle) };
+			writes_.push_back(w);
+		}
+	}
+
+	void endFrame() {
+		writes_.swap(lastWrites_);
+		writes_.clear();
+		lastCount_ = count_;
+		count_ = 0;
+	}
+
+	void clear() {
+		writes_.clear();
+		lastWrites_.clear();
+		count_ = lastCount_ = 0;
+	}
+
+	std::size_t get(GB::RasterWrite *dest, std::size_t size) const {
+		std::copy(lastWrites_.begin(), lastWrites_.begin() + std::min(size, lastWrites_.size()), dest);
+		return lastCount_;
+	}
+
+private:
+	std::vector<GB::RasterWrite> writes_;
+	std::vector<GB::RasterWrite> lastWrites_;
+	bool enabled_;
+	std::size_t count_;
+	std::size_t lastCount_;
+};
+
+}
+
+#endif
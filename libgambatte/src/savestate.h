@@ -19,6 +19,7 @@
 #ifndef SAVESTATE_H
 #define SAVESTATE_H
 
+#include "counterdef.h"
 #include <cstddef>
 
 namespace gambatte {
@@ -44,7 +45,7 @@ struct SaveState {
 	};
 
 	struct CPU {
-		unsigned long cycleCounter;
+		cc_t cycleCounter;
 		unsigned short pc;
 		unsigned short sp;
 		unsigned char a;
@@ -65,13 +66,13 @@ struct SaveState {
 		Ptr<unsigned char> sram;
 		Ptr<unsigned char> wram;
 		Ptr<unsigned char> ioamhram;
-		unsigned long divLastUpdate;
-		unsigned long timaLastUpdate;
-		unsigned long tmatime;
-		unsigned long nextSerialtime;
-		unsigned long lastOamDmaUpdate;
-		unsigned long minIntTime;
-		unsigned long unhaltTime;
+		cc_t divLastUpdate;
+		cc_t timaLastUpdate;
+		cc_t tmatime;
+		cc_t nextSerialtime;
+		cc_t lastOamDmaUpdate;
+		cc_t minIntTime;
+		cc_t unhaltTime;
 		unsigned short rombank;
 		unsigned short dmaSource;
 		unsigned short dmaDestination;
@@ -112,7 +113,7 @@ struct SaveState {
 		Ptr<bool> oamReaderSzbuf;
 
 		unsigned long videoCycles;
-		unsigned long enableDisplayM0Time;
+		cc_t enableDisplayM0Time;
 		unsigned short lastM0Time;
 		unsigned short nextM0Irq;
 		unsigned short tileword;
@@ -211,7 +212,7 @@ struct SaveState {
 		unsigned long seconds;
 		unsigned long lastTimeSec;
 		unsigned long lastTimeUsec;
-		unsigned long lastCycles;
+		cc_t lastCycles;
 	} time;
 
 	struct RTC {
@@ -228,7 +229,7 @@ struct SaveState {
 		unsigned long haltTime;
 		unsigned long dataTime;
 		unsigned long writingTime;
-		unsigned long irBaseCycle;
+		cc_t irBaseCycle;
 		unsigned char /*bool*/ halted;
 		unsigned char shift;
 		unsigned char ramValue;
@@ -17,6 +17,7 @@
 //
 
 #include "sound.h"
+#include "sound/prefix_sum.h"
 #include "gambatte.h"
 #include "savestate.h"
 
@@ -56,7 +57,21 @@ PSG::PSG()
 , rsum_(0x8000) // initialize to 0x8000 to prevent borrows from high word, xor away later
 , enabled_(false)
 , speedupFlags_(0)
+, stemDecimation_(1)
+, stemBlockPos_(0)
+, stemPos_(0)
+, logReadPos_(0)
+, logRecordPos_(0)
+, logCc_(0)
+, loggedCc_(0)
+, logging_(false)
 {
+	std::fill_n(stems_, 1 * num_channels, static_cast<uint_least16_t *>(0));
+	std::fill_n(soMask_, 1 * num_channels, 0);
+	std::fill_n(stemLevel_, 1 * num_channels, 0);
+	std::fill_n(stemMixOut_, 1 * num_channels, 0);
+	std::fill_n(stemSum_, 1 * num_channels, 0);
+	std::memset(stemBuf_, 0, sizeof stemBuf_);
 }
 
 void PSG::init(bool cgb) {
@@ -65,6 +80,9 @@ void PSG::init(bool cgb) {
 }
 
 void PSG::reset(bool ds) {
+	if (logging_)
+		log(sound_log::op_reset);
+
 	int const divOffset = lastUpdate_ & ds;
 	unsigned long const cc = cycleCounter_ + divOffset;
 	// cycleCounter >> 12 & 7 represents the frame sequencer position.
@@ -77,6 +95,9 @@ void PSG::reset(bool ds) {
 }
 
 void PSG::divReset(bool ds) {
+	if (logging_)
+		log(sound_log::op_div_reset);
+
 	int const divOffset = lastUpdate_ & ds;
 	unsigned long const cc = cycleCounter_ + divOffset;
 	cycleCounter_ = (cc & -0x1000) + 2 * (cc & 0x800) - divOffset;
@@ -86,8 +107,11 @@ void PSG::divReset(bool ds) {
 	ch4_.resetCc(cc - divOffset, cycleCounter_);
 }
 
-void PSG::speedChange(unsigned long const cpuCc, bool const ds) {
+void PSG::speedChange(cc_t const cpuCc, bool const ds) {
 	generateSamples(cpuCc, ds);
+	if (logging_)
+		log(sound_log::op_speed_change);
+
 	lastUpdate_ -= ds;
 	// correct for cycles since DIV reset (if any).
 	if (!ds) {
@@ -115,6 +139,9 @@ void PSG::saveState(SaveState &state) {
 }
 
 void PSG::loadState(SaveState const &state) {
+	// the writes below are covered by the state logged
+	bool const logging = logging_;
+	logging_ = false;
 	ch1_.loadState(state);
 	ch2_.loadState(state);
 	ch3_.loadState(state);
@@ -125,12 +152,29 @@ void PSG::loadState(SaveState const &state) {
 	setSoVolume(state.mem.ioamhram.get()[0x124]);
 	mapSo(state.mem.ioamhram.get()[0x125]);
 	enabled_ = state.mem.ioamhram.get()[0x126] >> 7 & 1;
+	logging_ = logging;
+	if (logging_)
+		logState(state);
+}
+
+namespace {
+
+// The channels write deltas to a sample buffer cleared for them, or add steps to the
+// synth, which needs no clearing. A 0 buffer takes no output at all.
+void clear(uint_least32_t *buf, std::size_t n) { std::memset(buf, 0, n * sizeof *buf); }
+void clear(BandLimitedSynth::StepWriter, std::size_t) {}
+bool takesOutput(uint_least32_t const *buf) { return buf; }
+bool takesOutput(BandLimitedSynth::StepWriter) { return true; }
+
 }
 
-inline void PSG::accumulateChannels(unsigned long const cycles) {
+template<class Out>
+inline void PSG::accumulateChannels(Out const buf, unsigned long const cycles) {
+	if (stems_[0])
+		return accumulateStems(buf, cycles);
+
 	unsigned long const cc = cycleCounter_;
-	uint_least32_t *const buf = buffer_ + bufferPos_;
-	std::memset(buf, 0, cycles * sizeof *buf);
+	clear(buf, cycles);
 	ch1_.update(buf, soVol_, cc, cc + cycles);
 	ch2_.update(buf, soVol_, cc, cc + cycles);
 	ch3_.update(buf, soVol_, cc, cc + cycles);
@@ -138,65 +182,269 @@ inline void PSG::accumulateChannels(unsigned long const cycles) {
 	cycleCounter_ = (cc + cycles) % SoundUnit::counter_max;
 }
 
-void PSG::generateSamples(unsigned long const cpuCc, bool const doubleSpeed) {
+namespace {
+
+// Writes the mean level of a channel over every decimation samples to its stem, given
+// the samples at which the level steps.
+class StemWriter {
+public:
+	StemWriter(uint_least16_t *stem, std::size_t pos, unsigned decimation, unsigned blockPos,
+	           unsigned long level, unsigned long sum)
+	: stem_(stem), pos_(pos), decimation_(decimation), blockPos_(blockPos)
+	, level_(level), sum_(sum), last_(0)
+	{
+	}
+
+	void step(std::size_t i, unsigned long delta) { advance(i); level_ += delta; }
+	void advance(std::size_t end);
+	std::size_t pos() const { return pos_; }
+	unsigned blockPos() const { return blockPos_; }
+	unsigned long level() const { return level_; }
+	unsigned long sum() const { return sum_; }
+
+private:
+	uint_least16_t *const stem_;
+	std::size_t pos_;
+	unsigned const decimation_;
+	unsigned blockPos_;
+	unsigned long level_;
+	unsigned long sum_;
+	std::size_t last_;
+};
+
+void StemWriter::advance(std::size_t const end) {
+	if (decimation_ == 1) {
+		std::fill(stem_ + pos_, stem_ + pos_ + (end - last_),
+		          static_cast<uint_least16_t>(level_ << 11 & 0xFFFF));
+		pos_ += end - last_;
+		last_ = end;
+		return;
+	}
+
+	while (end - last_ >= decimation_ - blockPos_) {
+		sum_ += level_ * (decimation_ - blockPos_);
+		last_ += decimation_ - blockPos_;
+		// sum_ is modulo 2^32, and the biased sum is 0 to 30 * decimation
+		unsigned long const biased = (sum_ + 15ul * decimation_) & 0xFFFFFFFF;
+		stem_[pos_++] = (biased / decimation_ * 0x800
+		               + biased % decimation_ * 0x800 / decimation_
+		               - 15 * 0x800) & 0xFFFF;
+		sum_ = 0;
+		blockPos_ = 0;
+	}
+
+	sum_ += level_ * (end - last_);
+	blockPos_ += end - last_;
+	last_ = end;
+}
+
+}
+
+// While stems are on, the channels write deltas of their level (their output with a
+// volume of 1 and all of NR51 set) to stemBuf_, a piece at a time. Since a channel's
+// output is its level times a volume that only changes between updates, the mixed
+// output is made from these, and is the same as without stems. buf may be 0 to only
+// produce the stems.
+template<class Out>
+void PSG::accumulateStems(Out buf, unsigned long cycles) {
+	while (cycles) {
+		unsigned long const cc = cycleCounter_;
+		unsigned long const n = std::min(cycles, 1ul * stem_chunk_len);
+		ch1_.update(stemBuf_[0], 1, cc, cc + n);
+		ch2_.update(stemBuf_[1], 1, cc, cc + n);
+		ch3_.update(stemBuf_[2], 1, cc, cc + n);
+		ch4_.update(stemBuf_[3], 1, cc, cc + n);
+		cycleCounter_ = (cc + n) % SoundUnit::counter_max;
+
+		if (takesOutput(buf)) {
+			clear(buf, n);
+			updateStems(buf, n);
+			buf += n;
+		} else
+			updateStems(buf, n);
+
+		cycles -= n;
+	}
+}
+
+// Takes the steps out of stemBuf_, leaving it cleared for the next update. Steps are few,
+// so stemBuf_ is scanned 8 samples at a time for them.
+template<class Out>
+void PSG::updateStems(Out const buf, std::size_t const n) {
+	for (int ch = 0; ch < num_channels; ++ch) {
+		uint_least32_t *const d = stemBuf_[ch];
+		unsigned long const vol = soVol_ & soMask_[ch];
+		StemWriter stem(stems_[ch], stemPos_, stemDecimation_, stemBlockPos_,
+		                stemLevel_[ch], stemSum_[ch]);
+		if (takesOutput(buf))
+			buf[0] += vol * stem.level() - stemMixOut_[ch];
+
+		for (std::size_t i = 0; i < n; i += 8) {
+			if (!(d[i] | d[i + 1] | d[i + 2] | d[i + 3] | d[i + 4] | d[i + 5] | d[i + 6] | d[i + 7]))
+				continue;
+
+			for (std::size_t j = i; j < i + 8; ++j) {
+				if (unsigned long const delta = d[j]) {
+					if (takesOutput(buf))
+						buf[j] += vol * delta;
+
+					stem.step(j, delta);
+					d[j] = 0;
+				}
+			}
+		}
+
+		stem.advance(n);
+		stemLevel_[ch] = stem.level();
+		stemSum_[ch] = stem.sum();
+		if (takesOutput(buf))
+			stemMixOut_[ch] = vol * stem.level();
+		if (ch == num_channels - 1) {
+			stemPos_ = stem.pos();
+			stemBlockPos_ = stem.blockPos();
+		}
+	}
+}
+
+void PSG::setStems(uint_least16_t *const *const stems, unsigned const decimation) {
+	bool const wasOn = stems_[0];
+	for (int ch = 0; ch < num_channels; ++ch)
+		stems_[ch] = stems ? stems[ch] : 0;
+
+	stemDecimation_ = std::min(std::max(decimation, 1u), 0x10000u);
+	stemBlockPos_ = 0;
+	stemPos_ = 0;
+	std::fill_n(stemSum_, 1 * num_channels, 0);
+
+	if (stems && !wasOn) {
+		// the channels continue from level 0, which the stems start from
+		stemMixOut_[0] = ch1_.output();
+		stemMixOut_[1] = ch2_.output();
+		stemMixOut_[2] = ch3_.output();
+		stemMixOut_[3] = ch4_.output();
+		std::fill_n(stemLevel_, 1 * num_channels, 0);
+		ch1_.setOutput(0);
+		ch2_.setOutput(0);
+		ch3_.setOutput(0);
+		ch4_.setOutput(0);
+		applySo();
+	} else if (!stems && wasOn) {
+		ch1_.setOutput(stemMixOut_[0]);
+		ch2_.setOutput(stemMixOut_[1]);
+		ch3_.setOutput(stemMixOut_[2]);
+		ch4_.setOutput(stemMixOut_[3]);
+		applySo();
+	}
+}
+
+void PSG::setSynthRate(long const rate) {
+	if (synth_.rate())
+		rsum_ = synth_.sum();
+
+	synth_.setRate(rate, rsum_);
+}
+
+// The channels add their steps to synth_ a piece at a time.
+void PSG::synthesize(unsigned long cycles) {
+	while (cycles) {
+		unsigned long const n = std::min(cycles, 1ul * BandLimitedSynth::max_steps_len);
+		accumulateChannels(BandLimitedSynth::StepWriter(synth_), n);
+		synth_.advance(n);
+		cycles -= n;
+	}
+}
+
+void PSG::generateSamples(cc_t const cpuCc, bool const doubleSpeed) {
 	unsigned long const cycles = (cpuCc - lastUpdate_) >> (1 + doubleSpeed);
 	lastUpdate_ += cycles << (1 + doubleSpeed);
+	logCc_ = cpuCc;
 
 	if (!(speedupFlags_ & GB::NO_SOUND)) {
-		if (cycles)
-			accumulateChannels(cycles);
+		if (synth_.rate())
+			synthesize(cycles);
+		else if (cycles)
+			accumulateChannels(buffer_ + bufferPos_, cycles);
+	} else {
+		if (stems_[0])
+			accumulateStems(static_cast<uint_least32_t *>(0), cycles);
+		if (synth_.rate())
+			synth_.advance(cycles);
 	}
 
 	bufferPos_ += cycles;
 }
 
-void PSG::resetCounter(unsigned long newCc, unsigned long oldCc, bool doubleSpeed) {
+void PSG::resetCounter(cc_t newCc, cc_t oldCc, bool doubleSpeed) {
 	generateSamples(oldCc, doubleSpeed);
 	lastUpdate_ = newCc - (oldCc - lastUpdate_);
+	if (logging_) {
+		log(sound_log::op_reset_counter);
+		sound_log::putNumber(log_, oldCc - newCc);
+		logCc_ = loggedCc_ = newCc;
+	}
 }
 
 std::size_t PSG::fillBuffer() {
-	uint_least32_t sum = rsum_;
-	uint_least32_t *b = buffer_;
-	std::size_t n = bufferPos_;
-
-	if (std::size_t n2 = n >> 3) {
-		n -= n2 << 3;
-
-		do {
-			sum += b[0];
-			b[0] = sum ^ 0x8000;
-			sum += b[1];
-			b[1] = sum ^ 0x8000;
-			sum += b[2];
-			b[2] = sum ^ 0x8000;
-			sum += b[3];
-			b[3] = sum ^ 0x8000;
-			sum += b[4];
-			b[4] = sum ^ 0x8000;
-			sum += b[5];
-			b[5] = sum ^ 0x8000;
-			sum += b[6];
-			b[6] = sum ^ 0x8000;
-			sum += b[7];
-			b[7] = sum ^ 0x8000;
-
-			b += 8;
-		} while (--n2);
-	}
+	if (logging_)
+		log(sound_log::op_time);
 
-	while (n--) {
-		sum += *b;
-		// xor away the initial rsum value of 0x8000 (which prevents
-		// borrows from the high word) from the low word
-		*b++ = sum ^ 0x8000;
-	}
+	// with NO_SOUND nothing was accumulated, and buffer_ may be 0
+	if (synth_.rate() || (speedupFlags_ & GB::NO_SOUND))
+		return bufferPos_;
 
-	rsum_ = sum;
+	// xor away the initial rsum value of 0x8000 (which prevents
+	// borrows from the high word) from the low word
+	rsum_ = prefixSum(buffer_, bufferPos_, rsum_);
 
 	return bufferPos_;
 }
 
+void PSG::log(sound_log::Op const op) {
+	log_.push_back(op);
+	sound_log::putNumber(log_, logCc_ - loggedCc_);
+	loggedCc_ = logCc_;
+}
+
+// PSG::loadState sets lastUpdate_ to a time before the cpu cycle counter given by
+// spu.lastUpdate, which is its low bits plus one, so that the state is put with the
+// counter that gives back lastUpdate_.
+void PSG::startLog(SaveState &state) {
+	setStatePtrs(state);
+	saveState(state);
+	state.cpu.cycleCounter = lastUpdate_ + (0 - lastUpdate_) % 4;
+	log_.resize(logRecordPos_);
+	logging_ = true;
+	logState(state);
+}
+
+void PSG::logState(SaveState const &state) {
+	log_.push_back(sound_log::op_state);
+	sound_log::putState(log_, state, ch3_.isCgb(), ch3_.waveRam(), lastUpdate_);
+	logCc_ = loggedCc_ = lastUpdate_;
+}
+
+// The bytes read are only dropped from log_ once they are at least half of it, so that
+// reading the log in small pieces does not move the rest of it every time.
+std::size_t PSG::readLog(char *const dest, std::size_t size) {
+	size = std::min(size, log_.size() - logReadPos_);
+	std::copy(log_.begin() + logReadPos_, log_.begin() + logReadPos_ + size, dest);
+	logReadPos_ += size;
+
+	unsigned char const *const begin = log_.empty() ? 0 : &log_[0];
+	unsigned char const *record = begin + logRecordPos_;
+	while (record < begin + logReadPos_)
+		sound_log::skipRecord(record, begin + log_.size());
+
+	logRecordPos_ = record - begin;
+	if (logReadPos_ * 2 >= log_.size()) {
+		log_.erase(log_.begin(), log_.begin() + logReadPos_);
+		logRecordPos_ -= logReadPos_;
+		logReadPos_ = 0;
+	}
+
+	return size;
+}
+
 static bool isBigEndianSampleOrder() {
 	union {
 		uint_least32_t ul32;
@@ -210,16 +458,28 @@ static unsigned long so1Mul() { return isBigEndianSampleOrder() ? 0x00000001 : 0
 static unsigned long so2Mul() { return isBigEndianSampleOrder() ? 0x00010000 : 0x00000001; }
 
 void PSG::setSoVolume(unsigned nr50) {
+	logWrite(0x24, nr50);
 	soVol_ = ((nr50      & 0x7) + 1) * so1Mul() * 64
 	       + ((nr50 >> 4 & 0x7) + 1) * so2Mul() * 64;
 }
 
 void PSG::mapSo(unsigned nr51) {
+	logWrite(0x25, nr51);
 	unsigned long so = nr51 * so1Mul() + (nr51 >> 4) * so2Mul();
-	ch1_.setSo((so      & 0x00010001) * 0xFFFF, cycleCounter_);
-	ch2_.setSo((so >> 1 & 0x00010001) * 0xFFFF, cycleCounter_);
-	ch3_.setSo((so >> 2 & 0x00010001) * 0xFFFF);
-	ch4_.setSo((so >> 3 & 0x00010001) * 0xFFFF, cycleCounter_);
+	for (int ch = 0; ch < num_channels; ++ch)
+		soMask_[ch] = (so >> ch & 0x00010001) * 0xFFFF;
+
+	applySo();
+}
+
+// With stems on, every channel is mapped to both outputs, for its level, and NR51 is
+// applied when mixing.
+void PSG::applySo() {
+	unsigned long const all = 0xFFFFFFFF;
+	ch1_.setSo(stems_[0] ? all : soMask_[0], cycleCounter_);
+	ch2_.setSo(stems_[0] ? all : soMask_[1], cycleCounter_);
+	ch3_.setSo(stems_[0] ? all : soMask_[2]);
+	ch4_.setSo(stems_[0] ? all : soMask_[3], cycleCounter_);
 }
 
 unsigned PSG::getStatus() const {
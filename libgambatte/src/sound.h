@@ -23,6 +23,8 @@
 #include "sound/channel2.h"
 #include "sound/channel3.h"
 #include "sound/channel4.h"
+#include "sound/band_limited_synth.h"
+#include "sound/sound_log.h"
 
 namespace gambatte {
 
@@ -36,38 +38,78 @@ public:
 	void saveState(SaveState &state);
 	void loadState(SaveState const &state);
 
-	void generateSamples(unsigned long cycleCounter, bool doubleSpeed);
-	void resetCounter(unsigned long newCc, unsigned long oldCc, bool doubleSpeed);
-	void speedChange(unsigned long cc, bool doubleSpeed);
+	void generateSamples(cc_t cycleCounter, bool doubleSpeed);
+	void resetCounter(cc_t newCc, cc_t oldCc, bool doubleSpeed);
+	void speedChange(cc_t cc, bool doubleSpeed);
 	std::size_t fillBuffer();
-	void setBuffer(uint_least32_t *buf) { buffer_ = buf; bufferPos_ = 0; }
+	void setBuffer(uint_least32_t *buf) { buffer_ = buf; bufferPos_ = 0; stemPos_ = 0; }
+
+	// With a rate other than 0, samples are synthesized at that rate to be read with
+	// readSynthSamples, and the buffer is left alone.
+	void setSynthRate(long rate);
+	std::size_t readSynthSamples(uint_least32_t *dest, std::size_t maxSamples) {
+		return synth_.read(dest, maxSamples);
+	}
+
+	// With stems other than 0, the output of each channel, before NR50/NR51 mixing, is also
+	// written to stems[0] to stems[3] as the mean of every decimation samples, starting over
+	// at setBuffer.
+	void setStems(uint_least16_t *const *stems, unsigned decimation);
+	std::size_t stemSamples() const { return stemPos_; }
+
+	// While logging, the calls that change the state of the PSG are recorded, with their
+	// timing, to a log (see sound/sound_log.h) that a PSG can replay. Starting the log
+	// puts the current state in it, which needs a state with ioamhram set. Starting and
+	// stopping drop what is not read yet, but for the rest of a record partly read, so
+	// that what is read stays whole records.
+	void startLog(SaveState &state);
+	void stopLog() { logging_ = false; log_.resize(logRecordPos_); }
+	std::size_t readLog(char *dest, std::size_t size);
+	// Past max_log_size bytes not read, the log is to be started over.
+	bool logFull() const { return logging_ && log_.size() - logReadPos_ > max_log_size; }
+	enum { max_log_size = 0x100000 };
+	std::size_t bufferPos() const { return bufferPos_; }
 
 	bool isEnabled() const { return enabled_; }
-	void setEnabled(bool value) { enabled_ = value; }
-
-	void setNr10(unsigned data) { ch1_.setNr0(data); }
-	void setNr11(unsigned data) { ch1_.setNr1(data, cycleCounter_); }
-	void setNr12(unsigned data) { ch1_.setNr2(data, cycleCounter_); }
-	void setNr13(unsigned data) { ch1_.setNr3(data, cycleCounter_); }
-	void setNr14(unsigned data, bool ds) { ch1_.setNr4(data, cycleCounter_, !(lastUpdate_ & ds)); }
-
-	void setNr21(unsigned data) { ch2_.setNr1(data, cycleCounter_); }
-	void setNr22(unsigned data) { ch2_.setNr2(data, cycleCounter_); }
-	void setNr23(unsigned data) { ch2_.setNr3(data, cycleCounter_); }
-	void setNr24(unsigned data, bool ds) { ch2_.setNr4(data, cycleCounter_, !(lastUpdate_ & ds)); }
-
-	void setNr30(unsigned data) { ch3_.setNr0(data); }
-	void setNr31(unsigned data) { ch3_.setNr1(data, cycleCounter_); }
-	void setNr32(unsigned data) { ch3_.setNr2(data); }
-	void setNr33(unsigned data) { ch3_.setNr3(data); }
-	void setNr34(unsigned data) { ch3_.setNr4(data, cycleCounter_); }
+	void setEnabled(bool value) {
+		if (logging_)
+			log(value ? sound_log::op_enable : sound_log::op_disable);
+
+		enabled_ = value;
+	}
+
+	void setNr10(unsigned data) { logWrite(0x10, data); ch1_.setNr0(data); }
+	void setNr11(unsigned data) { logWrite(0x11, data); ch1_.setNr1(data, cycleCounter_); }
+	void setNr12(unsigned data) { logWrite(0x12, data); ch1_.setNr2(data, cycleCounter_); }
+	void setNr13(unsigned data) { logWrite(0x13, data); ch1_.setNr3(data, cycleCounter_); }
+	void setNr14(unsigned data, bool ds) {
+		logWrite(0x14, data);
+		ch1_.setNr4(data, cycleCounter_, !(lastUpdate_ & ds));
+	}
+
+	void setNr21(unsigned data) { logWrite(0x16, data); ch2_.setNr1(data, cycleCounter_); }
+	void setNr22(unsigned data) { logWrite(0x17, data); ch2_.setNr2(data, cycleCounter_); }
+	void setNr23(unsigned data) { logWrite(0x18, data); ch2_.setNr3(data, cycleCounter_); }
+	void setNr24(unsigned data, bool ds) {
+		logWrite(0x19, data);
+		ch2_.setNr4(data, cycleCounter_, !(lastUpdate_ & ds));
+	}
+
+	void setNr30(unsigned data) { logWrite(0x1A, data); ch3_.setNr0(data); }
+	void setNr31(unsigned data) { logWrite(0x1B, data); ch3_.setNr1(data, cycleCounter_); }
+	void setNr32(unsigned data) { logWrite(0x1C, data); ch3_.setNr2(data); }
+	void setNr33(unsigned data) { logWrite(0x1D, data); ch3_.setNr3(data); }
+	void setNr34(unsigned data) { logWrite(0x1E, data); ch3_.setNr4(data, cycleCounter_); }
 	unsigned waveRamRead(unsigned index) const { return ch3_.waveRamRead(index, cycleCounter_); }
-	void waveRamWrite(unsigned index, unsigned data) { ch3_.waveRamWrite(index, data, cycleCounter_); }
+	void waveRamWrite(unsigned index, unsigned data) {
+		logWrite(0x30 + index, data);
+		ch3_.waveRamWrite(index, data, cycleCounter_);
+	}
 
-	void setNr41(unsigned data) { ch4_.setNr1(data, cycleCounter_); }
-	void setNr42(unsigned data) { ch4_.setNr2(data, cycleCounter_); }
-	void setNr43(unsigned data) { ch4_.setNr3(data, cycleCounter_); }
-	void setNr44(unsigned data) { ch4_.setNr4(data, cycleCounter_); }
+	void setNr41(unsigned data) { logWrite(0x20, data); ch4_.setNr1(data, cycleCounter_); }
+	void setNr42(unsigned data) { logWrite(0x21, data); ch4_.setNr2(data, cycleCounter_); }
+	void setNr43(unsigned data) { logWrite(0x22, data); ch4_.setNr3(data, cycleCounter_); }
+	void setNr44(unsigned data) { logWrite(0x23, data); ch4_.setNr4(data, cycleCounter_); }
 
 	void setSoVolume(unsigned nr50);
 	void mapSo(unsigned nr51);
@@ -80,9 +122,10 @@ private:
 	Channel2 ch2_;
 	Channel3 ch3_;
 	Channel4 ch4_;
+	BandLimitedSynth synth_;
 	uint_least32_t *buffer_;
 	std::size_t bufferPos_;
-	unsigned long lastUpdate_;
+	cc_t lastUpdate_;
 	unsigned long cycleCounter_;
 	unsigned long soVol_;
 	uint_least32_t rsum_;
@@ -90,7 +133,42 @@ private:
 
 	unsigned speedupFlags_;
 
-	void accumulateChannels(unsigned long cycles);
+	enum { num_channels = 4, stem_chunk_len = 0x400 };
+	uint_least16_t *stems_[num_channels];
+	unsigned long soMask_[num_channels];
+	// Per channel, its level (-15 to 15 modulo 2^32) and its contribution to the mixed
+	// output, as the channels write deltas of the level while stems are on.
+	unsigned long stemLevel_[num_channels];
+	unsigned long stemMixOut_[num_channels];
+	unsigned long stemSum_[num_channels];
+	unsigned stemDecimation_;
+	unsigned stemBlockPos_;
+	std::size_t stemPos_;
+	uint_least32_t stemBuf_[num_channels][stem_chunk_len];
+
+	std::vector<unsigned char> log_;
+	// the bytes of log_ read, and the end of the record the next one read is in
+	std::size_t logReadPos_;
+	std::size_t logRecordPos_;
+	// the time of the last generateSamples call, and of the last record in log_
+	cc_t logCc_;
+	cc_t loggedCc_;
+	bool logging_;
+
+	void log(sound_log::Op op);
+	void logWrite(unsigned reg, unsigned data) {
+		if (logging_) {
+			log(static_cast<sound_log::Op>(sound_log::op_write + reg - 0x10));
+			log_.push_back(data);
+		}
+	}
+	void logState(SaveState const &state);
+
+	template<class Out> void accumulateChannels(Out buf, unsigned long cycles);
+	template<class Out> void accumulateStems(Out buf, unsigned long cycles);
+	template<class Out> void updateStems(Out buf, std::size_t n);
+	void applySo();
+	void synthesize(unsigned long cycles);
 };
 
 }
@@ -0,0 +1,193 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#include "band_limited_synth.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace gambatte;
+
+namespace {
+
+double const pi = 3.14159265358979323846;
+
+// Kaiser window shape, for about 75 dB less of a tone aliased (see test/synthcheck.cpp)
+double const kaiser_beta = 9.0;
+// cutoff, as a fraction of the output rate, where the response is 6 dB down. The stop
+// band starts at about half the output rate, so little aliases into what can be heard.
+double const cutoff = 0.43;
+
+// Integrals are kept offset by this, so that they stay positive.
+unsigned long const integral_bias = 0x80000000ul;
+
+// signed value of the low 16 bits of sample
+long lowHalf(uint_least32_t sample) { return static_cast<long>(sample & 0xFFFF) - (sample & 0x8000) * 2l; }
+long highHalf(uint_least32_t sample) { return lowHalf(sample >> 16); }
+
+unsigned long toSample(uint_least32_t integral, int unitBits) {
+	long const s = static_cast<long>((integral & 0xFFFFFFFFul) >> unitBits)
+	             - static_cast<long>(integral_bias >> unitBits);
+	return std::min(std::max(s, -0x8000l), 0x7FFFl) & 0xFFFF;
+}
+
+// zeroth order modified Bessel function of the first kind
+double i0(double x) {
+	double sum = 1, term = 1;
+	for (int k = 1; term > sum * 1e-12; ++k) {
+		term *= x * x / (4.0 * k * k);
+		sum += term;
+	}
+
+	return sum;
+}
+
+} // anon namespace
+
+double BandLimitedSynth::impulse(double const x) {
+	double const r = x / delay;
+	if (r <= -1 || r >= 1)
+		return 0;
+
+	double const w = i0(kaiser_beta * std::sqrt(1 - r * r)) / i0(kaiser_beta);
+	return w * (x == 0 ? 2 * cutoff : std::sin(2 * pi * cutoff * x) / (pi * x));
+}
+
+BandLimitedSynth::BandLimitedSynth()
+: sum_(0x8000)
+, rate_(0)
+, phase_(0)
+, outPos_(0)
+, readPos_(0)
+{
+	// The impulse is at delay output samples (minus the phase) before the last tap. The
+	// last phase is the first one a sample later, for steps between the last two.
+	for (int p = 0; p <= num_phases; ++p) {
+		double h[kernel_len];
+		double sum = 0;
+		for (int t = 0; t < kernel_len; ++t) {
+			h[t] = impulse(t + 1 - delay - 1.0 * p / num_phases);
+			sum += h[t];
+		}
+
+		// Rounding the step rather than each tap keeps it within half a unit of where it
+		// should be, and makes the taps add up to kernel_unit.
+		double level = 0;
+		for (int t = 0; t < kernel_len; ++t) {
+			level += h[t] / sum;
+			steps_[p][t] = static_cast<uint_least32_t>(std::floor((level + 1) * kernel_unit + 0.5));
+		}
+	}
+
+	integral_[0] = integral_[1] = integral_bias;
+}
+
+void BandLimitedSynth::setRate(long const rate, uint_least32_t const sum) {
+	rate_ = std::min(std::max(rate, 0l), 1l * max_rate);
+	std::vector<uint_least32_t>(rate_ ? 2 * ring_size : 0, 0).swap(buf_);
+	sum_ = sum;
+	phase_ = 0;
+	outPos_ = readPos_ = 0;
+
+	uint_least32_t const out = sum ^ 0x8000;
+	integral_[0] = integral_bias + kernel_unit / 2 + static_cast<unsigned long>(lowHalf(out)) * kernel_unit;
+	integral_[1] = integral_bias + kernel_unit / 2 + static_cast<unsigned long>(highHalf(out)) * kernel_unit;
+}
+
+void BandLimitedSynth::step(std::size_t const i, unsigned long const delta) {
+	sum_ += delta;
+
+	// Each channel's delta has halves well within 16 bits, so they can be told apart
+	// without the running sum. That also lets the channels add their steps in any order.
+	long const low = lowHalf(delta);
+	uint_least32_t const dlow = low;
+	uint_least32_t const dhigh = highHalf(delta - low);
+	// The step interpolated between the two phases around it, rounded, with the taps taken
+	// from that.
+	unsigned long const pos = phase_ + i * rate_;
+	unsigned const phase = pos >> (psg_rate_bits - phase_bits) & (num_phases - 1);
+	uint_least32_t const frac = pos >> (psg_rate_bits - phase_bits - frac_bits) & ((1 << frac_bits) - 1);
+	uint_least32_t const *const s0 = steps_[phase];
+	uint_least32_t const *const s1 = steps_[phase + 1];
+	uint_least32_t step[kernel_len + 1];
+	step[0] = kernel_unit;
+	for (int t = 0; t < kernel_len; ++t)
+		step[t + 1] = (((s0[t] << frac_bits) + (s1[t] - s0[t]) * frac + (1 << (frac_bits - 1))) & 0xFFFFFFFF) >> frac_bits;
+
+	uint_least32_t kernel[kernel_len];
+	for (int t = 0; t < kernel_len; ++t)
+		kernel[t] = step[t + 1] - step[t];
+
+	std::size_t const at = (outPos_ + (pos >> psg_rate_bits) + 1) & (ring_size - 1);
+	if (at + kernel_len <= ring_size) {
+		uint_least32_t *const b = &buf_[2 * at];
+		for (int t = 0; t < kernel_len; ++t) {
+			b[2 * t    ] += dlow  * kernel[t];
+			b[2 * t + 1] += dhigh * kernel[t];
+		}
+	} else {
+		for (int t = 0; t < kernel_len; ++t) {
+			std::size_t const j = (at + t) & (ring_size - 1);
+			buf_[2 * j    ] += dlow  * kernel[t];
+			buf_[2 * j + 1] += dhigh * kernel[t];
+		}
+	}
+}
+
+void BandLimitedSynth::advance(std::size_t n) {
+	for (; n > max_steps_len; n -= max_steps_len)
+		advance(max_steps_len);
+
+	unsigned long const pos = phase_ + n * rate_;
+	outPos_ += pos >> psg_rate_bits;
+	phase_ = pos & (psg_rate - 1);
+
+	// The steps of the next max_steps_len PSG samples go up to kernel_len samples past
+	// the less than max_steps_len / 2 output samples they span, which must not reach the
+	// samples kept.
+	if (outPos_ - readPos_ > max_samples)
+		integrate(0, outPos_ - readPos_ - max_samples);
+}
+
+// Takes n samples from the read position, putting them in dest unless it is 0, and
+// clears their place in buf_ for new steps.
+void BandLimitedSynth::integrate(uint_least32_t *dest, std::size_t n) {
+	int const unitBits = 15;
+	while (n) {
+		std::size_t const at = readPos_ & (ring_size - 1);
+		std::size_t const len = std::min(n, ring_size - at);
+		uint_least32_t *const b = &buf_[2 * at];
+		for (std::size_t i = 0; i < len; ++i) {
+			integral_[0] += b[2 * i];
+			integral_[1] += b[2 * i + 1];
+			if (dest)
+				dest[i] = toSample(integral_[0], unitBits) | toSample(integral_[1], unitBits) << 16;
+		}
+
+		std::fill(b, b + 2 * len, 0);
+		readPos_ += len;
+		n -= len;
+		if (dest)
+			dest += len;
+	}
+}
+
+std::size_t BandLimitedSynth::read(uint_least32_t *const dest, std::size_t const maxSamples) {
+	std::size_t const n = std::min(maxSamples, samplesAvailable());
+	integrate(dest, n);
+	return n;
+}
@@ -0,0 +1,126 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef BAND_LIMITED_SYNTH_H
+#define BAND_LIMITED_SYNTH_H
+
+#include "gbint.h"
+#include <cstddef>
+#include <vector>
+
+namespace gambatte {
+
+// Turns the steps of the PSG output into stereo samples at a lower rate, by adding a
+// band-limited step (from a windowed sinc kernel) to the output for each of them, rather
+// than producing every PSG sample and resampling those. The channels add their steps
+// through a StepWriter, which takes the place of the sample buffer they write deltas to.
+class BandLimitedSynth {
+public:
+	enum { psg_rate = 0x200000, max_rate = psg_rate / 2 - 1 };
+	enum { max_steps_len = 0x800 };
+	// The most samples kept for read. Older ones are dropped to make room for new ones.
+	enum { max_samples = 0x7800 };
+	// The output lags the PSG by this many output samples, half the kernel.
+	enum { delay = 16 };
+
+	class StepWriter;
+
+	BandLimitedSynth();
+	long rate() const { return rate_; }
+
+	// Sets the output rate (up to max_rate), dropping any samples not read yet, and starts
+	// from the output level of running sum sum (that of PSG::fillBuffer). 0 disables the
+	// synth.
+	void setRate(long rate, uint_least32_t sum);
+
+	// The running sum, with the steps added so far.
+	uint_least32_t sum() const { return sum_; }
+
+	// Adds a step of delta, as the channels write them to the sample buffer, at PSG sample
+	// i (below max_steps_len) from the current position.
+	void addStep(std::size_t i, unsigned long delta) {
+		if (delta & 0xFFFFFFFF)
+			step(i, delta);
+	}
+
+	// Moves n PSG samples ahead, past the steps added.
+	void advance(std::size_t n);
+
+	std::size_t samplesAvailable() const { return outPos_ - readPos_; }
+
+	// Reads up to maxSamples of the samples available, in the format of PSG::fillBuffer.
+	std::size_t read(uint_least32_t *dest, std::size_t maxSamples);
+
+	// The band-limited impulse that the kernel is made from, x output samples from its
+	// center. 0 at delay output samples or more.
+	static double impulse(double x);
+
+private:
+	enum { phase_bits = 7, num_phases = 1 << phase_bits, frac_bits = 8 };
+	enum { kernel_len = 2 * delay, kernel_unit = 0x8000 };
+	enum { psg_rate_bits = 21 };
+	enum { ring_size = 0x8000 };
+
+	// Band-limited step per phase, offset by kernel_unit, going from 0 before the first tap
+	// to kernel_unit at the last, with frac_bits more of phase interpolated between them.
+	// Taps, its deltas, go to the kernel_len samples after the one a step lands in.
+	uint_least32_t steps_[num_phases + 1][kernel_len];
+	// Per output sample, modulo ring_size, deltas of kernel_unit times the two 16-bit
+	// halves of the output, modulo 2^32 since only their running sums need to be in range.
+	std::vector<uint_least32_t> buf_;
+	uint_least32_t integral_[2];
+	uint_least32_t sum_;
+	long rate_;
+	// The output position of the next PSG sample is outPos_ + phase_ / psg_rate.
+	unsigned long phase_;
+	std::size_t outPos_;
+	std::size_t readPos_;
+
+	void step(std::size_t i, unsigned long delta);
+	void integrate(uint_least32_t *dest, std::size_t n);
+};
+
+// Stands in for the uint_least32_t * that the channels write deltas through (see
+// Channel1::update), adding them as steps instead: *w += delta and w[k] += delta add a
+// step where the pointer would have written, w += k moves k PSG samples ahead.
+class BandLimitedSynth::StepWriter {
+public:
+	class Step {
+	public:
+		Step(BandLimitedSynth &synth, std::size_t i) : synth_(synth), i_(i) {}
+		void operator+=(unsigned long delta) const { synth_.addStep(i_, delta); }
+		void operator=(unsigned long delta) const { synth_.addStep(i_, delta); }
+
+	private:
+		BandLimitedSynth &synth_;
+		std::size_t const i_;
+	};
+
+	explicit StepWriter(BandLimitedSynth &synth) : synth_(&synth), i_(0) {}
+	Step operator*() const { return Step(*synth_, i_); }
+	Step operator[](std::size_t k) const { return Step(*synth_, i_ + k); }
+	StepWriter & operator+=(std::size_t k) { i_ += k; return *this; }
+
+private:
+	BandLimitedSynth *synth_;
+	std::size_t i_;
+};
+
+}
+
+#endif
@@ -17,6 +17,7 @@
 //
 
 #include "channel1.h"
+#include "band_limited_synth.h"
 #include "psgdef.h"
 #include "../savestate.h"
 
@@ -206,7 +207,8 @@ void Channel1::loadState(SaveState const &state) {
 	master_ = state.spu.ch1.master;
 }
 
-void Channel1::update(uint_least32_t *buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
+template<class Out>
+void Channel1::update(Out buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
 	unsigned long const outBase = envelopeUnit_.dacIsOn() ? soBaseVol & soMask_ : 0;
 	unsigned long const outLow = outBase * -15;
 
@@ -244,3 +246,6 @@ void Channel1::update(uint_least32_t *buf, unsigned long const soBaseVol, unsign
 		sweepUnit_.resetCounters(cc);
 	}
 }
+
+template void Channel1::update(uint_least32_t *, unsigned long, unsigned long, unsigned long);
+template void Channel1::update(BandLimitedSynth::StepWriter, unsigned long, unsigned long, unsigned long);
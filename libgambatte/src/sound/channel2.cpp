@@ -17,6 +17,7 @@
 //
 
 #include "channel2.h"
+#include "band_limited_synth.h"
 #include "psgdef.h"
 #include "../savestate.h"
 
@@ -109,7 +110,8 @@ void Channel2::loadState(SaveState const &state) {
 	master_ = state.spu.ch2.master;
 }
 
-void Channel2::update(uint_least32_t *buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
+template<class Out>
+void Channel2::update(Out buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
 	unsigned long const outBase = envelopeUnit_.dacIsOn() ? soBaseVol & soMask_ : 0;
 	unsigned long const outLow = outBase * -15;
 
@@ -146,3 +148,6 @@ void Channel2::update(uint_least32_t *buf, unsigned long const soBaseVol, unsign
 		envelopeUnit_.resetCounters(cc);
 	}
 }
+
+template void Channel2::update(uint_least32_t *, unsigned long, unsigned long, unsigned long);
+template void Channel2::update(BandLimitedSynth::StepWriter, unsigned long, unsigned long, unsigned long);
@@ -38,7 +38,10 @@ public:
 	void setNr4(unsigned data, unsigned long cc, unsigned long ref);
 	void setSo(unsigned long soMask, unsigned long cc);
 	bool isActive() const { return master_; }
-	void update(uint_least32_t *buf, unsigned long soBaseVol, unsigned long cc, unsigned long end);
+	template<class Out>
+	void update(Out buf, unsigned long soBaseVol, unsigned long cc, unsigned long end);
+	unsigned long output() const { return prevOut_; }
+	void setOutput(unsigned long out) { prevOut_ = out; }
 	void reset();
 	void resetCc(unsigned long cc, unsigned long ncc) { dutyUnit_.resetCc(cc, ncc); }
 	void saveState(SaveState &state, unsigned long cc);
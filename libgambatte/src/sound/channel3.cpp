@@ -17,6 +17,7 @@
 //
 
 #include "channel3.h"
+#include "band_limited_synth.h"
 #include "psgdef.h"
 #include "../savestate.h"
 
@@ -142,7 +143,8 @@ void Channel3::updateWaveCounter(unsigned long const cc) {
 	}
 }
 
-void Channel3::update(uint_least32_t *buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
+template<class Out>
+void Channel3::update(Out buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
 	unsigned long const outBase = nr0_ ? soBaseVol & soMask_ : 0;
 
 	if (outBase && rshift_ != 4) {
@@ -212,3 +214,6 @@ void Channel3::update(uint_least32_t *buf, unsigned long const soBaseVol, unsign
 			waveCounter_ -= SoundUnit::counter_max;
 	}
 }
+
+template void Channel3::update(uint_least32_t *, unsigned long, unsigned long, unsigned long);
+template void Channel3::update(BandLimitedSynth::StepWriter, unsigned long, unsigned long, unsigned long);
@@ -32,6 +32,7 @@ public:
 	Channel3();
 	bool isActive() const { return master_; }
 	bool isCgb() const { return cgb_; }
+	unsigned char const * waveRam() const { return waveRam_; }
 	void reset();
 	void resetCc(unsigned long cc, unsigned long newCc);
 	void init(bool cgb);
@@ -44,7 +45,10 @@ public:
 	void setNr3(unsigned data) { nr3_ = data; }
 	void setNr4(unsigned data, unsigned long cc);
 	void setSo(unsigned long soMask);
-	void update(uint_least32_t *buf, unsigned long soBaseVol, unsigned long cc, unsigned long end);
+	template<class Out>
+	void update(Out buf, unsigned long soBaseVol, unsigned long cc, unsigned long end);
+	unsigned long output() const { return prevOut_; }
+	void setOutput(unsigned long out) { prevOut_ = out; }
 
 	unsigned waveRamRead(unsigned index, unsigned long cc) const {
 		if (master_) {
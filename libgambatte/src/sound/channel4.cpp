@@ -17,6 +17,8 @@
 //
 
 #include "channel4.h"
+#include "band_limited_synth.h"
+#include "lfsr_table.h"
 #include "psgdef.h"
 #include "../savestate.h"
 
@@ -38,6 +40,15 @@ unsigned long toPeriod(unsigned const nr3) {
 	return r << s;
 }
 
+bool isSevenBit(unsigned const nr3) {
+	return nr3 & psg_nr43_7biten;
+}
+
+// the two highest clock shifts leave the LFSR as it is
+bool isShifting(unsigned const nr3) {
+	return nr3 < 0xE * (1u * psg_nr43_s & -psg_nr43_s);
+}
+
 }
 
 Channel4::Lfsr::Lfsr()
@@ -54,22 +65,18 @@ void Channel4::Lfsr::updateBackupCounter(unsigned long const cc) {
 		unsigned long periods = (cc - backupCounter_) / period + 1;
 		backupCounter_ += periods * period;
 
-		if (master_ && nr3_ < 0xE * (1u * psg_nr43_s & -psg_nr43_s)) {
-			if (nr3_ & psg_nr43_7biten) {
-				while (periods > 6) {
-					unsigned const xored = (reg_ << 1 ^ reg_) & 0x7E;
-					reg_ = (reg_ >> 6 & ~0x7Eu) | xored | xored << 8;
-					periods -= 6;
-				}
-
-				unsigned const xored = ((reg_ ^ reg_ >> 1) << (7 - periods)) & 0x7F;
-				reg_ = (reg_ >> periods & ~(0x80u - (0x80 >> periods))) | xored | xored << 8;
+		if (master_ && isShifting(nr3_)) {
+			if (isSevenBit(nr3_)) {
+				reg_ = lfsr_table::advance7(reg_, periods);
 			} else {
-				while (periods > 15) {
+				// 15 periods at a time are taken as xoring reg_ with itself shifted right by one,
+				// which leaves bit 14 off from what 15 single shifts give, but is what the
+				// output has always been. Since that repeats every 16 times, only up to 15 are
+				// done.
+				for (unsigned long n = (periods - 1) / 15 % 16; n; --n)
 					reg_ = reg_ ^ reg_ >> 1;
-					periods -= 15;
-				}
 
+				periods = (periods - 1) % 15 + 1;
 				reg_ = reg_ >> periods | (((reg_ ^ reg_ >> 1) << (15 - periods)) & 0x7FFF);
 			}
 		}
@@ -82,17 +89,47 @@ void Channel4::Lfsr::reviveCounter(unsigned long cc) {
 }
 
 inline void Channel4::Lfsr::event() {
-	if (nr3_ < 0xE * (1u * psg_nr43_s & -psg_nr43_s)) {
-		unsigned const shifted = reg_ >> 1;
-		unsigned const xored = (reg_ ^ shifted) & 1;
-		reg_ = shifted | xored << 14;
+	if (isShifting(nr3_))
+		reg_ = lfsr_table::shift(reg_, isSevenBit(nr3_));
 
-		if (nr3_ & psg_nr43_7biten)
-			reg_ = (reg_ & ~0x40u) | xored << 6;
+	counter_ += toPeriod(nr3_);
+	backupCounter_ = counter_;
+}
+
+inline unsigned long Channel4::Lfsr::period() const {
+	return toPeriod(nr3_);
+}
+
+// Does a block of the events from counter_ on, up to end, which counter_ must not be after.
+// Returns a mask of the events that change the output, bit i for the one at counter_ + i * period
+// before the call.
+inline unsigned Channel4::Lfsr::run(unsigned long const end) {
+	unsigned long const period = toPeriod(nr3_);
+	if (!isShifting(nr3_)) {
+		counter_ += ((end - counter_) / period + 1) * period;
+		backupCounter_ = counter_;
+		return 0;
 	}
 
-	counter_ += toPeriod(nr3_);
+	bool const sevenBit = isSevenBit(nr3_);
+	unsigned n = 1;
+	unsigned changes = 0;
+	if (reg_ > 0x7FFF) {
+		// only a loaded state has bit 15 set, which one shift clears
+		changes = lfsr_table::changes(reg_, n);
+		reg_ = lfsr_table::shift(reg_, sevenBit);
+	} else {
+		n = sevenBit ? 1u * lfsr_table::max_shifts7 : 1u * lfsr_table::max_shifts15;
+		if ((n - 1) * period > end - counter_)
+			n = (end - counter_) / period + 1;
+
+		changes = lfsr_table::changes(reg_, n);
+		reg_ = lfsr_table::shifts(reg_, sevenBit, n);
+	}
+
+	counter_ += n * period;
 	backupCounter_ = counter_;
+	return changes;
 }
 
 void Channel4::Lfsr::nr3Change(unsigned newNr3, unsigned long cc) {
@@ -223,7 +260,8 @@ void Channel4::loadState(SaveState const &state) {
 	master_ = state.spu.ch4.master;
 }
 
-void Channel4::update(uint_least32_t *buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
+template<class Out>
+void Channel4::update(Out buf, unsigned long const soBaseVol, unsigned long cc, unsigned long const end) {
 	unsigned long const outBase = envelopeUnit_.dacIsOn() ? soBaseVol & soMask_ : 0;
 	unsigned long const outLow = outBase * -15;
 
@@ -233,13 +271,29 @@ void Channel4::update(uint_least32_t *buf, unsigned long const soBaseVol, unsign
 		unsigned long out = lfsr_.isHighState() ? outHigh : outLow;
 		if (lfsr_.counter() <= nextMajorEvent) {
 			Lfsr lfsr = lfsr_;
+			unsigned long const period = lfsr.period();
 			while (lfsr.counter() <= nextMajorEvent) {
 				*buf += out - prevOut_;
 				prevOut_ = out;
 				buf += lfsr.counter() - cc;
 				cc = lfsr.counter();
-				lfsr.event();
-				out = lfsr.isHighState() ? outHigh : outLow;
+
+				// all changes but the last are added right away, the last is left for the next
+				// write, as it may be at nextMajorEvent.
+				unsigned changes = lfsr.run(nextMajorEvent);
+				if (changes) {
+					for (; changes & (changes - 1); changes &= changes - 1) {
+						unsigned long const next = out ^ outHigh ^ outLow;
+						buf[lfsr_table::lowestChange(changes) * period] += next - out;
+						out = next;
+					}
+
+					unsigned long const last = lfsr_table::lowestChange(changes) * period;
+					prevOut_ = out;
+					buf += last;
+					cc += last;
+					out ^= outHigh ^ outLow;
+				}
 			}
 			lfsr_ = lfsr;
 		}
@@ -261,3 +315,6 @@ void Channel4::update(uint_least32_t *buf, unsigned long const soBaseVol, unsign
 		envelopeUnit_.resetCounters(cc);
 	}
 }
+
+template void Channel4::update(uint_least32_t *, unsigned long, unsigned long, unsigned long);
+template void Channel4::update(BandLimitedSynth::StepWriter, unsigned long, unsigned long, unsigned long);
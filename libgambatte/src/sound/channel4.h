@@ -38,7 +38,10 @@ public:
 	void setNr4(unsigned data, unsigned long cc);
 	void setSo(unsigned long soMask, unsigned long cc);
 	bool isActive() const { return master_; }
-	void update(uint_least32_t *buf, unsigned long soBaseVol, unsigned long cc, unsigned long end);
+	template<class Out>
+	void update(Out buf, unsigned long soBaseVol, unsigned long cc, unsigned long end);
+	unsigned long output() const { return prevOut_; }
+	void setOutput(unsigned long out) { prevOut_ = out; }
 	void reset(unsigned long cc);
 	void resetCc(unsigned long cc, unsigned long newCc) { lfsr_.resetCc(cc, newCc); }
 	void saveState(SaveState &state, unsigned long cc);
@@ -50,6 +53,8 @@ private:
 		Lfsr();
 		virtual void event();
 		virtual void resetCounters(unsigned long oldCc);
+		unsigned run(unsigned long end);
+		unsigned long period() const;
 		bool isHighState() const { return ~reg_ & 1; }
 		void nr3Change(unsigned newNr3, unsigned long cc);
 		void nr4Init(unsigned long cc);
@@ -0,0 +1,87 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#include "lfsr_table.h"
+
+using namespace gambatte;
+
+unsigned char const lfsr_table::trailing_zeros[0x100] = {
+	8, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+namespace {
+
+enum { period7 = 0x7F };
+
+// After 8 shifts in 7-bit mode, the high bits of the register only hold the last 8 feedback
+// bits, so that it is down to the 127 values that the low 7 bits go through (or to 0).
+struct Sequence7 {
+	unsigned short seq[period7];
+	unsigned char pos[period7 + 1];
+
+	Sequence7();
+};
+
+Sequence7::Sequence7() {
+	unsigned reg = period7;
+	for (int i = 0; i < 8; ++i)
+		reg = lfsr_table::shift(reg, true);
+
+	for (unsigned i = 0; i < period7; ++i) {
+		seq[i] = reg;
+		pos[reg & period7] = i;
+		reg = lfsr_table::shift(reg, true);
+	}
+
+	pos[0] = 0;
+}
+
+}
+
+unsigned lfsr_table::advance7(unsigned reg, unsigned long n) {
+	// a loaded state can have bit 15 set, which the first shift moves into the high bits
+	if (reg > 0x7FFF && n) {
+		reg = shift(reg, true);
+		--n;
+	}
+
+	if (n < 8) {
+		for (; n; --n)
+			reg = shift(reg, true);
+
+		return reg;
+	}
+
+	static Sequence7 const s;
+	return reg & period7 ? s.seq[(s.pos[reg & period7] + n) % period7] : 0;
+}
@@ -0,0 +1,77 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef LFSR_TABLE_H
+#define LFSR_TABLE_H
+
+namespace gambatte {
+
+// Moves the noise channel LFSR along many shifts at once. The next 15 output bits (bit 0) of a
+// 15-bit register are its own bits, 7 of them in 7-bit mode, so the shifts that change the
+// output are read off the register, and a block of them is taken in one go. The 7-bit sequence
+// is short enough to be kept whole, to go any number of shifts ahead.
+namespace lfsr_table {
+
+enum { max_shifts15 = 14, max_shifts7 = 6 };
+
+// trailing_zeros[b] is the number of trailing zero bits of b, 8 for 0.
+extern unsigned char const trailing_zeros[0x100];
+
+// One shift of reg, with the 7-bit mode feedback to bit 6 if sevenBit. The others give what
+// repeating this does.
+inline unsigned shift(unsigned reg, bool sevenBit) {
+	unsigned const shifted = reg >> 1;
+	unsigned const xored = (reg ^ shifted) & 1;
+	reg = shifted | xored << 14;
+
+	if (sevenBit)
+		reg = (reg & ~0x40u) | xored << 6;
+
+	return reg;
+}
+
+// reg after n shifts, for n up to max_shifts7 in 7-bit mode, and up to max_shifts15 and reg
+// within 15 bits otherwise.
+inline unsigned shifts(unsigned reg, bool sevenBit, unsigned n) {
+	if (sevenBit) {
+		unsigned const xored = ((reg ^ reg >> 1) << (7 - n)) & 0x7F;
+		return (reg >> n & ~(0x80u - (0x80 >> n))) | xored | xored << 8;
+	}
+
+	return reg >> n | (((reg ^ reg >> 1) << (15 - n)) & 0x7FFF);
+}
+
+// A mask of the first n shifts of reg that change the output, bit i set if shift i does, for
+// n up to what shifts takes.
+inline unsigned changes(unsigned reg, unsigned n) {
+	return (reg ^ reg >> 1) & ((1u << n) - 1);
+}
+
+// The index of the lowest bit set in a non-zero mask of changes.
+inline unsigned lowestChange(unsigned mask) {
+	return mask & 0xFF ? trailing_zeros[mask & 0xFF] : 8u + trailing_zeros[mask >> 8 & 0xFF];
+}
+
+// reg after n shifts in 7-bit mode.
+unsigned advance7(unsigned reg, unsigned long n);
+
+}
+
+}
+
+#endif
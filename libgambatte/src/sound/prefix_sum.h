@@ -0,0 +1,119 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef PREFIX_SUM_H
+#define PREFIX_SUM_H
+
+#include "gbint.h"
+#include <cstddef>
+
+#ifndef GAMBATTE_NO_SIMD
+#if defined __SSE2__
+#include <emmintrin.h>
+#define GAMBATTE_PREFIX_SUM_SSE2
+#endif
+#endif
+
+namespace gambatte {
+
+// Turns the n deltas in buf into samples: each becomes sum plus the deltas up to and
+// including it, modulo 2^32, with 0x8000 xored away from the low word (see
+// PSG::fillBuffer). Returns the sum of sum and all the deltas.
+inline uint_least32_t prefixSumPortable(uint_least32_t *b, std::size_t n, uint_least32_t sum) {
+	if (std::size_t n2 = n >> 3) {
+		n -= n2 << 3;
+
+		do {
+			sum += b[0];
+			b[0] = sum ^ 0x8000;
+			sum += b[1];
+			b[1] = sum ^ 0x8000;
+			sum += b[2];
+			b[2] = sum ^ 0x8000;
+			sum += b[3];
+			b[3] = sum ^ 0x8000;
+			sum += b[4];
+			b[4] = sum ^ 0x8000;
+			sum += b[5];
+			b[5] = sum ^ 0x8000;
+			sum += b[6];
+			b[6] = sum ^ 0x8000;
+			sum += b[7];
+			b[7] = sum ^ 0x8000;
+
+			b += 8;
+		} while (--n2);
+	}
+
+	while (n--) {
+		sum += *b;
+		*b++ = sum ^ 0x8000;
+	}
+
+	return sum;
+}
+
+#ifdef GAMBATTE_PREFIX_SUM_SSE2
+
+namespace prefix_sum_detail {
+
+// Sums of the 4 lanes up to and including each.
+inline __m128i scan(__m128i x) {
+	x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+	return _mm_add_epi32(x, _mm_slli_si128(x, 8));
+}
+
+inline __m128i lastLane(__m128i const x) { return _mm_shuffle_epi32(x, 0xFF); }
+
+}
+
+// 8 deltas at a time are scanned as two vectors of 4 that do not depend on the previous
+// ones, so that only adding the running sum, and moving it to every lane, is serial.
+inline uint_least32_t prefixSum(uint_least32_t *b, std::size_t n, uint_least32_t sum) {
+	using namespace prefix_sum_detail;
+
+	if (sizeof *b != 4)
+		return prefixSumPortable(b, n, sum);
+
+	__m128i const bias = _mm_set1_epi32(0x8000);
+	__m128i carry = _mm_set1_epi32(sum);
+	for (; n >= 8; n -= 8, b += 8) {
+		__m128i *const p = reinterpret_cast<__m128i *>(b);
+		__m128i const lo = scan(_mm_loadu_si128(p));
+		__m128i const hi = _mm_add_epi32(scan(_mm_loadu_si128(p + 1)), lastLane(lo));
+		__m128i const slo = _mm_add_epi32(lo, carry);
+		__m128i const shi = _mm_add_epi32(hi, carry);
+		_mm_storeu_si128(p, _mm_xor_si128(slo, bias));
+		_mm_storeu_si128(p + 1, _mm_xor_si128(shi, bias));
+		carry = lastLane(shi);
+	}
+
+	return prefixSumPortable(b, n, _mm_cvtsi128_si32(carry));
+}
+
+#else
+
+inline uint_least32_t prefixSum(uint_least32_t *b, std::size_t n, uint_least32_t sum) {
+	return prefixSumPortable(b, n, sum);
+}
+
+#endif
+
+}
+
+#endif
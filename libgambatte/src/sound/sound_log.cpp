@@ -0,0 +1,377 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#include "sound_log.h"
+#include "../sound.h"
+#include "soundlog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace gambatte;
+
+namespace {
+
+class NumberPutter {
+public:
+	explicit NumberPutter(std::vector<unsigned char> &log) : log_(log) {}
+
+	template<typename T>
+	void operator()(T &n) { sound_log::putNumber(log_, n); }
+
+private:
+	std::vector<unsigned char> &log_;
+};
+
+class NumberGetter {
+public:
+	NumberGetter(unsigned char const *&p, unsigned char const *end) : p_(p), end_(end), ok_(true) {}
+	bool ok() const { return ok_; }
+
+	template<typename T>
+	void operator()(T &n) {
+		cc_t v = 0;
+		ok_ = ok_ && sound_log::getNumber(p_, end_, v);
+		n = v;
+	}
+
+private:
+	unsigned char const *&p_;
+	unsigned char const *const end_;
+	bool ok_;
+};
+
+template<class Duty, class F>
+void visitDuty(Duty &duty, F &f) {
+	f(duty.nextPosUpdate);
+	f(duty.nr3);
+	f(duty.pos);
+	f(duty.high);
+}
+
+template<class Env, class LCounter, class F>
+void visitEnvLen(Env &env, LCounter &lcounter, F &f) {
+	f(env.counter);
+	f(env.volume);
+	f(lcounter.counter);
+	f(lcounter.lengthCounter);
+}
+
+// Everything in spu but the wave RAM pointer.
+template<class F>
+void visitSpu(SaveState::SPU &spu, F &f) {
+	f(spu.cycleCounter);
+	f(spu.lastUpdate);
+	f(spu.ch1.sweep.counter);
+	f(spu.ch1.sweep.shadow);
+	f(spu.ch1.sweep.nr0);
+	f(spu.ch1.sweep.neg);
+	visitDuty(spu.ch1.duty, f);
+	visitEnvLen(spu.ch1.env, spu.ch1.lcounter, f);
+	f(spu.ch1.nr4);
+	f(spu.ch1.master);
+	visitDuty(spu.ch2.duty, f);
+	visitEnvLen(spu.ch2.env, spu.ch2.lcounter, f);
+	f(spu.ch2.nr4);
+	f(spu.ch2.master);
+	f(spu.ch3.lcounter.counter);
+	f(spu.ch3.lcounter.lengthCounter);
+	f(spu.ch3.waveCounter);
+	f(spu.ch3.lastReadTime);
+	f(spu.ch3.nr3);
+	f(spu.ch3.nr4);
+	f(spu.ch3.wavePos);
+	f(spu.ch3.sampleBuf);
+	f(spu.ch3.master);
+	f(spu.ch4.lfsr.counter);
+	f(spu.ch4.lfsr.reg);
+	visitEnvLen(spu.ch4.env, spu.ch4.lcounter, f);
+	f(spu.ch4.nr4);
+	f(spu.ch4.master);
+}
+
+enum { state_regs_begin = 0x110, wave_ram_size = sound_log::num_wave_bytes };
+
+}
+
+bool sound_log::isOp(unsigned const op) {
+	return op <= op_state
+	    || (op >= op_write && op < op_write + num_write_regs)
+	    || (op >= op_wave && op < op_wave + num_wave_bytes);
+}
+
+void sound_log::putNumber(std::vector<unsigned char> &log, cc_t n) {
+	for (; n >= 0x80; n >>= 7)
+		log.push_back((n & 0x7F) | 0x80);
+
+	log.push_back(n);
+}
+
+bool sound_log::getNumber(unsigned char const *&p, unsigned char const *const end, cc_t &n) {
+	unsigned const bits = std::numeric_limits<cc_t>::digits;
+	cc_t v = 0;
+	for (unsigned shift = 0; p != end; shift = std::min(shift + 7, bits)) {
+		unsigned const b = *p++;
+		if (shift < bits)
+			v |= static_cast<cc_t>(b & 0x7F) << shift;
+
+		if (!(b & 0x80)) {
+			n = v;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void sound_log::putState(std::vector<unsigned char> &log, SaveState const &state, bool const cgb,
+		unsigned char const *const waveRam, cc_t const lastUpdate) {
+	unsigned char const *const ioamhram = state.mem.ioamhram.get();
+	log.push_back(cgb);
+	log.push_back(cgb && ioamhram[0x14D] >> 7 & 1);
+	putNumber(log, state.cpu.cycleCounter);
+	putNumber(log, lastUpdate);
+
+	SaveState::SPU spu = state.spu;
+	NumberPutter put(log);
+	visitSpu(spu, put);
+	log.insert(log.end(), ioamhram + state_regs_begin, ioamhram + state_regs_begin + num_state_regs);
+	log.insert(log.end(), waveRam, waveRam + wave_ram_size);
+}
+
+bool sound_log::getState(unsigned char const *&p, unsigned char const *const end, SaveState &state,
+		unsigned char *const ioamhram, bool &cgb, unsigned char *const waveRam, cc_t &lastUpdate) {
+	if (end - p < 2)
+		return false;
+
+	cgb = p[0];
+	ioamhram[0x14D] = p[1] << 7;
+	p += 2;
+
+	NumberGetter get(p, end);
+	get(state.cpu.cycleCounter);
+	get(lastUpdate);
+	visitSpu(state.spu, get);
+	if (!get.ok() || end - p < num_state_regs + wave_ram_size)
+		return false;
+
+	std::memcpy(ioamhram + state_regs_begin, p, num_state_regs);
+	std::memcpy(waveRam, p + num_state_regs, wave_ram_size);
+	p += num_state_regs + wave_ram_size;
+	return true;
+}
+
+bool sound_log::skipRecord(unsigned char const *&p, unsigned char const *const end) {
+	if (p == end || !isOp(*p))
+		return false;
+
+	unsigned const op = *p++;
+	if (op == op_state) {
+		SaveState state;
+		unsigned char ioamhram[0x200];
+		unsigned char waveRam[wave_ram_size];
+		cc_t lastUpdate = 0;
+		bool cgb = false;
+		return getState(p, end, state, ioamhram, cgb, waveRam, lastUpdate);
+	}
+
+	cc_t n = 0;
+	if (!getNumber(p, end, n) || (op == op_reset_counter && !getNumber(p, end, n)))
+		return false;
+
+	if (op >= op_write) {
+		if (p == end)
+			return false;
+
+		++p;
+	}
+
+	return true;
+}
+
+struct SoundLogRenderer::Priv {
+	PSG psg;
+	std::vector<unsigned char> log;
+	// the bytes of log done, dropped once they are at least half of it
+	std::size_t logPos;
+	// the time of the last record done, and that samples are generated up to
+	cc_t cc;
+	cc_t genCc;
+	bool ds;
+	bool hasState;
+
+	Priv() : logPos(0), cc(0), genCc(0), ds(false), hasState(false) {}
+	bool generateUntil(cc_t time, std::size_t maxSamples);
+	bool loadState(unsigned char const *&p, unsigned char const *end);
+	void write(unsigned reg, unsigned data);
+};
+
+// Stops early when maxSamples would be exceeded. Samples are generated in steps that
+// each leave room for the partial sample lastUpdate may be into.
+bool SoundLogRenderer::Priv::generateUntil(cc_t const time, std::size_t const maxSamples) {
+	while (genCc != time) {
+		std::size_t const room = maxSamples - psg.bufferPos();
+		if (room < 2)
+			return false;
+
+		cc_t const step = std::min<cc_t>(time - genCc, (room - 1ul) << (1 + ds));
+		genCc += step;
+		psg.generateSamples(genCc, ds);
+	}
+
+	return true;
+}
+
+bool SoundLogRenderer::Priv::loadState(unsigned char const *&p, unsigned char const *const end) {
+	SaveState state;
+	unsigned char ioamhram[0x200] = { 0 };
+	unsigned char waveRam[wave_ram_size];
+	cc_t lastUpdate = 0;
+	bool cgb = false;
+	state.mem.ioamhram.set(ioamhram, sizeof ioamhram);
+	if (!sound_log::getState(p, end, state, ioamhram, cgb, waveRam, lastUpdate))
+		return false;
+
+	// wave RAM is written directly with channel 3 off, and is not part of loadState
+	psg.setNr30(0);
+	for (unsigned i = 0; i < wave_ram_size; ++i)
+		psg.waveRamWrite(i, waveRam[i]);
+
+	psg.init(cgb);
+	psg.loadState(state);
+	cc = genCc = lastUpdate;
+	ds = ioamhram[0x14D] >> 7;
+	hasState = true;
+	return true;
+}
+
+void SoundLogRenderer::Priv::write(unsigned const reg, unsigned const data) {
+	switch (reg) {
+	case 0x10: psg.setNr10(data); break;
+	case 0x11: psg.setNr11(data); break;
+	case 0x12: psg.setNr12(data); break;
+	case 0x13: psg.setNr13(data); break;
+	case 0x14: psg.setNr14(data, ds); break;
+	case 0x16: psg.setNr21(data); break;
+	case 0x17: psg.setNr22(data); break;
+	case 0x18: psg.setNr23(data); break;
+	case 0x19: psg.setNr24(data, ds); break;
+	case 0x1A: psg.setNr30(data); break;
+	case 0x1B: psg.setNr31(data); break;
+	case 0x1C: psg.setNr32(data); break;
+	case 0x1D: psg.setNr33(data); break;
+	case 0x1E: psg.setNr34(data); break;
+	case 0x20: psg.setNr41(data); break;
+	case 0x21: psg.setNr42(data); break;
+	case 0x22: psg.setNr43(data); break;
+	case 0x23: psg.setNr44(data); break;
+	case 0x24: psg.setSoVolume(data); break;
+	case 0x25: psg.mapSo(data); break;
+	}
+}
+
+SoundLogRenderer::SoundLogRenderer()
+: p_(new Priv)
+{
+}
+
+SoundLogRenderer::~SoundLogRenderer() {
+	delete p_;
+}
+
+void SoundLogRenderer::write(char const *const data, std::size_t const size) {
+	p_->log.insert(p_->log.end(), data, data + size);
+}
+
+// A record is only taken out of the log once it is complete and done, so that one
+// split between writes, or one at a time beyond maxSamples, is picked up again later.
+std::size_t SoundLogRenderer::render(uint_least32_t *const audioBuf, std::size_t const maxSamples) {
+	using namespace sound_log;
+
+	Priv &p = *p_;
+	unsigned char const *const begin = p.log.empty() ? 0 : &p.log[0];
+	unsigned char const *const end = begin + p.log.size();
+	unsigned char const *done = begin + p.logPos;
+	p.psg.setBuffer(audioBuf);
+
+	while (done != end) {
+		unsigned char const *r = done;
+		unsigned const op = *r++;
+		if (!isOp(op))
+			break;
+
+		if (op == op_state) {
+			if (!p.loadState(r, end))
+				break;
+
+			done = r;
+			continue;
+		}
+
+		cc_t delta = 0;
+		cc_t operand = 0;
+		if (!getNumber(r, end, delta)
+				|| (op == op_reset_counter && !getNumber(r, end, operand))
+				|| (op >= op_write && r == end)) {
+			break;
+		}
+
+		if (op >= op_write)
+			operand = *r++;
+
+		if (p.hasState) {
+			cc_t const time = p.cc + delta;
+			if (!p.generateUntil(time, maxSamples))
+				break;
+
+			p.cc = time;
+			switch (op) {
+			case op_time: break;
+			case op_enable: p.psg.setEnabled(true); break;
+			case op_disable: p.psg.setEnabled(false); break;
+			case op_reset: p.psg.reset(p.ds); break;
+			case op_div_reset: p.psg.divReset(p.ds); break;
+			case op_speed_change:
+				p.psg.speedChange(p.cc, p.ds);
+				p.ds = !p.ds;
+				break;
+			case op_reset_counter:
+				p.psg.resetCounter(p.cc - operand, p.cc, p.ds);
+				p.cc -= operand;
+				p.genCc = p.cc;
+				break;
+			default:
+				if (op >= op_wave)
+					p.psg.waveRamWrite(op - op_wave, operand);
+				else
+					p.write(op - op_write + 0x10, operand);
+			}
+		}
+
+		done = r;
+	}
+
+	p.logPos = done - begin;
+	if (p.logPos * 2 >= p.log.size()) {
+		p.log.erase(p.log.begin(), p.log.begin() + p.logPos);
+		p.logPos = 0;
+	}
+
+	return p.psg.fillBuffer();
+}
@@ -0,0 +1,81 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef SOUND_LOG_H
+#define SOUND_LOG_H
+
+#include "../savestate.h"
+#include <cstddef>
+#include <vector>
+
+namespace gambatte {
+
+// The sound log is a sequence of records, each an op byte followed, except for
+// op_state, by the CPU cycles since the time of the previous record, and then any
+// operands. The time of a record is the cycle counter PSG::generateSamples was last
+// called with, which is what a PSG replaying the log gets called with before doing
+// the op. Numbers are stored 7 bits per byte, low bits first, with the top bit set
+// on all but the last byte.
+namespace sound_log {
+
+enum Op {
+	op_time,          // only generates samples up to the record time
+	op_enable,        // PSG::setEnabled(true)
+	op_disable,       // PSG::setEnabled(false)
+	op_reset,         // PSG::reset
+	op_div_reset,     // PSG::divReset
+	op_speed_change,  // PSG::speedChange at the record time, which toggles double speed
+	op_reset_counter, // PSG::resetCounter from the record time to that minus the operand
+	op_state,         // the state of the PSG, see putState, which sets the time
+	op_write = 0x10,  // op_write + i writes the operand to register 0xFF10 + i,
+	                  // for 0xFF10 to 0xFF25
+	op_wave = 0x30    // op_wave + i writes the operand to wave RAM byte i
+};
+
+enum { num_state_regs = 0x17, num_write_regs = 0x16, num_wave_bytes = 0x10 };
+
+// Returns whether op is one of the ops above, counting op_write and op_wave ones only
+// for the registers and wave RAM bytes they are for.
+bool isOp(unsigned op);
+
+void putNumber(std::vector<unsigned char> &log, cc_t n);
+
+// Returns false if the number does not end before end. Bits beyond those of cc_t are
+// dropped.
+bool getNumber(unsigned char const *&p, unsigned char const *end, cc_t &n);
+
+// Moves p past the record it is at. Returns false if the record does not end before end,
+// or if its op is not one.
+bool skipRecord(unsigned char const *&p, unsigned char const *end);
+
+// Puts the spu state, the registers at 0xFF10 to 0xFF26 and the double speed flag of
+// ioamhram, the cycle counter of cpu, the wave RAM and lastUpdate, the time the
+// state is at.
+void putState(std::vector<unsigned char> &log, SaveState const &state, bool cgb,
+		unsigned char const *waveRam, cc_t lastUpdate);
+
+// Gets a state put by putState into state, whose ioamhram must be writable, given as
+// ioamhram.
+bool getState(unsigned char const *&p, unsigned char const *end, SaveState &state,
+		unsigned char *ioamhram, bool &cgb, unsigned char *waveRam, cc_t &lastUpdate);
+
+}
+
+}
+
+#endif
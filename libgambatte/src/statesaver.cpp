@@ -19,6 +19,7 @@
 #include "statesaver.h"
 #include "savestate.h"
 #include "array.h"
+#include "counterdef.h"
 
 #include <algorithm>
 #include <fstream>
@@ -87,6 +88,22 @@ void write(std::ostringstream &file, unsigned long data) {
 	put32(file, data);
 }
 
+#ifdef GAMBATTE_64BIT_CC
+void writeCc(std::ostringstream &file, cc_t data) {
+	if (data <= 0xfffffffful) {
+		write(file, static_cast<unsigned long>(data));
+		return;
+	}
+
+	// readers with 32-bit counters skip the leading bytes, which maps disabled_time
+	// to their own, and rebase the rest (see rebaseCc). older ones only masked
+	// cpu.cycleCounter, leaving the other times as much as 2^31 cycles off.
+	put24(file, 8);
+	put32(file, static_cast<unsigned long>(data >> 32 & 0xffffffff));
+	put32(file, static_cast<unsigned long>(data & 0xffffffff));
+}
+#endif
+
 void write(std::ostringstream &file, unsigned char const *data, std::size_t size) {
 	put24(file, size);
 	file.write(reinterpret_cast<char const *>(data), size);
@@ -126,6 +143,49 @@ unsigned long read(std::istringstream &file) {
 	return out;
 }
 
+#ifdef GAMBATTE_64BIT_CC
+void readCc(std::istringstream &file, cc_t &data) {
+	unsigned long size = get24(file);
+	if (size > 8) {
+		file.ignore(size - 8);
+		size = 8;
+	}
+
+	cc_t out = 0;
+	for (unsigned long i = 0; i < size; ++i)
+		out = out << 8 | (file.get() & 0xFF);
+
+	// states saved with 32-bit counters use 0xffffffff for disabled_time.
+	data = size <= 4 && out == 0xfffffffful ? disabled_time : out;
+}
+#else
+// States saved with 64-bit counters may have cycle times past 32 bits, of which read
+// keeps the low 32 bits. Those still agree with each other mod 2^32, so take the same
+// amount off of all of them like Memory::resetCounters would, which leaves states
+// saved with 32-bit counters alone.
+void rebaseCc(SaveState &state) {
+	cc_t const cc = state.cpu.cycleCounter;
+	if (cc < 0x20000)
+		return;
+
+	cc_t const dec = (cc & -0x10000l) - 0x10000;
+	cc_t *const times[] = {
+		&state.cpu.cycleCounter,
+		&state.mem.divLastUpdate, &state.mem.timaLastUpdate, &state.mem.tmatime,
+		&state.mem.nextSerialtime, &state.mem.lastOamDmaUpdate, &state.mem.minIntTime,
+		&state.mem.unhaltTime,
+		&state.ppu.enableDisplayM0Time,
+		&state.time.lastCycles,
+		&state.huc3.irBaseCycle
+	};
+
+	for (std::size_t i = 0; i < sizeof times / sizeof *times; ++i) {
+		if (*times[i] != disabled_time)
+			*times[i] = (*times[i] - dec) & 0xfffffffful;
+	}
+}
+#endif
+
 inline void read(std::istringstream &file, unsigned char &data) {
 	data = read(file) & 0xFF;
 }
@@ -201,6 +261,18 @@ SaverList::SaverList()
 	push(list, label, Func::save, Func::load, sizeof label); \
 } while (0)
 
+#ifdef GAMBATTE_64BIT_CC
+#define ADDCC(arg) do { \
+	struct Func { \
+		static void save(std::ostringstream &file, SaveState const &state) { writeCc(file, state.arg); } \
+		static void load(std::istringstream &file, SaveState &state) { readCc(file, state.arg); } \
+	}; \
+	push(list, label, Func::save, Func::load, sizeof label); \
+} while (0)
+#else
+#define ADDCC(arg) ADD(arg)
+#endif
+
 #define ADDPTR(arg) do { \
 	struct Func { \
 		static void save(std::ostringstream &file, SaveState const &state) { \
@@ -225,7 +297,7 @@ SaverList::SaverList()
 	push(list, label, Func::save, Func::load, sizeof label); \
 } while (0)
 
-	{ static char const label[] = { c,c,           NUL }; ADD(cpu.cycleCounter); }
+	{ static char const label[] = { c,c,           NUL }; ADDCC(cpu.cycleCounter); }
 	{ static char const label[] = { p,c,           NUL }; ADD(cpu.pc); }
 	{ static char const label[] = { s,p,           NUL }; ADD(cpu.sp); }
 	{ static char const label[] = { a,             NUL }; ADD(cpu.a); }
@@ -244,13 +316,13 @@ SaverList::SaverList()
 	{ static char const label[] = { s,r,a,m,       NUL }; ADDPTR(mem.sram); }
 	{ static char const label[] = { w,r,a,m,       NUL }; ADDPTR(mem.wram); }
 	{ static char const label[] = { h,r,a,m,       NUL }; ADDPTR(mem.ioamhram); }
-	{ static char const label[] = { l,d,i,v,u,p,   NUL }; ADD(mem.divLastUpdate); }
-	{ static char const label[] = { l,t,i,m,a,u,p, NUL }; ADD(mem.timaLastUpdate); }
-	{ static char const label[] = { t,m,a,t,i,m,e, NUL }; ADD(mem.tmatime); }
-	{ static char const label[] = { s,e,r,i,a,l,t, NUL }; ADD(mem.nextSerialtime); }
-	{ static char const label[] = { l,o,d,m,a,u,p, NUL }; ADD(mem.lastOamDmaUpdate); }
-	{ static char const label[] = { m,i,n,i,n,t,t, NUL }; ADD(mem.minIntTime); }
-	{ static char const label[] = { u,n,h,a,l,t,t, NUL }; ADD(mem.unhaltTime); }
+	{ static char const label[] = { l,d,i,v,u,p,   NUL }; ADDCC(mem.divLastUpdate); }
+	{ static char const label[] = { l,t,i,m,a,u,p, NUL }; ADDCC(mem.timaLastUpdate); }
+	{ static char const label[] = { t,m,a,t,i,m,e, NUL }; ADDCC(mem.tmatime); }
+	{ static char const label[] = { s,e,r,i,a,l,t, NUL }; ADDCC(mem.nextSerialtime); }
+	{ static char const label[] = { l,o,d,m,a,u,p, NUL }; ADDCC(mem.lastOamDmaUpdate); }
+	{ static char const label[] = { m,i,n,i,n,t,t, NUL }; ADDCC(mem.minIntTime); }
+	{ static char const label[] = { u,n,h,a,l,t,t, NUL }; ADDCC(mem.unhaltTime); }
 	{ static char const label[] = { r,o,m,b,a,n,k, NUL }; ADD(mem.rombank); }
 	{ static char const label[] = { d,m,a,s,r,c,   NUL }; ADD(mem.dmaSource); }
 	{ static char const label[] = { d,m,a,d,s,t,   NUL }; ADD(mem.dmaDestination); }
@@ -285,7 +357,7 @@ SaverList::SaverList()
 	{ static char const label[] = { s,p,b,y,t,e,NO0, NUL }; ADDARRAY(ppu.spByte0List); }
 	{ static char const label[] = { s,p,b,y,t,e,NO1, NUL }; ADDARRAY(ppu.spByte1List); }
 	{ static char const label[] = { v,c,y,c,l,e,s, NUL }; ADD(ppu.videoCycles); }
-	{ static char const label[] = { e,d,M,NO0,t,i,m, NUL }; ADD(ppu.enableDisplayM0Time); }
+	{ static char const label[] = { e,d,M,NO0,t,i,m, NUL }; ADDCC(ppu.enableDisplayM0Time); }
 	{ static char const label[] = { m,NO0,t,i,m,e, NUL }; ADD(ppu.lastM0Time); }
 	{ static char const label[] = { n,m,NO0,i,r,q, NUL }; ADD(ppu.nextM0Irq); }
 	{ static char const label[] = { b,g,t,w,       NUL }; ADD(ppu.tileword); }
@@ -355,7 +427,7 @@ SaverList::SaverList()
 	{ static char const label[] = { t,i,m,e,s,e,c, NUL }; ADD(time.seconds); }
 	{ static char const label[] = { t,i,m,e,l,t,s, NUL }; ADD(time.lastTimeSec); }
 	{ static char const label[] = { t,i,m,e,l,t,u, NUL }; ADD(time.lastTimeUsec); }
-	{ static char const label[] = { t,i,m,e,l,c,   NUL }; ADD(time.lastCycles); }
+	{ static char const label[] = { t,i,m,e,l,c,   NUL }; ADDCC(time.lastCycles); }
 	{ static char const label[] = { r,t,c,h,a,l,t, NUL }; ADD(rtc.haltTime); }
 	{ static char const label[] = { r,t,c,d,h,     NUL }; ADD(rtc.dataDh); }
 	{ static char const label[] = { r,t,c,d,l,     NUL }; ADD(rtc.dataDl); }
@@ -370,10 +442,11 @@ SaverList::SaverList()
 	{ static char const label[] = { h,NO3,s,h,f,t, NUL }; ADD(huc3.shift); }
 	{ static char const label[] = { h,NO3,r,v,     NUL }; ADD(huc3.ramValue); }
 	{ static char const label[] = { h,NO3,m,f,     NUL }; ADD(huc3.modeflag); }
-	{ static char const label[] = { h,NO3,i,r,c,y, NUL }; ADD(huc3.irBaseCycle); }
+	{ static char const label[] = { h,NO3,i,r,c,y, NUL }; ADDCC(huc3.irBaseCycle); }
 	{ static char const label[] = { h,NO3,i,r,a,c, NUL }; ADD(huc3.irReceivingPulse); }
 
 #undef ADD
+#undef ADDCC
 #undef ADDPTR
 #undef ADDARRAY
 
@@ -499,7 +572,9 @@ bool StateSaver::loadState(SaveState &state,
 		(*it->load)(file, state);
 	}
 
-	state.cpu.cycleCounter &= 0x7FFFFFFF;
+#ifndef GAMBATTE_64BIT_CC
+	rebaseCc(state);
+#endif
 	state.spu.cycleCounter &= 0x7FFFFFFF;
 
 	return true;
@@ -51,7 +51,7 @@ void Tima::loadState(SaveState const &state, TimaInterruptRequester timaIrq) {
 	tma_  = state.mem.ioamhram.get()[0x106];
 	tac_  = state.mem.ioamhram.get()[0x107];
 
-	unsigned long nextIrqEventTime = disabled_time;
+	cc_t nextIrqEventTime = disabled_time;
 	if (tac_ & 4) {
 		nextIrqEventTime = tmatime_ != disabled_time && tmatime_ > state.cpu.cycleCounter
 			? tmatime_
@@ -61,12 +61,12 @@ void Tima::loadState(SaveState const &state, TimaInterruptRequester timaIrq) {
 	timaIrq.setNextIrqEventTime(nextIrqEventTime);
 }
 
-void Tima::resetCc(unsigned long const oldCc, unsigned long const newCc, TimaInterruptRequester timaIrq) {
+void Tima::resetCc(cc_t const oldCc, cc_t const newCc, TimaInterruptRequester timaIrq) {
 	if (tac_ & 0x04) {
 		updateIrq(oldCc, timaIrq);
 		updateTima(oldCc);
 
-		unsigned long const dec = oldCc - newCc;
+		cc_t const dec = oldCc - newCc;
 		lastUpdate_ -= dec;
 		timaIrq.setNextIrqEventTime(timaIrq.nextIrqEventTime() - dec);
 
@@ -75,8 +75,8 @@ void Tima::resetCc(unsigned long const oldCc, unsigned long const newCc, TimaInt
 	}
 }
 
-void Tima::updateTima(unsigned long const cc) {
-	unsigned long const ticks = (cc - lastUpdate_) >> timaClock[tac_ & 3];
+void Tima::updateTima(cc_t const cc) {
+	cc_t const ticks = (cc - lastUpdate_) >> timaClock[tac_ & 3];
 	lastUpdate_ += ticks << timaClock[tac_ & 3];
 
 	if (cc >= tmatime_) {
@@ -86,7 +86,7 @@ void Tima::updateTima(unsigned long const cc) {
 		tima_ = tma_;
 	}
 
-	unsigned long tmp = tima_ + ticks;
+	cc_t tmp = tima_ + ticks;
 	while (tmp > 0x100)
 		tmp -= 0x100 - tma_;
 
@@ -104,7 +104,7 @@ void Tima::updateTima(unsigned long const cc) {
 	tima_ = tmp;
 }
 
-void Tima::setTima(unsigned const data, unsigned long const cc, TimaInterruptRequester timaIrq) {
+void Tima::setTima(unsigned const data, cc_t const cc, TimaInterruptRequester timaIrq) {
 	if (tac_ & 0x04) {
 		updateIrq(cc, timaIrq);
 		updateTima(cc);
@@ -118,7 +118,7 @@ void Tima::setTima(unsigned const data, unsigned long const cc, TimaInterruptReq
 	tima_ = data;
 }
 
-void Tima::setTma(unsigned const data, unsigned long const cc, TimaInterruptRequester timaIrq) {
+void Tima::setTma(unsigned const data, cc_t const cc, TimaInterruptRequester timaIrq) {
 	if (tac_ & 0x04) {
 		updateIrq(cc, timaIrq);
 		updateTima(cc);
@@ -127,9 +127,9 @@ void Tima::setTma(unsigned const data, unsigned long const cc, TimaInterruptRequ
 	tma_ = data;
 }
 
-void Tima::setTac(unsigned const data, unsigned long const cc, TimaInterruptRequester timaIrq, bool agbFlag) {
+void Tima::setTac(unsigned const data, cc_t const cc, TimaInterruptRequester timaIrq, bool agbFlag) {
 	if (tac_ ^ data) {
-		unsigned long nextIrqEventTime = timaIrq.nextIrqEventTime();
+		cc_t nextIrqEventTime = timaIrq.nextIrqEventTime();
 
 		if (tac_ & 0x04) {
 			unsigned const inc = ~(data >> 2 & (cc - divLastUpdate_) >> (timaClock[data & 3] - 1)) & 1;
@@ -146,7 +146,7 @@ void Tima::setTac(unsigned const data, unsigned long const cc, TimaInterruptRequ
 		if (data & 4) {
 			// GSR NOTE: "timer quirk" (commit 144e4e9, since r649)
 			if (agbFlag) {
-				unsigned long diff = cc - divLastUpdate_;
+				cc_t diff = cc - divLastUpdate_;
 				if (((diff >> (timaClock[tac_ & 3] - 1)) & 1) == 1 && ((diff >> (timaClock[data & 3] - 1)) & 1) == 0)
 					tima_++;
 			}
@@ -161,9 +161,9 @@ void Tima::setTac(unsigned const data, unsigned long const cc, TimaInterruptRequ
 	tac_ = data;
 }
 
-void Tima::divReset(unsigned long cc, TimaInterruptRequester timaIrq) {
+void Tima::divReset(cc_t cc, TimaInterruptRequester timaIrq) {
 	if (tac_ & 0x04) {
-		unsigned long nextIrqEventTime = timaIrq.nextIrqEventTime();
+		cc_t nextIrqEventTime = timaIrq.nextIrqEventTime();
 		lastUpdate_ -= (1u << (timaClock[tac_ & 3] - 1)) + 3;
 		nextIrqEventTime -= (1u << (timaClock[tac_ & 3] - 1)) + 3;
 		if (cc >= nextIrqEventTime)
@@ -184,7 +184,7 @@ void Tima::speedChange(TimaInterruptRequester timaIrq) {
 	}
 }
 
-unsigned Tima::tima(unsigned long cc) {
+unsigned Tima::tima(cc_t cc) {
 	if (tac_ & 0x04)
 		updateTima(cc);
 
@@ -27,9 +27,9 @@ class TimaInterruptRequester {
 public:
 	explicit TimaInterruptRequester(InterruptRequester &intreq) : intreq_(intreq) {}
 	void flagIrq() const { intreq_.flagIrq(4); }
-	void flagIrq(unsigned long cc) const { intreq_.flagIrq(4, cc); }
-	unsigned long nextIrqEventTime() const { return intreq_.eventTime(intevent_tima); }
-	void setNextIrqEventTime(unsigned long time) const { intreq_.setEventTime<intevent_tima>(time); }
+	void flagIrq(cc_t cc) const { intreq_.flagIrq(4, cc); }
+	cc_t nextIrqEventTime() const { return intreq_.eventTime(intevent_tima); }
+	void setNextIrqEventTime(cc_t time) const { intreq_.setEventTime<intevent_tima>(time); }
 
 private:
 	InterruptRequester &intreq_;
@@ -40,30 +40,30 @@ public:
 	Tima();
 	void saveState(SaveState &) const;
 	void loadState(const SaveState &, TimaInterruptRequester timaIrq);
-	void resetCc(unsigned long oldCc, unsigned long newCc, TimaInterruptRequester timaIrq);
-	void setTima(unsigned tima, unsigned long cc, TimaInterruptRequester timaIrq);
-	void setTma(unsigned tma, unsigned long cc, TimaInterruptRequester timaIrq);
-	void setTac(unsigned tac, unsigned long cc, TimaInterruptRequester timaIrq, bool agbFlag);
-	void divReset(unsigned long cc, TimaInterruptRequester);
+	void resetCc(cc_t oldCc, cc_t newCc, TimaInterruptRequester timaIrq);
+	void setTima(unsigned tima, cc_t cc, TimaInterruptRequester timaIrq);
+	void setTma(unsigned tma, cc_t cc, TimaInterruptRequester timaIrq);
+	void setTac(unsigned tac, cc_t cc, TimaInterruptRequester timaIrq, bool agbFlag);
+	void divReset(cc_t cc, TimaInterruptRequester);
 	void speedChange(TimaInterruptRequester);
-	unsigned long divLastUpdate() const { return divLastUpdate_; }
-	unsigned tima(unsigned long cc);
+	cc_t divLastUpdate() const { return divLastUpdate_; }
+	unsigned tima(cc_t cc);
 	void doIrqEvent(TimaInterruptRequester timaIrq);
 
 private:
-	unsigned long divLastUpdate_;
-	unsigned long lastUpdate_;
-	unsigned long tmatime_;
+	cc_t divLastUpdate_;
+	cc_t lastUpdate_;
+	cc_t tmatime_;
 	unsigned char tima_;
 	unsigned char tma_;
 	unsigned char tac_;
 
-	void updateIrq(unsigned long const cc, TimaInterruptRequester timaIrq) {
+	void updateIrq(cc_t const cc, TimaInterruptRequester timaIrq) {
 		while (cc >= timaIrq.nextIrqEventTime())
 			doIrqEvent(timaIrq);
 	}
 
-	void updateTima(unsigned long cc);
+	void updateTima(cc_t cc);
 };
 
 }
@@ -17,7 +17,9 @@
 //
 
 #include "video.h"
+#include "gambatte.h"
 #include "savestate.h"
+#include "video/video_format.h"
 
 #include <algorithm>
 #include <cstring>
@@ -41,6 +43,10 @@ unsigned long gbcToRgb32(unsigned const bgr15, bool trueColor) {
 	| (r * 3 + g * 2 + b * 11) >> 1;
 }
 
+unsigned long gbcToColor(unsigned const bgr15, bool trueColor, GB::VideoFormat format) {
+	return rgb32ToVideoFormat(gbcToRgb32(bgr15, trueColor), format);
+}
+
 /*unsigned long gbcToRgb16(unsigned const bgr15) {
 	unsigned const r = bgr15 & 0x1F;
 	unsigned const g = bgr15 >> 5 & 0x1F;
@@ -77,12 +83,15 @@ long const mode1_irq_frame_cycle = 1l * lcd_vres * lcd_cycles_per_line - 2;
 int const mode2_irq_line_cycle = lcd_cycles_per_line - 4;
 int const mode2_irq_line_cycle_ly0 = lcd_cycles_per_line - 2;
 
-unsigned long mode1IrqSchedule(LyCounter const &lyCounter, unsigned long cc) {
+// INDEXED8 values not taken by palette entries, see GB::getIndexedPalette.
+enum { indexed_lcd_off = 0x40, indexed_black = 0x41 };
+
+cc_t mode1IrqSchedule(LyCounter const &lyCounter, cc_t cc) {
 	return lyCounter.nextFrameCycle(mode1_irq_frame_cycle, cc);
 }
 
-unsigned long mode2IrqSchedule(unsigned const statReg,
-		LyCounter const &lyCounter, unsigned long const cc) {
+cc_t mode2IrqSchedule(unsigned const statReg,
+		LyCounter const &lyCounter, cc_t const cc) {
 	if (!(statReg & lcdstat_m2irqen))
 		return disabled_time;
 
@@ -93,32 +102,34 @@ unsigned long mode2IrqSchedule(unsigned const statReg,
 	: lyCounter.nextLineCycle(mode2_irq_line_cycle, cc);
 }
 
-unsigned long m0TimeOfCurrentLine(
-		unsigned long nextLyTime,
-		unsigned long lastM0Time,
-		unsigned long nextM0Time) {
+cc_t m0TimeOfCurrentLine(
+		cc_t nextLyTime,
+		cc_t lastM0Time,
+		cc_t nextM0Time) {
 	return nextM0Time < nextLyTime ? nextM0Time : lastM0Time;
 }
 
 bool isHdmaPeriod(LyCounter const &lyCounter,
-		unsigned long m0TimeOfCurrentLy, unsigned long cc) {
+		cc_t m0TimeOfCurrentLy, cc_t cc) {
 	return lyCounter.ly() < lcd_vres
 	&& cc + 3 + 3 * lyCounter.isDoubleSpeed() < lyCounter.time()
 	&& cc >= m0TimeOfCurrentLy;
 }
 
-void doCgbColorChange(unsigned char *pdata,
-		unsigned long *palette, unsigned index, unsigned data, bool trueColor) {
+void doCgbColorChange(unsigned char *pdata, unsigned long *palette, unsigned index, unsigned data,
+		bool trueColor, GB::VideoFormat format) {
 	pdata[index] = data;
 	index /= 2;
-	palette[index] = gbcToRgb32(pdata[index * 2] | pdata[index * 2 + 1] * 0x100l, trueColor);
+	palette[index] = gbcToColor(pdata[index * 2] | pdata[index * 2 + 1] * 0x100l, trueColor, format);
 }
 
 } // unnamed namespace.
 
-void LCD::setDmgPalette(unsigned long palette[], unsigned short const dmgColors[], unsigned data, bool trueColor) {
-	for (int i = 0; i < num_palette_entries; ++i, data /= num_palette_entries)
-		palette[i] = gbcToRgb32(dmgColors[data % num_palette_entries], trueColor);
+void LCD::setDmgPalette(unsigned long palette[], unsigned const palNum, unsigned data) {
+	for (int i = 0; i < num_palette_entries; ++i, data /= num_palette_entries) {
+		unsigned const color = palNum * num_palette_entries + data % num_palette_entries;
+		palette[i] = isIndexed() ? color : gbcToColor(dmgColorsBgr15_[color], isTrueColors(), videoFormat());
+	}
 }
 
 LCD::LCD(unsigned char const *oamram, unsigned char const *vram,
@@ -135,6 +146,7 @@ LCD::LCD(unsigned char const *oamram, unsigned char const *vram,
 
 	reset(oamram, vram, false);
 	setVideoBuffer(0, lcd_hres);
+	resetEventStats();
 }
 
 void LCD::reset(unsigned char const *oamram, unsigned char const *vram, bool cgb) {
@@ -198,15 +210,61 @@ void LCD::loadState(SaveState const &state, unsigned char const *const oamram) {
 }
 
 void LCD::refreshPalettes() {
+	if (isCgb() && !isCgbDmg()) {
+		if (isIndexed()) {
+			for (int i = 0; i < max_num_palettes * num_palette_entries; ++i) {
+				ppu_.bgPalette()[i] = i;
+				ppu_.spPalette()[i] = max_num_palettes * num_palette_entries + i;
+			}
+		} else for (int i = 0; i < max_num_palettes * num_palette_entries; ++i) {
+			ppu_.bgPalette()[i] = gbcToColor( bgpData_[2 * i] |  bgpData_[2 * i + 1] * 0x100l,
+			                                 isTrueColors(), videoFormat());
+			ppu_.spPalette()[i] = gbcToColor(objpData_[2 * i] | objpData_[2 * i + 1] * 0x100l,
+			                                 isTrueColors(), videoFormat());
+		}
+	} else {
+		setDmgPalette(ppu_.bgPalette()    ,  BG_PALETTE,  bgpData_[0]);
+		setDmgPalette(ppu_.spPalette()    , SP1_PALETTE, objpData_[0]);
+		setDmgPalette(ppu_.spPalette() + 4, SP2_PALETTE, objpData_[1]);
+	}
+
+	ppu_.paletteChange();
+}
+
+void LCD::getIndexedPalette(uint_least32_t *const dest) const {
+	std::fill_n(dest, 1 * GB::INDEXED_PALETTE_SIZE, 0);
 	if (isCgb() && !isCgbDmg()) {
 		for (int i = 0; i < max_num_palettes * num_palette_entries; ++i) {
-			ppu_.bgPalette()[i] = gbcToRgb32( bgpData_[2 * i] |  bgpData_[2 * i + 1] * 0x100l, isTrueColors());
-			ppu_.spPalette()[i] = gbcToRgb32(objpData_[2 * i] | objpData_[2 * i + 1] * 0x100l, isTrueColors());
+			dest[i] = gbcToRgb32( bgpData_[2 * i] |  bgpData_[2 * i + 1] * 0x100l, isTrueColors());
+			dest[max_num_palettes * num_palette_entries + i] =
+				gbcToRgb32(objpData_[2 * i] | objpData_[2 * i + 1] * 0x100l, isTrueColors());
 		}
 	} else {
-		setDmgPalette(ppu_.bgPalette()    , dmgColorsBgr15_    ,  bgpData_[0], isTrueColors());
-		setDmgPalette(ppu_.spPalette()    , dmgColorsBgr15_ + 4, objpData_[0], isTrueColors());
-		setDmgPalette(ppu_.spPalette() + 4, dmgColorsBgr15_ + 8, objpData_[1], isTrueColors());
+		for (int i = 0; i < 3 * num_palette_entries; ++i)
+			dest[i] = gbcToRgb32(dmgColorsBgr15_[i], isTrueColors());
+	}
+
+	dest[indexed_lcd_off] = gbcToRgb32(0x7FFF, isTrueColors());
+	dest[indexed_black] = gbcToRgb32(0x0000, isTrueColors());
+}
+
+void LCD::getRgb32Palettes(uint_least32_t *const bgPalette, uint_least32_t *const spPalette) const {
+	std::fill_n(bgPalette, max_num_palettes * num_palette_entries, 0);
+	std::fill_n(spPalette, max_num_palettes * num_palette_entries, 0);
+	if (isCgb() && !isCgbDmg()) {
+		for (int i = 0; i < max_num_palettes * num_palette_entries; ++i) {
+			bgPalette[i] = gbcToRgb32( bgpData_[2 * i] |  bgpData_[2 * i + 1] * 0x100l, isTrueColors());
+			spPalette[i] = gbcToRgb32(objpData_[2 * i] | objpData_[2 * i + 1] * 0x100l, isTrueColors());
+		}
+	} else for (int i = 0; i < num_palette_entries; ++i) {
+		unsigned const shift = 2 * i;
+		bgPalette[i] = gbcToRgb32(dmgColorsBgr15_[ BG_PALETTE * num_palette_entries + (bgpData_[0] >> shift & 3)],
+		                          isTrueColors());
+		spPalette[i] = gbcToRgb32(dmgColorsBgr15_[SP1_PALETTE * num_palette_entries + (objpData_[0] >> shift & 3)],
+		                          isTrueColors());
+		spPalette[num_palette_entries + i] =
+			gbcToRgb32(dmgColorsBgr15_[SP2_PALETTE * num_palette_entries + (objpData_[1] >> shift & 3)],
+			           isTrueColors());
 	}
 }
 
@@ -224,6 +282,11 @@ void LCD::setTrueColors(bool trueColors) {
 	refreshPalettes();
 }
 
+void LCD::setVideoFormat(GB::VideoFormat format) {
+	ppu_.setVideoFormat(format);
+	refreshPalettes();
+}
+
 namespace {
 
 template <class Blend>
@@ -250,25 +313,30 @@ struct Blend {
 };
 
 template <typename T>
-void clear(T *buf, unsigned long color, std::ptrdiff_t dpitch) {
-	for (unsigned lines = lcd_vres; lines > 0; --lines, buf += dpitch)
+void clear(T *buf, unsigned long color, std::ptrdiff_t dpitch, PPUFrameBuf const &lines) {
+	buf += std::ptrdiff_t(lines.firstLine()) * dpitch;
+	for (unsigned ly = lines.firstLine(); ly <= lines.lastLine(); ++ly, buf += dpitch)
 		std::fill_n(buf, 1 * lcd_hres, color);
 }
 
 }
 
-void LCD::updateScreen(bool const blanklcd, unsigned long const cycleCounter, unsigned const stage) {
+void LCD::updateScreen(bool const blanklcd, cc_t const cycleCounter, unsigned const stage) {
 	switch (stage) {
 	case 0:
 		update(cycleCounter);
-
-		if (blanklcd && ppu_.frameBuf().fb()) {
-			unsigned long color = gbcToRgb32(ppu_.cgb() ? 0x7FFF : dmgColorsBgr15_[0], isTrueColors());
-			clear(ppu_.frameBuf().fb(), color, ppu_.frameBuf().pitch());
+		clearFrame(ppu_.endFrame(blanklcd ? PPUFrameLog::frame_lcd_off : PPUFrameLog::frame_drawn),
+		           ppu_.videoBuf(), ppu_.videoPitch());
+
+		if (blanklcd) {
+			if (ppu_.cgb())
+				clearFrameBuf(0x7FFF, indexed_lcd_off);
+			else
+				clearFrameBuf(dmgColorsBgr15_[0], 0);
 		}
 		break;
 	case 1:
-		if (ppu_.frameBuf().fb() && osdElement_) {
+		if (ppu_.frameBuf().fb() && osdElement_ && videoFormat() == GB::RGB32) {
 			if (uint_least32_t const *const s = osdElement_->update()) {
 				uint_least32_t *const d = ppu_.frameBuf().fb()
 					+ std::ptrdiff_t(osdElement_->y()) * ppu_.frameBuf().pitch()
@@ -292,17 +360,90 @@ void LCD::updateScreen(bool const blanklcd, unsigned long const cycleCounter, un
 }
 
 void LCD::blackScreen() {
-	if (ppu_.frameBuf().fb()) {
-		clear(ppu_.frameBuf().fb(), gbcToRgb32(0x0000, isTrueColors()), ppu_.frameBuf().pitch());
+	clearFrame(ppu_.endFrame(PPUFrameLog::frame_black), ppu_.videoBuf(), ppu_.videoPitch());
+	clearFrameBuf(0x0000, indexed_black);
+}
+
+void LCD::clearFrameBuf(uint_least32_t *const buf, std::ptrdiff_t const pitch,
+		unsigned const bgr15, unsigned const indexedValue) {
+	if (!buf)
+		return;
+
+	switch (videoFormat()) {
+	case GB::RGB32:
+		clear(buf, gbcToRgb32(bgr15, isTrueColors()), pitch, ppu_.frameBuf());
+		break;
+	case GB::INDEXED8:
+		clear(reinterpret_cast<unsigned char *>(buf), indexedValue, pitch, ppu_.frameBuf());
+		break;
+	default:
+		clear(reinterpret_cast<uint_least16_t *>(buf),
+		      gbcToColor(bgr15, isTrueColors(), videoFormat()), pitch, ppu_.frameBuf());
+		break;
 	}
 }
 
-void LCD::resetCc(unsigned long const oldCc, unsigned long const newCc) {
+void LCD::getRasterPos(cc_t const cc, unsigned &ly, unsigned &lineCycle) const {
+	ly = lineCycle = 0;
+	if (!(ppu_.lcdc() & lcdc_en))
+		return;
+
+	LyCounter const &lyCounter = ppu_.lyCounter();
+	cc_t lyTime = lyCounter.time();
+	ly = lyCounter.ly();
+	if (cc >= lyTime) {
+		cc_t const lines = (cc - lyTime) / lyCounter.lineTime() + 1;
+		lyTime += lines * lyCounter.lineTime();
+		ly = (ly + lines) % lcd_lines_per_frame;
+	}
+
+	lineCycle = lcd_cycles_per_line - ((lyTime - cc) >> isDoubleSpeed());
+}
+
+void LCD::clearFrame(PPUFrameLog::Frame const frame, uint_least32_t *const buf, std::ptrdiff_t const pitch) {
+	switch (frame) {
+	case PPUFrameLog::frame_lcd_off:
+		if (ppu_.cgb())
+			clearFrameBuf(buf, pitch, 0x7FFF, indexed_lcd_off);
+		else
+			clearFrameBuf(buf, pitch, dmgColorsBgr15_[0], 0);
+		break;
+	case PPUFrameLog::frame_black:
+		clearFrameBuf(buf, pitch, 0x0000, indexed_black);
+		break;
+	default:
+		break;
+	}
+}
+
+bool LCD::renderLastFrame(uint_least32_t *const videoBuf, std::ptrdiff_t const pitch) {
+	switch (ppu_.lastFrame()) {
+	case PPUFrameLog::frame_incomplete:
+		return false;
+	case PPUFrameLog::frame_drawn:
+		ppu_.renderLastFrame(videoBuf, pitch);
+		break;
+	default:
+		clearFrame(ppu_.lastFrame(), videoBuf, pitch);
+		break;
+	}
+
+	return true;
+}
+
+void LCD::drawDeferredFrame() {
+	if (ppu_.threadsVideo())
+		clearFrame(ppu_.finishFrame(), ppu_.videoBuf(), ppu_.videoPitch());
+	else if (ppu_.defersVideo())
+		renderLastFrame(ppu_.videoBuf(), ppu_.videoPitch());
+}
+
+void LCD::resetCc(cc_t const oldCc, cc_t const newCc) {
 	update(oldCc);
 	ppu_.resetCc(oldCc, newCc);
 
 	if (ppu_.lcdc() & lcdc_en) {
-		unsigned long const dec = oldCc - newCc;
+		cc_t const dec = oldCc - newCc;
 
 		nextM0Time_.invalidatePredictedNextM0Time();
 		lycIrq_.reschedule(ppu_.lyCounter(), newCc);
@@ -316,7 +457,7 @@ void LCD::resetCc(unsigned long const oldCc, unsigned long const newCc) {
 	}
 }
 
-void LCD::speedChange(unsigned long const cc) {
+void LCD::speedChange(cc_t const cc) {
 	update(cc);
 	ppu_.speedChange();
 
@@ -339,7 +480,7 @@ void LCD::speedChange(unsigned long const cc) {
 	}
 }
 
-unsigned long LCD::m0TimeOfCurrentLine(unsigned long const cc) {
+cc_t LCD::m0TimeOfCurrentLine(cc_t const cc) {
 	if (cc >= nextM0Time_.predictedNextM0Time()) {
 		update(cc);
 		nextM0Time_.predictNextM0Time(ppu_);
@@ -349,7 +490,7 @@ unsigned long LCD::m0TimeOfCurrentLine(unsigned long const cc) {
 		nextM0Time_.predictedNextM0Time());
 }
 
-void LCD::enableHdma(unsigned long const cc) {
+void LCD::enableHdma(cc_t const cc) {
 	if (cc >= eventTimes_.nextEventTime())
 		update(cc);
 
@@ -359,21 +500,21 @@ void LCD::enableHdma(unsigned long const cc) {
 	eventTimes_.setm<memevent_hdma>(nextM0Time_.predictedNextM0Time());
 }
 
-void LCD::disableHdma(unsigned long const cycleCounter) {
+void LCD::disableHdma(cc_t const cycleCounter) {
 	if (cycleCounter >= eventTimes_.nextEventTime())
 		update(cycleCounter);
 
 	eventTimes_.setm<memevent_hdma>(disabled_time);
 }
 
-bool LCD::isHdmaPeriod(unsigned long const cc) {
+bool LCD::isHdmaPeriod(cc_t const cc) {
 	if (cc >= eventTimes_.nextEventTime())
 		update(cc);
 
 	return ::isHdmaPeriod(ppu_.lyCounter(), m0TimeOfCurrentLine(cc), cc);
 }
 
-bool LCD::vramReadable(unsigned long const cc) {
+bool LCD::vramReadable(cc_t const cc) {
 	if (cc >= eventTimes_.nextEventTime())
 		update(cc);
 
@@ -384,7 +525,7 @@ bool LCD::vramReadable(unsigned long const cc) {
 	|| cc + 2 >= m0TimeOfCurrentLine(cc);
 }
 
-bool LCD::vramWritable(unsigned long const cc) {
+bool LCD::vramWritable(cc_t const cc) {
 	if (cc >= eventTimes_.nextEventTime())
 		update(cc);
 
@@ -395,7 +536,21 @@ bool LCD::vramWritable(unsigned long const cc) {
 	|| cc + 2 >= m0TimeOfCurrentLine(cc);
 }
 
-bool LCD::cgbpAccessible(unsigned long const cc) {
+// true if vram stays writable, and is not fetched from by the ppu, from cc through end.
+bool LCD::vramWritableUntil(cc_t const cc, cc_t const end) {
+	if (cc >= eventTimes_.nextEventTime())
+		update(cc);
+
+	if (!(ppu_.lcdc() & lcdc_en))
+		return true;
+
+	if (ppu_.lyCounter().ly() >= lcd_vres)
+		return end < ppu_.lyCounter().nextFrameCycle(0, cc);
+
+	return end < ppu_.lyCounter().time() && cc >= m0TimeOfCurrentLine(cc);
+}
+
+bool LCD::cgbpAccessible(cc_t const cc) {
 	if (cc >= eventTimes_.nextEventTime())
 		update(cc);
 
@@ -406,21 +561,31 @@ bool LCD::cgbpAccessible(unsigned long const cc) {
 	|| cc >= m0TimeOfCurrentLine(cc) + 2;
 }
 
-void LCD::doCgbBgColorChange(unsigned index, unsigned data, unsigned long cc) {
+void LCD::doCgbBgColorChange(unsigned index, unsigned data, cc_t cc) {
 	if (cgbpAccessible(cc)) {
 		update(cc);
-		doCgbColorChange(bgpData_, ppu_.bgPalette(), index, data, isTrueColors());
+		if (isIndexed())
+			bgpData_[index] = data;
+		else {
+			doCgbColorChange(bgpData_, ppu_.bgPalette(), index, data, isTrueColors(), videoFormat());
+			ppu_.paletteChange();
+		}
 	}
 }
 
-void LCD::doCgbSpColorChange(unsigned index, unsigned data, unsigned long cc) {
+void LCD::doCgbSpColorChange(unsigned index, unsigned data, cc_t cc) {
 	if (cgbpAccessible(cc)) {
 		update(cc);
-		doCgbColorChange(objpData_, ppu_.spPalette(), index, data, isTrueColors());
+		if (isIndexed())
+			objpData_[index] = data;
+		else {
+			doCgbColorChange(objpData_, ppu_.spPalette(), index, data, isTrueColors(), videoFormat());
+			ppu_.paletteChange();
+		}
 	}
 }
 
-bool LCD::oamReadable(unsigned long const cc) {
+bool LCD::oamReadable(cc_t const cc) {
 	if (!(ppu_.lcdc() & lcdc_en) || ppu_.inactivePeriodAfterDisplayEnable(cc + 4))
 		return true;
 
@@ -433,7 +598,7 @@ bool LCD::oamReadable(unsigned long const cc) {
 	return ppu_.lyCounter().ly() >= lcd_vres || cc + 2 >= m0TimeOfCurrentLine(cc);
 }
 
-bool LCD::oamWritable(unsigned long const cc) {
+bool LCD::oamWritable(cc_t const cc) {
 	if (!(ppu_.lcdc() & lcdc_en) || ppu_.inactivePeriodAfterDisplayEnable(cc + 4 + isDoubleSpeed()))
 		return true;
 
@@ -452,7 +617,7 @@ void LCD::mode3CyclesChange() {
 
 	if (eventTimes_(memevent_m0irq) != disabled_time
 			&& eventTimes_(memevent_m0irq) > ppu_.now()) {
-		unsigned long t = ppu_.predictedNextXposTime(lcd_hres + 6);
+		cc_t t = ppu_.predictedNextXposTime(lcd_hres + 6);
 		eventTimes_.setm<memevent_m0irq>(t);
 	}
 
@@ -463,13 +628,13 @@ void LCD::mode3CyclesChange() {
 	}
 }
 
-void LCD::wxChange(unsigned newValue, unsigned long cycleCounter) {
+void LCD::wxChange(unsigned newValue, cc_t cycleCounter) {
 	update(cycleCounter + 1 + ppu_.cgb());
 	ppu_.setWx(newValue);
 	mode3CyclesChange();
 }
 
-void LCD::wyChange(unsigned const newValue, unsigned long const cc) {
+void LCD::wyChange(unsigned const newValue, cc_t const cc) {
 	update(cc + 1 + ppu_.cgb());
 	ppu_.setWy(newValue); 
 
@@ -487,18 +652,18 @@ void LCD::wyChange(unsigned const newValue, unsigned long const cc) {
 	}
 }
 
-void LCD::scxChange(unsigned newScx, unsigned long cycleCounter) {
+void LCD::scxChange(unsigned newScx, cc_t cycleCounter) {
 	update(cycleCounter + 2 * ppu_.cgb());
 	ppu_.setScx(newScx);
 	mode3CyclesChange();
 }
 
-void LCD::scyChange(unsigned newValue, unsigned long cycleCounter) {
+void LCD::scyChange(unsigned newValue, cc_t cycleCounter) {
 	update(cycleCounter + 2 * ppu_.cgb());
 	ppu_.setScy(newValue);
 }
 
-void LCD::oamChange(unsigned long cc) {
+void LCD::oamChange(cc_t cc) {
 	if (ppu_.lcdc() & lcdc_en) {
 		update(cc);
 		ppu_.oamChange(cc);
@@ -506,7 +671,7 @@ void LCD::oamChange(unsigned long cc) {
 	}
 }
 
-void LCD::oamChange(unsigned char const *oamram, unsigned long cc) {
+void LCD::oamChange(unsigned char const *oamram, cc_t cc) {
 	update(cc);
 	ppu_.oamChange(oamram, cc);
 
@@ -514,7 +679,7 @@ void LCD::oamChange(unsigned char const *oamram, unsigned long cc) {
 		eventTimes_.setm<memevent_spritemap>(SpriteMapper::schedule(ppu_.lyCounter(), cc));
 }
 
-void LCD::lcdcChange(unsigned const data, unsigned long const cc) {
+void LCD::lcdcChange(unsigned const data, cc_t const cc) {
 	unsigned const oldLcdc = ppu_.lcdc();
 
 	if ((oldLcdc ^ data) & lcdc_en) {
@@ -549,7 +714,7 @@ void LCD::lcdcChange(unsigned const data, unsigned long const cc) {
 			update(cc + 2);
 			ppu_.setLcdc(data, cc + 2);
 			if ((oldLcdc ^ data) & lcdc_obj2x) {
-				unsigned long t = SpriteMapper::schedule(ppu_.lyCounter(), cc + 2);
+				cc_t t = SpriteMapper::schedule(ppu_.lyCounter(), cc + 2);
 				eventTimes_.setm<memevent_spritemap>(t);
 			}
 			if ((oldLcdc ^ data) & lcdc_we)
@@ -560,7 +725,7 @@ void LCD::lcdcChange(unsigned const data, unsigned long const cc) {
 			if ((oldLcdc ^ data) & lcdc_obj2x) {
 				update(cc + 2);
 				ppu_.setLcdc(data, cc + 2);
-				unsigned long t = SpriteMapper::schedule(ppu_.lyCounter(), cc + 2);
+				cc_t t = SpriteMapper::schedule(ppu_.lyCounter(), cc + 2);
 				eventTimes_.setm<memevent_spritemap>(t);
 			}
 			if ((oldLcdc ^ data) & (lcdc_we | lcdc_objen))
@@ -579,7 +744,7 @@ struct LyCnt {
 	LyCnt(unsigned ly, int timeToNextLy) : ly(ly), timeToNextLy(timeToNextLy) {}
 };
 
-LyCnt const getLycCmpLy(LyCounter const &lyCounter, unsigned long cc) {
+LyCnt const getLycCmpLy(LyCounter const &lyCounter, cc_t cc) {
 	unsigned ly = lyCounter.ly();
 	int timeToNextLy = lyCounter.time() - cc;
 
@@ -612,12 +777,12 @@ unsigned incLy(unsigned ly) { return ly == lcd_lines_per_frame - 1 ? 0 : ly + 1;
 
 } // unnamed namespace.
 
-inline bool LCD::statChangeTriggersStatIrqDmg(unsigned const old, unsigned long const cc) {
+inline bool LCD::statChangeTriggersStatIrqDmg(unsigned const old, cc_t const cc) {
 	LyCnt const lycCmp = getLycCmpLy(ppu_.lyCounter(), cc);
 
 	if (ppu_.lyCounter().ly() < lcd_vres) {
 		int const m0_cycles_upper_bound = lcd_cycles_per_line - 80 - 160;
-		unsigned long m0IrqTime = eventTimes_(memevent_m0irq);
+		cc_t m0IrqTime = eventTimes_(memevent_m0irq);
 		if (m0IrqTime == disabled_time && ppu_.lyCounter().time() - cc < m0_cycles_upper_bound) {
 			update(cc);
 			m0IrqTime = ppu_.predictedNextXposTime(lcd_hres + 6);
@@ -635,7 +800,7 @@ inline bool LCD::statChangeTriggersStatIrqDmg(unsigned const old, unsigned long
 
 inline bool LCD::statChangeTriggersM0LycOrM1StatIrqCgb(
 		unsigned const old, unsigned const data, bool const lycperiod,
-		unsigned long const cc) {
+		cc_t const cc) {
 	int const ly = ppu_.lyCounter().ly();
 	int const timeToNextLy = ppu_.lyCounter().time() - cc;
 	bool const ds = isDoubleSpeed();
@@ -663,7 +828,7 @@ inline bool LCD::statChangeTriggersM0LycOrM1StatIrqCgb(
 }
 
 inline bool LCD::statChangeTriggersStatIrqCgb(
-		unsigned const old, unsigned const data, unsigned long const cc) {
+		unsigned const old, unsigned const data, cc_t const cc) {
 	if (!(data & ~old & (  lcdstat_lycirqen
 	                     | lcdstat_m2irqen
 	                     | lcdstat_m1irqen
@@ -683,13 +848,13 @@ inline bool LCD::statChangeTriggersStatIrqCgb(
 	|| statChangeTriggersM2IrqCgb(old, data, ly, timeToNextLy, isDoubleSpeed());
 }
 
-inline bool LCD::statChangeTriggersStatIrq(unsigned old, unsigned data, unsigned long cc) {
+inline bool LCD::statChangeTriggersStatIrq(unsigned old, unsigned data, cc_t cc) {
 	return ppu_.cgb()
 	? statChangeTriggersStatIrqCgb(old, data, cc)
 	: statChangeTriggersStatIrqDmg(old, cc);
 }
 
-void LCD::lcdstatChange(unsigned const data, unsigned long const cc) {
+void LCD::lcdstatChange(unsigned const data, cc_t const cc) {
 	if (cc >= eventTimes_.nextEventTime())
 		update(cc);
 
@@ -714,7 +879,7 @@ void LCD::lcdstatChange(unsigned const data, unsigned long const cc) {
 		eventTimes_(memevent_m2irq), cc, ppu_.cgb());
 }
 
-inline bool LCD::lycRegChangeStatTriggerBlockedByM0OrM1Irq(unsigned data, unsigned long cc) {
+inline bool LCD::lycRegChangeStatTriggerBlockedByM0OrM1Irq(unsigned data, cc_t cc) {
 	int const timeToNextLy = ppu_.lyCounter().time() - cc;
 	if (ppu_.lyCounter().ly() < lcd_vres) {
 		return (statReg_ & lcdstat_m0irqen)
@@ -728,7 +893,7 @@ inline bool LCD::lycRegChangeStatTriggerBlockedByM0OrM1Irq(unsigned data, unsign
 }
 
 bool LCD::lycRegChangeTriggersStatIrq(
-		unsigned const old, unsigned const data, unsigned long const cc) {
+		unsigned const old, unsigned const data, cc_t const cc) {
 	if (!(statReg_ & lcdstat_lycirqen) || data >= lcd_lines_per_frame
 			|| lycRegChangeStatTriggerBlockedByM0OrM1Irq(data, cc)) {
 		return false;
@@ -745,7 +910,7 @@ bool LCD::lycRegChangeTriggersStatIrq(
 	return data == lycCmp.ly;
 }
 
-void LCD::lycRegChange(unsigned const data, unsigned long const cc) {
+void LCD::lycRegChange(unsigned const data, cc_t const cc) {
 	unsigned const old = lycIrq_.lycReg();
 	if (data == old)
 		return;
@@ -769,7 +934,7 @@ void LCD::lycRegChange(unsigned const data, unsigned long const cc) {
 	}
 }
 
-unsigned LCD::getStat(unsigned const lycReg, unsigned long const cc) {
+unsigned LCD::getStat(unsigned const lycReg, cc_t const cc) {
 	unsigned stat = 0;
 
 	if (ppu_.lcdc() & lcdc_en) {
@@ -823,6 +988,12 @@ inline void LCD::doMode2IrqEvent() {
 }
 
 inline void LCD::event() {
+#ifdef GAMBATTE_EVENT_STATS
+	++eventCounts_[eventTimes_.nextEvent() == event_mem
+		? 1 + eventTimes_.nextMemEvent()
+		: 0];
+#endif
+
 	switch (eventTimes_.nextEvent()) {
 	case event_mem:
 		switch (eventTimes_.nextMemEvent()) {
@@ -886,7 +1057,23 @@ inline void LCD::event() {
 	}
 }
 
-void LCD::update(unsigned long const cycleCounter) {
+void LCD::getEventStats(unsigned long *const dest) const {
+	for (int i = 0; i < num_events - 1 + num_memevents; ++i) {
+#ifdef GAMBATTE_EVENT_STATS
+		dest[GB::EVENT_LCD_LY + i] = eventCounts_[i];
+#else
+		dest[GB::EVENT_LCD_LY + i] = 0;
+#endif
+	}
+}
+
+void LCD::resetEventStats() {
+#ifdef GAMBATTE_EVENT_STATS
+	std::fill_n(eventCounts_, num_events - 1 + num_memevents, 0);
+#endif
+}
+
+void LCD::update(cc_t const cycleCounter) {
 	if (!(ppu_.lcdc() & lcdc_en))
 		return;
 
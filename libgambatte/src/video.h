@@ -39,8 +39,8 @@ public:
 
 	void flagHdmaReq() const { if (!intreq_.halted()) gambatte::flagHdmaReq(intreq_); }
 	void flagIrq(unsigned bit) const { intreq_.flagIrq(bit); }
-	void flagIrq(unsigned bit, unsigned long cc) const { intreq_.flagIrq(bit, cc); }
-	void setNextEventTime(unsigned long time) const { intreq_.setEventTime<intevent_video>(time); }
+	void flagIrq(unsigned bit, cc_t cc) const { intreq_.flagIrq(bit, cc); }
+	void setNextEventTime(cc_t time) const { intreq_.setEventTime<intevent_video>(time); }
 
 private:
 	InterruptRequester &intreq_;
@@ -59,62 +59,76 @@ public:
 	void setVideoBuffer(uint_least32_t *videoBuf, std::ptrdiff_t pitch);
 	void copyCgbPalettesToDmg();
 	void setTrueColors(bool trueColors);
+	void setVideoFormat(GB::VideoFormat format);
+	void setRenderWindow(unsigned firstLine, unsigned lastLine) { ppu_.setRenderWindow(firstLine, lastLine); }
+	void getIndexedPalette(uint_least32_t *dest) const;
+	void getRgb32Palettes(uint_least32_t *bgPalette, uint_least32_t *spPalette) const;
 	void setOsdElement(transfer_ptr<OsdElement> osdElement) { osdElement_ = osdElement; }
 
-	void dmgBgPaletteChange(unsigned data, unsigned long cycleCounter) {
+	void dmgBgPaletteChange(unsigned data, cc_t cycleCounter) {
 		update(cycleCounter);
 		bgpData_[0] = data;
-		setDmgPalette(ppu_.bgPalette(), dmgColorsBgr15_, data, isTrueColors());
+		setDmgPalette(ppu_.bgPalette(), BG_PALETTE, data);
+		ppu_.paletteChange();
 	}
 
-	void dmgSpPalette1Change(unsigned data, unsigned long cycleCounter) {
+	void dmgSpPalette1Change(unsigned data, cc_t cycleCounter) {
 		update(cycleCounter);
 		objpData_[0] = data;
-		setDmgPalette(ppu_.spPalette(), dmgColorsBgr15_ + 4, data, isTrueColors());
+		setDmgPalette(ppu_.spPalette(), SP1_PALETTE, data);
+		ppu_.paletteChange();
 	}
 
-	void dmgSpPalette2Change(unsigned data, unsigned long cycleCounter) {
+	void dmgSpPalette2Change(unsigned data, cc_t cycleCounter) {
 		update(cycleCounter);
 		objpData_[1] = data;
-		setDmgPalette(ppu_.spPalette() + 4, dmgColorsBgr15_ + 8, data, isTrueColors());
+		setDmgPalette(ppu_.spPalette() + 4, SP2_PALETTE, data);
+		ppu_.paletteChange();
 	}
 
-	void cgbBgColorChange(unsigned index, unsigned data, unsigned long cycleCounter) {
+	void cgbBgColorChange(unsigned index, unsigned data, cc_t cycleCounter) {
 		if (bgpData_[index] != data)
 			doCgbBgColorChange(index, data, cycleCounter);
 	}
 
-	void cgbSpColorChange(unsigned index, unsigned data, unsigned long cycleCounter) {
+	void cgbSpColorChange(unsigned index, unsigned data, cc_t cycleCounter) {
 		if (objpData_[index] != data)
 			doCgbSpColorChange(index, data, cycleCounter);
 	}
 
-	unsigned cgbBgColorRead(unsigned index, unsigned long cycleCounter) {
+	unsigned cgbBgColorRead(unsigned index, cc_t cycleCounter) {
 		return ppu_.cgb() && cgbpAccessible(cycleCounter) ? bgpData_[index] : 0xFF;
 	}
 
-	unsigned cgbSpColorRead(unsigned index, unsigned long cycleCounter) {
+	unsigned cgbSpColorRead(unsigned index, cc_t cycleCounter) {
 		return ppu_.cgb() && cgbpAccessible(cycleCounter) ? objpData_[index] : 0xFF;
 	}
 
-	void updateScreen(bool blanklcd, unsigned long cc, unsigned stage);
+	void updateScreen(bool blanklcd, cc_t cc, unsigned stage);
 	void blackScreen();
-	void resetCc(unsigned long oldCC, unsigned long newCc);
-	void speedChange(unsigned long cycleCounter);
-	bool vramReadable(unsigned long cycleCounter);
-	bool vramWritable(unsigned long cycleCounter);
-	bool oamReadable(unsigned long cycleCounter);
-	bool oamWritable(unsigned long cycleCounter);
-	void wxChange(unsigned newValue, unsigned long cycleCounter);
-	void wyChange(unsigned newValue, unsigned long cycleCounter);
-	void oamChange(unsigned long cycleCounter);
-	void oamChange(const unsigned char *oamram, unsigned long cycleCounter);
-	void scxChange(unsigned newScx, unsigned long cycleCounter);
-	void scyChange(unsigned newValue, unsigned long cycleCounter);
-	void vramChange(unsigned long cycleCounter) { update(cycleCounter); }
-	unsigned getStat(unsigned lycReg, unsigned long cycleCounter);
-
-	unsigned getLyReg(unsigned long const cc) {
+	void resetCc(cc_t oldCC, cc_t newCc);
+	void speedChange(cc_t cycleCounter);
+	bool vramReadable(cc_t cycleCounter);
+	bool vramWritable(cc_t cycleCounter);
+	bool vramWritableUntil(cc_t cycleCounter, cc_t end);
+	bool oamReadable(cc_t cycleCounter);
+	bool oamWritable(cc_t cycleCounter);
+	void wxChange(unsigned newValue, cc_t cycleCounter);
+	void wyChange(unsigned newValue, cc_t cycleCounter);
+	void oamChange(cc_t cycleCounter);
+	void oamChange(const unsigned char *oamram, cc_t cycleCounter);
+	void scxChange(unsigned newScx, cc_t cycleCounter);
+	void scyChange(unsigned newValue, cc_t cycleCounter);
+	void vramChange(cc_t cycleCounter) { update(cycleCounter); }
+	void vramWrite(unsigned char const *dst, unsigned data) { ppu_.vramWrite(dst, data); }
+
+	void vramWrite(unsigned char const *dst, unsigned char const *src, std::size_t n) {
+		ppu_.vramWrite(dst, src, n);
+	}
+
+	unsigned getStat(unsigned lycReg, cc_t cycleCounter);
+
+	unsigned getLyReg(cc_t const cc) {
 		unsigned lyReg = 0;
 
 		if (ppu_.lcdc() & lcdc_en) {
@@ -136,20 +150,28 @@ public:
 		return lyReg;
 	}
 
-	unsigned long nextMode1IrqTime() const { return eventTimes_(memevent_m1irq); }
-	void lcdcChange(unsigned data, unsigned long cycleCounter);
-	void lcdstatChange(unsigned data, unsigned long cycleCounter);
-	void lycRegChange(unsigned data, unsigned long cycleCounter);
-	void enableHdma(unsigned long cycleCounter);
-	void disableHdma(unsigned long cycleCounter);
-	bool isHdmaPeriod(unsigned long cycleCounter);
+	// The line and line cycle at cc, without updating (LY reads differ around line changes).
+	void getRasterPos(cc_t cc, unsigned &ly, unsigned &lineCycle) const;
+	cc_t nextMode1IrqTime() const { return eventTimes_(memevent_m1irq); }
+	void lcdcChange(unsigned data, cc_t cycleCounter);
+	void lcdstatChange(unsigned data, cc_t cycleCounter);
+	void lycRegChange(unsigned data, cc_t cycleCounter);
+	void enableHdma(cc_t cycleCounter);
+	void disableHdma(cc_t cycleCounter);
+	bool isHdmaPeriod(cc_t cycleCounter);
 	bool hdmaIsEnabled() const { return eventTimes_(memevent_hdma) != disabled_time; }
-	void update(unsigned long cycleCounter);
+	void update(cc_t cycleCounter);
 	bool isCgb() const { return ppu_.cgb(); }
 	bool isCgbDmg() const { return ppu_.cgbDmg(); }
 	bool isDoubleSpeed() const { return ppu_.lyCounter().isDoubleSpeed(); }
 	bool isTrueColors() const { return ppu_.trueColors(); }
+	GB::VideoFormat videoFormat() const { return ppu_.frameBuf().format(); }
+	bool isIndexed() const { return videoFormat() == GB::INDEXED8; }
 	void setSpeedupFlags(unsigned flags) { ppu_.setSpeedupFlags(flags); }
+	bool renderLastFrame(uint_least32_t *videoBuf, std::ptrdiff_t pitch);
+	void drawDeferredFrame();
+	void getEventStats(unsigned long *dest) const;
+	void resetEventStats();
 
 private:
 	enum Event { event_mem,
@@ -177,21 +199,21 @@ private:
 		}
 
 		Event nextEvent() const { return static_cast<Event>(eventMin_.min()); }
-		unsigned long nextEventTime() const { return eventMin_.minValue(); }
-		unsigned long operator()(Event e) const { return eventMin_.value(e); }
-		template<Event e> void set(unsigned long time) { eventMin_.setValue<e>(time); }
-		void set(Event e, unsigned long time) { eventMin_.setValue(e, time); }
+		cc_t nextEventTime() const { return eventMin_.minValue(); }
+		cc_t operator()(Event e) const { return eventMin_.value(e); }
+		template<Event e> void set(cc_t time) { eventMin_.setValue<e>(time); }
+		void set(Event e, cc_t time) { eventMin_.setValue(e, time); }
 
 		MemEvent nextMemEvent() const { return static_cast<MemEvent>(memEventMin_.min()); }
-		unsigned long nextMemEventTime() const { return memEventMin_.minValue(); }
-		unsigned long operator()(MemEvent e) const { return memEventMin_.value(e); }
+		cc_t nextMemEventTime() const { return memEventMin_.minValue(); }
+		cc_t operator()(MemEvent e) const { return memEventMin_.value(e); }
 
 		template<MemEvent e>
-		void setm(unsigned long time) { memEventMin_.setValue<e>(time); setMemEvent(); }
-		void set(MemEvent e, unsigned long time) { memEventMin_.setValue(e, time); setMemEvent(); }
+		void setm(cc_t time) { memEventMin_.setValue<e>(time); setMemEvent(); }
+		void set(MemEvent e, cc_t time) { memEventMin_.setValue(e, time); setMemEvent(); }
 
 		void flagIrq(unsigned bit) { memEventRequester_.flagIrq(bit); }
-		void flagIrq(unsigned bit, unsigned long cc) { memEventRequester_.flagIrq(bit, cc); }
+		void flagIrq(unsigned bit, cc_t cc) { memEventRequester_.flagIrq(bit, cc); }
 		void flagHdmaReq() { memEventRequester_.flagHdmaReq(); }
 
 	private:
@@ -200,7 +222,7 @@ private:
 		VideoInterruptRequester memEventRequester_;
 
 		void setMemEvent() {
-			unsigned long nmet = nextMemEventTime();
+			cc_t nmet = nextMemEventTime();
 			eventMin_.setValue<event_mem>(nmet);
 			memEventRequester_.setNextEventTime(nmet);
 		}
@@ -216,26 +238,33 @@ private:
 	NextM0Time nextM0Time_;
 	scoped_ptr<OsdElement> osdElement_;
 	unsigned char statReg_;
+#ifdef GAMBATTE_EVENT_STATS
+	// event_ly, followed by the memevents.
+	unsigned long eventCounts_[num_events - 1 + num_memevents];
+#endif
 
-	static void setDmgPalette(unsigned long palette[],
-	                          unsigned short const dmgColors[],
-	                          unsigned data,
-	                          bool trueColor);
+	void setDmgPalette(unsigned long palette[], unsigned palNum, unsigned data);
 	void refreshPalettes();
+	void clearFrameBuf(unsigned bgr15, unsigned indexedValue) {
+		clearFrameBuf(ppu_.frameBuf().fb(), ppu_.frameBuf().pitch(), bgr15, indexedValue);
+	}
+
+	void clearFrameBuf(uint_least32_t *buf, std::ptrdiff_t pitch, unsigned bgr15, unsigned indexedValue);
+	void clearFrame(PPUFrameLog::Frame frame, uint_least32_t *buf, std::ptrdiff_t pitch);
 	void setDBuffer();
 	void doMode2IrqEvent();
 	void event();
-	unsigned long m0TimeOfCurrentLine(unsigned long cc);
-	bool cgbpAccessible(unsigned long cycleCounter);
-	bool lycRegChangeStatTriggerBlockedByM0OrM1Irq(unsigned data, unsigned long cc);
-	bool lycRegChangeTriggersStatIrq(unsigned old, unsigned data, unsigned long cc);
-	bool statChangeTriggersM0LycOrM1StatIrqCgb(unsigned old, unsigned data, bool lycperiod, unsigned long cc);
-	bool statChangeTriggersStatIrqCgb(unsigned old, unsigned data, unsigned long cc);
-	bool statChangeTriggersStatIrqDmg(unsigned old, unsigned long cc);
-	bool statChangeTriggersStatIrq(unsigned old, unsigned data, unsigned long cc);
+	cc_t m0TimeOfCurrentLine(cc_t cc);
+	bool cgbpAccessible(cc_t cycleCounter);
+	bool lycRegChangeStatTriggerBlockedByM0OrM1Irq(unsigned data, cc_t cc);
+	bool lycRegChangeTriggersStatIrq(unsigned old, unsigned data, cc_t cc);
+	bool statChangeTriggersM0LycOrM1StatIrqCgb(unsigned old, unsigned data, bool lycperiod, cc_t cc);
+	bool statChangeTriggersStatIrqCgb(unsigned old, unsigned data, cc_t cc);
+	bool statChangeTriggersStatIrqDmg(unsigned old, cc_t cc);
+	bool statChangeTriggersStatIrq(unsigned old, unsigned data, cc_t cc);
 	void mode3CyclesChange();
-	void doCgbBgColorChange(unsigned index, unsigned data, unsigned long cycleCounter);
-	void doCgbSpColorChange(unsigned index, unsigned data, unsigned long cycleCounter);
+	void doCgbBgColorChange(unsigned index, unsigned data, cc_t cycleCounter);
+	void doCgbSpColorChange(unsigned index, unsigned data, cc_t cycleCounter);
 };
 
 }
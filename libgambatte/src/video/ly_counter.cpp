@@ -39,23 +39,23 @@ void LyCounter::doEvent() {
 	time_ = time_ + lineTime_;
 }
 
-unsigned long LyCounter::nextLineCycle(unsigned const lineCycle, unsigned long const cc) const {
-	unsigned long tmp = time_ + (lineCycle << ds_);
+cc_t LyCounter::nextLineCycle(unsigned const lineCycle, cc_t const cc) const {
+	cc_t tmp = time_ + (lineCycle << ds_);
 	if (tmp - cc > lineTime_)
 		tmp -= lineTime_;
 
 	return tmp;
 }
 
-unsigned long LyCounter::nextFrameCycle(unsigned long const frameCycle, unsigned long const cc) const {
-	unsigned long tmp = time_ + (((lcd_lines_per_frame - 1l - ly()) * lcd_cycles_per_line + frameCycle) << ds_);
+cc_t LyCounter::nextFrameCycle(unsigned long const frameCycle, cc_t const cc) const {
+	cc_t tmp = time_ + (((lcd_lines_per_frame - 1l - ly()) * lcd_cycles_per_line + frameCycle) << ds_);
 	if (tmp - cc > 1ul * lcd_cycles_per_frame << ds_)
 		tmp -= 1ul * lcd_cycles_per_frame << ds_;
 
 	return tmp;
 }
 
-void LyCounter::reset(unsigned long videoCycles, unsigned long lastUpdate) {
+void LyCounter::reset(unsigned long videoCycles, cc_t lastUpdate) {
 	ly_ = videoCycles / lcd_cycles_per_line;
 	time_ = lastUpdate + ((lcd_cycles_per_line
 		- (videoCycles - 1l * ly_ * lcd_cycles_per_line)) << isDoubleSpeed());
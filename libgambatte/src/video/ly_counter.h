@@ -20,6 +20,7 @@
 #define LY_COUNTER_H
 
 #include "lcddef.h"
+#include "../counterdef.h"
 
 namespace gambatte {
 
@@ -31,24 +32,24 @@ public:
 	void doEvent();
 	bool isDoubleSpeed() const { return ds_; }
 
-	unsigned long frameCycles(unsigned long cc) const {
+	unsigned long frameCycles(cc_t cc) const {
 		return 1l * ly_ * lcd_cycles_per_line + lineCycles(cc);
 	}
 
-	unsigned lineCycles(unsigned long cc) const {
+	unsigned lineCycles(cc_t cc) const {
 		return lcd_cycles_per_line - ((time_ - cc) >> isDoubleSpeed());
 	}
 
 	unsigned lineTime() const { return lineTime_; }
 	unsigned ly() const { return ly_; }
-	unsigned long nextLineCycle(unsigned lineCycle, unsigned long cycleCounter) const;
-	unsigned long nextFrameCycle(unsigned long frameCycle, unsigned long cycleCounter) const;
-	void reset(unsigned long videoCycles, unsigned long lastUpdate);
+	cc_t nextLineCycle(unsigned lineCycle, cc_t cycleCounter) const;
+	cc_t nextFrameCycle(unsigned long frameCycle, cc_t cycleCounter) const;
+	void reset(unsigned long videoCycles, cc_t lastUpdate);
 	void setDoubleSpeed(bool ds);
-	unsigned long time() const { return time_; }
+	cc_t time() const { return time_; }
 
 private:
-	unsigned long time_;
+	cc_t time_;
 	unsigned short lineTime_;
 	unsigned char ly_;
 	bool ds_;
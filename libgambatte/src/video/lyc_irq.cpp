@@ -28,8 +28,8 @@ using namespace gambatte;
 
 namespace {
 
-unsigned long schedule(unsigned statReg,
-		unsigned lycReg, LyCounter const &lyCounter, unsigned long cc) {
+cc_t schedule(unsigned statReg,
+		unsigned lycReg, LyCounter const &lyCounter, cc_t cc) {
 	return (statReg & lcdstat_lycirqen) && lycReg < lcd_lines_per_frame
 	? lyCounter.nextFrameCycle(lycReg
 		? 1l * lycReg * lcd_cycles_per_line - 2
@@ -56,8 +56,8 @@ LycIrq::LycIrq()
 }
 
 void LycIrq::regChange(unsigned const statReg,
-		unsigned const lycReg, LyCounter const &lyCounter, unsigned long const cc) {
-	unsigned long const timeSrc = schedule(statReg, lycReg, lyCounter, cc);
+		unsigned const lycReg, LyCounter const &lyCounter, cc_t const cc) {
+	cc_t const timeSrc = schedule(statReg, lycReg, lyCounter, cc);
 	statRegSrc_ = statReg;
 	lycRegSrc_ = lycReg;
 	time_ = std::min(time_, timeSrc);
@@ -101,7 +101,7 @@ void LycIrq::saveState(SaveState &state) const {
 	state.ppu.lyc = lycReg_;
 }
 
-void LycIrq::reschedule(LyCounter const &lyCounter, unsigned long cc) {
+void LycIrq::reschedule(LyCounter const &lyCounter, cc_t cc) {
 	time_ = std::min(schedule(statReg_   , lycReg_   , lyCounter, cc),
 	                 schedule(statRegSrc_, lycRegSrc_, lyCounter, cc));
 }
@@ -19,6 +19,8 @@
 #ifndef VIDEO_LYC_IRQ_H
 #define VIDEO_LYC_IRQ_H
 
+#include "../counterdef.h"
+
 namespace gambatte {
 
 struct SaveState;
@@ -31,21 +33,21 @@ public:
 	unsigned lycReg() const { return lycRegSrc_; }
 	void loadState(SaveState const &state);
 	void saveState(SaveState &state) const;
-	unsigned long time() const { return time_; }
+	cc_t time() const { return time_; }
 	void setCgb(bool cgb) { cgb_ = cgb; }
 	void lcdReset();
-	void reschedule(LyCounter const &lyCounter, unsigned long cc);
+	void reschedule(LyCounter const &lyCounter, cc_t cc);
 
-	void statRegChange(unsigned statReg, LyCounter const &lyCounter, unsigned long cc) {
+	void statRegChange(unsigned statReg, LyCounter const &lyCounter, cc_t cc) {
 		regChange(statReg, lycRegSrc_, lyCounter, cc);
 	}
 
-	void lycRegChange(unsigned lycReg, LyCounter const &lyCounter, unsigned long cc) {
+	void lycRegChange(unsigned lycReg, LyCounter const &lyCounter, cc_t cc) {
 		regChange(statRegSrc_, lycReg, lyCounter, cc);
 	}
 
 private:
-	unsigned long time_;
+	cc_t time_;
  	unsigned char lycRegSrc_;
  	unsigned char statRegSrc_;
 	unsigned char lycReg_;
@@ -53,7 +55,7 @@ private:
 	bool cgb_;
 
 	void regChange(unsigned statReg, unsigned lycReg,
-	               LyCounter const &lyCounter, unsigned long cc);
+	               LyCounter const &lyCounter, cc_t cc);
 };
 
 }
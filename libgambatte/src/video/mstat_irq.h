@@ -13,14 +13,14 @@ public:
 	MStatIrqEvent() : lycReg_(0), statReg_(0) {}
 	void lcdReset(unsigned lycReg) { lycReg_ = lycReg; }
 
-	void lycRegChange(unsigned lycReg, unsigned long nextM0IrqTime,
-			unsigned long nextM2IrqTime, unsigned long cc, bool ds, bool cgb) {
+	void lycRegChange(unsigned lycReg, cc_t nextM0IrqTime,
+			cc_t nextM2IrqTime, cc_t cc, bool ds, bool cgb) {
 		if (cc + 5 * cgb + 1 - ds < std::min(nextM0IrqTime, nextM2IrqTime))
 			lycReg_ = lycReg;
 	}
 
-	void statRegChange(unsigned statReg, unsigned long nextM0IrqTime, unsigned long nextM1IrqTime,
-			unsigned long nextM2IrqTime, unsigned long cc, bool cgb) {
+	void statRegChange(unsigned statReg, cc_t nextM0IrqTime, cc_t nextM1IrqTime,
+			cc_t nextM2IrqTime, cc_t cc, bool cgb) {
 		if (cc + 2 * cgb < std::min(std::min(nextM0IrqTime, nextM1IrqTime), nextM2IrqTime))
 			statReg_ = statReg;
 	}
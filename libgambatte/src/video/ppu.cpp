@@ -17,6 +17,7 @@
 //
 
 #include "ppu.h"
+#include "tile_row.h"
 #include "gambatte.h"
 #include "savestate.h"
 
@@ -94,6 +95,7 @@ namespace StartWindowDraw {
 	DECLARE_FUNC(4, 0x94);
 	DECLARE_FUNC(5, 0x95);
 }
+void renderLine(PPUPriv &p, int tileState);
 } // namespace M3Loop
 
 #undef DECLARE_FUNC
@@ -123,6 +125,13 @@ inline int lcdcObj2x(PPUPriv const &p) { return p.lcdc & lcdc_obj2x; }
 inline int lcdcObjEn(PPUPriv const &p) { return p.lcdc & lcdc_objen; }
 inline int lcdcBgEn( PPUPriv const &p) { return p.lcdc & lcdc_bgen;  }
 
+// Whole tiles are not drawn with NO_VIDEO, nor while frames are logged to be drawn later,
+// nor on lines that go to the null line (outside the render window or without a buffer).
+// Unlike NO_VIDEO, the others leave single pixels (and the window state updated with them) alone.
+inline bool skipTiles(PPUPriv const &p) {
+	return (p.speedupFlags & GB::NO_VIDEO) || p.log || !p.framebuf.drawsLine();
+}
+
 inline int weMasterCheckLy0LineCycle(bool cgb) { return 1 + cgb; }
 inline int weMasterCheckPriorToLyIncLineCycle(bool /*cgb*/) { return 450; }
 inline int weMasterCheckAfterLyIncLineCycle(bool /*cgb*/) { return 454; }
@@ -139,6 +148,14 @@ inline void nextCall(int const cycles, PPUState const &state, PPUPriv &p) {
 	p.nextCallPtr = &state;
 }
 
+long cyclesUntilM0Upperbound(PPUPriv const &p) {
+	long cycles = xpos_end - p.xpos + 6;
+	for (int i = p.nextSprite; i < lcd_max_num_sprites_per_line && p.spriteList[i].spx < xpos_end; ++i)
+		cycles += 11;
+
+	return cycles;
+}
+
 inline unsigned long const * cgbSpPalette(PPUPriv const &p, unsigned const attrib) {
 	if (!p.cgbDmg)
 		return p.spPalette + (attrib & attr_cgbpalno) * num_palette_entries;
@@ -253,7 +270,55 @@ int loadTileDataByte1(PPUPriv const &p) {
 		+ ((p.nattrib & attr_yflip ? -1 : 0) ^ yoffset) % tile_len * tile_line_size + 1];
 }
 
+enum { oam_size = 4 * lcd_num_oam_entries, palettes_size = 2 * max_num_palettes * num_palette_entries };
+
+void logLineStart(PPUPriv &p) {
+	PPUFrameLog &log = *p.log;
+	if (log.frame != PPUFrameLog::frame_incomplete)
+		log.clear();
+
+	if (log.palettesChanged) {
+		log.palettes.insert(log.palettes.end(), p.bgPalette, p.bgPalette + palettes_size / 2);
+		log.palettes.insert(log.palettes.end(), p.spPalette, p.spPalette + palettes_size / 2);
+		log.palettesChanged = false;
+	}
+
+	if (log.oamChanged) {
+		log.oam.insert(log.oam.end(), p.spriteMapper.oamram(), p.spriteMapper.oamram() + oam_size);
+		log.oamChanged = false;
+	}
+
+	PPUFrameLog::Line const line = { p, log.vramWrites.size(),
+		log.palettes.size() - palettes_size, log.oam.size() - oam_size };
+	log.event(p.now - (p.cycles << p.lyCounter.isDoubleSpeed()), PPUFrameLog::event_line, log.lines.size());
+	log.lines.push_back(line);
+	log.lineOpen = true;
+}
+
 namespace M3Start {
+	// Draws the line from where its sprites are known. The frame log resumes lines from here.
+	void startLoop(PPUPriv &p) {
+		if (!skipTiles(p) && p.winDrawState == 0
+				&& !(p.wx < lcd_hres + 7 && (p.weMaster || (p.wy2 == p.lyCounter.ly() && lcdcWinEn(p))))
+				&& p.cycles - (1 - p.cgb) >= cyclesUntilM0Upperbound(p)) {
+			p.cycles -= 1 - p.cgb;
+			return M3Loop::renderLine(p, std::min(p.scx % tile_len, 5));
+		}
+
+		static PPUState const *const flut[] = {
+			&M3Loop::Tile::f0_,
+			&M3Loop::Tile::f1_,
+			&M3Loop::Tile::f2_,
+			&M3Loop::Tile::f3_,
+			&M3Loop::Tile::f4_,
+			&M3Loop::Tile::f5_,
+			&M3Loop::Tile::f5_,
+			&M3Loop::Tile::f5_
+		};
+
+		nextCall(1 - p.cgb, *flut[p.scx % tile_len], p);
+	}
+
 	void f0(PPUPriv &p) {
 		p.xpos = 0;
 
@@ -337,18 +402,10 @@ namespace M3Start {
 		p.xpos = 0;
 		p.endx = tile_len - p.scx % tile_len;
 
-		static PPUState const *const flut[] = {
-			&M3Loop::Tile::f0_,
-			&M3Loop::Tile::f1_,
-			&M3Loop::Tile::f2_,
-			&M3Loop::Tile::f3_,
-			&M3Loop::Tile::f4_,
-			&M3Loop::Tile::f5_,
-			&M3Loop::Tile::f5_,
-			&M3Loop::Tile::f5_
-		};
+		if (p.log)
+			logLineStart(p);
 
-		nextCall(1 - p.cgb, *flut[p.scx % tile_len], p);
+		startLoop(p);
 	}
 }
 
@@ -419,7 +476,7 @@ void doFullTilesUnrolledDmg(PPUPriv &p, int const xend, uint_least32_t *const db
 			uint_least32_t *const dstend = dst + n;
 			xpos += n;
 
-			if (!(p.speedupFlags & GB::NO_VIDEO)) {
+			if (!skipTiles(p)) {
 				if (!lcdcBgEn(p)) {
 					do { *dst++ = p.bgPalette[0]; } while (dst != dstend);
 					tileMapXpos += n / (1u * tile_len);
@@ -429,14 +486,7 @@ void doFullTilesUnrolledDmg(PPUPriv &p, int const xend, uint_least32_t *const db
 					ntileword = expand_lut[(tileDataLine + ts * tno - 2 * ts * (tno & tileIndexSign))[0]]
 						  + expand_lut[(tileDataLine + ts * tno - 2 * ts * (tno & tileIndexSign))[1]] * 2;
 				} else do {
-					dst[0] = p.bgPalette[ ntileword & tile_bpp_mask                                 ];
-					dst[1] = p.bgPalette[(ntileword & tile_bpp_mask << 1 * tile_bpp) >> 1 * tile_bpp];
-					dst[2] = p.bgPalette[(ntileword & tile_bpp_mask << 2 * tile_bpp) >> 2 * tile_bpp];
-					dst[3] = p.bgPalette[(ntileword & tile_bpp_mask << 3 * tile_bpp) >> 3 * tile_bpp];
-					dst[4] = p.bgPalette[(ntileword & tile_bpp_mask << 4 * tile_bpp) >> 4 * tile_bpp];
-					dst[5] = p.bgPalette[(ntileword & tile_bpp_mask << 5 * tile_bpp) >> 5 * tile_bpp];
-					dst[6] = p.bgPalette[(ntileword & tile_bpp_mask << 6 * tile_bpp) >> 6 * tile_bpp];
-					dst[7] = p.bgPalette[ ntileword                                  >> 7 * tile_bpp];
+					writeTileRow(dst, ntileword, p.bgPalette);
 					dst += tile_len;
 
 					unsigned const tno = tileMapLine[tileMapXpos % tile_map_len];
@@ -457,18 +507,11 @@ void doFullTilesUnrolledDmg(PPUPriv &p, int const xend, uint_least32_t *const db
 			p.cycles = cycles;
 		}
 
-		if (!(p.speedupFlags & GB::NO_VIDEO)) {
+		if (!skipTiles(p)) {
 			uint_least32_t *const dst = dbufline + (xpos - tile_len);
 			unsigned const tileword = -(p.lcdc & 1u * lcdc_bgen) & p.ntileword;
 
-			dst[0] = p.bgPalette[ tileword & tile_bpp_mask                                 ];
-			dst[1] = p.bgPalette[(tileword & tile_bpp_mask << 1 * tile_bpp) >> 1 * tile_bpp];
-			dst[2] = p.bgPalette[(tileword & tile_bpp_mask << 2 * tile_bpp) >> 2 * tile_bpp];
-			dst[3] = p.bgPalette[(tileword & tile_bpp_mask << 3 * tile_bpp) >> 3 * tile_bpp];
-			dst[4] = p.bgPalette[(tileword & tile_bpp_mask << 4 * tile_bpp) >> 4 * tile_bpp];
-			dst[5] = p.bgPalette[(tileword & tile_bpp_mask << 5 * tile_bpp) >> 5 * tile_bpp];
-			dst[6] = p.bgPalette[(tileword & tile_bpp_mask << 6 * tile_bpp) >> 6 * tile_bpp];
-			dst[7] = p.bgPalette[ tileword                                  >> 7 * tile_bpp];
+			writeTileRow(dst, tileword, p.bgPalette);
 
 			int i = nextSprite - 1;
 
@@ -613,7 +656,7 @@ void doFullTilesUnrolledCgb(PPUPriv &p, int const xend, uint_least32_t *const db
 			uint_least32_t *const dstend = dst + n;
 			xpos += n;
 
-			if (!(p.speedupFlags & GB::NO_VIDEO)) {
+			if (!skipTiles(p)) {
 				if (!lcdcBgEn(p) && p.cgbDmg) {
 					do { *dst++ = p.bgPalette[0]; } while (dst != dstend);
 					tileMapXpos += n / (1u * tile_len);
@@ -625,14 +668,7 @@ void doFullTilesUnrolledCgb(PPUPriv &p, int const xend, uint_least32_t *const db
 				} else do {
 					unsigned long const *const bgPalette = p.bgPalette
 						+ (nattrib & attr_cgbpalno) * num_palette_entries;
-					dst[0] = bgPalette[ ntileword & tile_bpp_mask                                 ];
-					dst[1] = bgPalette[(ntileword & tile_bpp_mask << 1 * tile_bpp) >> 1 * tile_bpp];
-					dst[2] = bgPalette[(ntileword & tile_bpp_mask << 2 * tile_bpp) >> 2 * tile_bpp];
-					dst[3] = bgPalette[(ntileword & tile_bpp_mask << 3 * tile_bpp) >> 3 * tile_bpp];
-					dst[4] = bgPalette[(ntileword & tile_bpp_mask << 4 * tile_bpp) >> 4 * tile_bpp];
-					dst[5] = bgPalette[(ntileword & tile_bpp_mask << 5 * tile_bpp) >> 5 * tile_bpp];
-					dst[6] = bgPalette[(ntileword & tile_bpp_mask << 6 * tile_bpp) >> 6 * tile_bpp];
-					dst[7] = bgPalette[ ntileword                                  >> 7 * tile_bpp];
+					writeTileRow(dst, ntileword, bgPalette);
 					dst += tile_len;
 
 					unsigned const tno = tileMapLine[tileMapXpos % tile_map_len                 ];
@@ -659,20 +695,13 @@ void doFullTilesUnrolledCgb(PPUPriv &p, int const xend, uint_least32_t *const db
 			p.cycles = cycles;
 		}
 
-		if (!(p.speedupFlags & GB::NO_VIDEO)) {
+		if (!skipTiles(p)) {
 			uint_least32_t *const dst = dbufline + (xpos - tile_len);
 			unsigned const tileword = ((p.lcdc & 1u * lcdc_bgen) | !p.cgbDmg) * p.ntileword;
 			unsigned const attrib   = p.nattrib;
 			unsigned long const *const bgPalette = p.bgPalette
 				+ (attrib & attr_cgbpalno) * num_palette_entries;
-			dst[0] = bgPalette[ tileword & tile_bpp_mask                                 ];
-			dst[1] = bgPalette[(tileword & tile_bpp_mask << 1 * tile_bpp) >> 1 * tile_bpp];
-			dst[2] = bgPalette[(tileword & tile_bpp_mask << 2 * tile_bpp) >> 2 * tile_bpp];
-			dst[3] = bgPalette[(tileword & tile_bpp_mask << 3 * tile_bpp) >> 3 * tile_bpp];
-			dst[4] = bgPalette[(tileword & tile_bpp_mask << 4 * tile_bpp) >> 4 * tile_bpp];
-			dst[5] = bgPalette[(tileword & tile_bpp_mask << 5 * tile_bpp) >> 5 * tile_bpp];
-			dst[6] = bgPalette[(tileword & tile_bpp_mask << 6 * tile_bpp) >> 6 * tile_bpp];
-			dst[7] = bgPalette[ tileword                                  >> 7 * tile_bpp];
+			writeTileRow(dst, tileword, bgPalette);
 
 			int i = nextSprite - 1;
 
@@ -929,7 +958,7 @@ void plotPixelIfNoSprite(PPUPriv &p) {
 		plotPixel(p);
 }
 
-unsigned long nextM2Time(PPUPriv const &p) {
+cc_t nextM2Time(PPUPriv const &p) {
 	int const nm2 = p.lyCounter.ly() < lcd_vres - 1
 		? weMasterCheckPriorToLyIncLineCycle(p.cgb)
 		: lcd_cycles_per_line * (lcd_lines_per_frame - p.lyCounter.ly())
@@ -938,9 +967,15 @@ unsigned long nextM2Time(PPUPriv const &p) {
 }
 
 void xposEnd(PPUPriv &p) {
+	p.framebuf.flushLine(lcd_hres);
 	p.lastM0Time = p.now - (p.cycles << p.lyCounter.isDoubleSpeed());
 
-	unsigned long const nextm2 = nextM2Time(p);
+	if (p.log && p.log->lineOpen) {
+		p.log->event(p.lastM0Time, PPUFrameLog::event_line_end, 0);
+		p.log->lineOpen = false;
+	}
+
+	cc_t const nextm2 = nextM2Time(p);
 	p.cycles = p.now >= nextm2
 		? static_cast<long>((p.now - nextm2) >> p.lyCounter.isDoubleSpeed())
 		: -static_cast<long>((nextm2 - p.now) >> p.lyCounter.isDoubleSpeed());
@@ -1248,6 +1283,111 @@ namespace Tile {
 	}
 }
 
+// Runs the Tile states for the rest of a line without going through nextCall, for lines
+// where the window cannot start and mode 3 is known to end within the current update
+// (so no register can change before then). Pixels with no sprite to consider are plotted
+// directly, the rest is left to plotPixel and LoadSprites as usual. Leaves the exact same
+// state behind as the Tile states would.
+void renderLine(PPUPriv &p, int tileState) {
+	static PPUState const *const tileStates[] = {
+		&Tile::f0_, &Tile::f1_, &Tile::f2_, &Tile::f3_, &Tile::f4_, &Tile::f5_ };
+	uint_least32_t *const fbline = p.framebuf.fbline();
+
+	for (;;) {
+		switch (tileState) {
+		case 0:
+			doFullTilesUnrolled(p);
+
+			if (p.xpos == xpos_end) {
+				++p.cycles;
+				return xposEnd(p);
+			}
+
+			p.tileword = p.ntileword;
+			p.attrib = p.nattrib;
+			p.endx = std::min(1u * xpos_end, p.xpos + 1u * tile_len);
+			p.reg1    = p.vram[((tile_map_size / lcdc_bgtmsel * p.lcdc | (p.scx + p.xpos + 1u - p.cgb) / tile_len)
+			                     & (tile_map_size + tile_map_len - 1))
+			                 + tile_map_len / tile_len * ((p.scy + p.lyCounter.ly()) & (0x100 - tile_len))
+			                 + tile_map_begin];
+			p.nattrib = p.vram[((tile_map_size / lcdc_bgtmsel * p.lcdc | (p.scx + p.xpos + 1u - p.cgb) / tile_len)
+			                     & (tile_map_size + tile_map_len - 1))
+			                 + tile_map_len / tile_len * ((p.scy + p.lyCounter.ly()) & (0x100 - tile_len))
+			                 + tile_map_begin + vram_bank_size];
+			break;
+		case 2:
+			p.reg0 = loadTileDataByte0(p);
+			break;
+		case 4:
+			{
+				int const r1 = loadTileDataByte1(p);
+				p.ntileword = (expand_lut + (0x100 / attr_xflip * p.nattrib & 0x100))[p.reg0]
+				            + (expand_lut + (0x100 / attr_xflip * p.nattrib & 0x100))[r1    ] * 2;
+			}
+
+			break;
+		case 5:
+			if (p.spriteList[p.nextSprite].spx < p.endx
+					|| (p.nextSprite > 0 && spx(p.spriteList[p.nextSprite - 1]) > p.xpos - tile_len)
+					|| p.cycles < p.endx - p.xpos - 1) {
+				return Tile::f5(p);
+			}
+
+			{
+				unsigned const twmask = ((p.lcdc & lcdc_bgen) | (p.cgb * !p.cgbDmg)) * tile_bpp_mask;
+				unsigned long const *const bgPalette = p.bgPalette
+					+ (p.attrib & attr_cgbpalno) * num_palette_entries;
+				int xpos = p.xpos;
+				unsigned tileword = p.tileword;
+				p.cycles -= p.endx - xpos - 1;
+
+				do {
+					if (xpos >= tile_len)
+						fbline[xpos - tile_len] = bgPalette[tileword & twmask];
+
+					tileword >>= tile_bpp;
+				} while (++xpos != p.endx);
+
+				p.xpos = xpos;
+				p.tileword = tileword;
+			}
+
+			if (p.xpos == xpos_end)
+				return xposEnd(p);
+
+			tileState = 0;
+			if (--p.cycles < 0) {
+				p.nextCallPtr = tileStates[tileState];
+				return;
+			}
+
+			continue;
+		}
+
+		if (p.spriteList[p.nextSprite].spx == p.xpos
+				|| (p.nextSprite > 0 && spx(p.spriteList[p.nextSprite - 1]) > p.xpos - tile_len)) {
+			plotPixelIfNoSprite(p);
+		} else {
+			unsigned const twdata = p.tileword
+				& ((p.lcdc & lcdc_bgen) | (p.cgb * !p.cgbDmg)) * tile_bpp_mask;
+			if (p.xpos >= tile_len)
+				fbline[p.xpos - tile_len] = p.bgPalette[twdata + (p.attrib & attr_cgbpalno) * num_palette_entries];
+
+			++p.xpos;
+			p.tileword >>= tile_bpp;
+		}
+
+		if (p.xpos == xpos_end)
+			return xposEnd(p);
+
+		++tileState;
+		if (--p.cycles < 0) {
+			p.nextCallPtr = tileStates[tileState];
+			return;
+		}
+	}
+}
+
 } // namespace M3Loop
 
 namespace M2_Ly0 {
@@ -1555,19 +1695,15 @@ namespace M2_LyNon0 {
 
 } // anon namespace
 
-PPUPriv::PPUPriv(NextM0Time &nextM0Time, unsigned char const *const oamram, unsigned char const *const vram)
+PPULineState::PPULineState()
 : spriteList()
 , spwordList()
 , nextSprite(0)
 , currentSprite(0xFF)
-, vram(vram)
-, nextCallPtr(&M2_Ly0::f0_)
 , now(0)
-, lastM0Time(0)
 , cycles(-4396)
 , tileword(0)
 , ntileword(0)
-, spriteMapper(nextM0Time, lyCounter, oamram)
 , lcdc(0)
 , scy(0)
 , scx(0)
@@ -1583,13 +1719,47 @@ PPUPriv::PPUPriv(NextM0Time &nextM0Time, unsigned char const *const oamram, unsi
 , nattrib(0)
 , xpos(0)
 , endx(0)
-, cgb(false)
+, cgbDmg(false)
 , weMaster(false)
+{
+}
+
+PPUPriv::PPUPriv(NextM0Time &nextM0Time, unsigned char const *const oamram, unsigned char const *const vram)
+: vram(vram)
+, nextCallPtr(&M2_Ly0::f0_)
+, lastM0Time(0)
+, spriteMapper(nextM0Time, lyCounter, oamram)
+, log(0)
+, cgb(false)
 , trueColors(false)
 , speedupFlags(0)
 {
 }
 
+void PPUFrameLog::clear() {
+	events.clear();
+	lines.clear();
+	vramWrites.clear();
+	palettes.clear();
+	oam.clear();
+	frame = frame_incomplete;
+	lineOpen = false;
+	palettesChanged = true;
+	oamChanged = true;
+}
+
+void PPUFrameLog::swap(PPUFrameLog &log) {
+	events.swap(log.events);
+	lines.swap(log.lines);
+	vramWrites.swap(log.vramWrites);
+	palettes.swap(log.palettes);
+	oam.swap(log.oam);
+	std::swap(frame, log.frame);
+	std::swap(lineOpen, log.lineOpen);
+	std::swap(palettesChanged, log.palettesChanged);
+	std::swap(oamChanged, log.oamChanged);
+}
+
 namespace {
 
 template<class T, class K, std::size_t start, std::size_t len>
@@ -1647,14 +1817,6 @@ PPUState const * decodeM3LoopState(unsigned state) {
 	return 0;
 }
 
-long cyclesUntilM0Upperbound(PPUPriv const &p) {
-	long cycles = xpos_end - p.xpos + 6;
-	for (int i = p.nextSprite; i < lcd_max_num_sprites_per_line && p.spriteList[i].spx < xpos_end; ++i)
-		cycles += 11;
-
-	return cycles;
-}
-
 void saveSpriteList(PPUPriv const &p, SaveState &ss) {
 	for (int i = 0; i < lcd_max_num_sprites_per_line; ++i) {
 		ss.ppu.spAttribList[i] = p.spriteList[i].attrib;
@@ -1724,6 +1886,7 @@ void PPU::loadState(SaveState const &ss, unsigned char const *const oamram) {
 	bool const ds = p_.cgb & ss.mem.ioamhram.get()[0x14D] >> 7;
 	long const lineCycles = static_cast<unsigned long>(videoCycles) % lcd_cycles_per_line;
 
+	dropFrames();
 	p_.now = ss.cpu.cycleCounter;
 	p_.lcdc = ss.mem.ioamhram.get()[0x140];
 	p_.lyCounter.setDoubleSpeed(ds);
@@ -1785,20 +1948,30 @@ void PPU::reset(unsigned char const *oamram, unsigned char const *vram, bool cgb
 	p_.cgb = cgb;
 	p_.cgbDmg = false;
 	p_.spriteMapper.reset(oamram, cgb);
+	dropFrames();
 }
 
-void PPU::resetCc(unsigned long const oldCc, unsigned long const newCc) {
-	unsigned long const dec = oldCc - newCc;
+void PPU::resetCc(cc_t const oldCc, cc_t const newCc) {
+	cc_t const dec = oldCc - newCc;
 	unsigned long const videoCycles = lcdcEn(p_) ? p_.lyCounter.frameCycles(p_.now) : 0;
 
 	p_.now -= dec;
 	p_.lastM0Time = p_.lastM0Time ? p_.lastM0Time - dec : p_.lastM0Time;
 	p_.lyCounter.reset(videoCycles, p_.now);
 	p_.spriteMapper.resetCycleCounter(oldCc, newCc);
+
+	for (std::vector<PPUFrameLog::Event>::iterator it = log_.events.begin(); it != log_.events.end(); ++it)
+		it->time -= dec;
+
+	for (std::vector<PPUFrameLog::Line>::iterator it = log_.lines.begin(); it != log_.lines.end(); ++it) {
+		unsigned long const lineVideoCycles = it->state.lyCounter.frameCycles(it->state.now);
+		it->state.now -= dec;
+		it->state.lyCounter.reset(lineVideoCycles, it->state.now);
+	}
 }
 
 void PPU::speedChange() {
-	unsigned long const now = p_.now;
+	cc_t const now = p_.now;
 	unsigned long const videoCycles = lcdcEn(p_) ? p_.lyCounter.frameCycles(now) : 0;
 
 	p_.now -= p_.lyCounter.isDoubleSpeed();
@@ -1807,51 +1980,276 @@ void PPU::speedChange() {
 	p_.lyCounter.reset(videoCycles, p_.now);
 }
 
-unsigned long PPU::predictedNextXposTime(unsigned xpos) const {
+cc_t PPU::predictedNextXposTime(unsigned xpos) const {
 	return p_.now
 	    + (p_.nextCallPtr->predictCyclesUntilXpos_f(p_, xpos, -p_.cycles) << p_.lyCounter.isDoubleSpeed());
 }
 
-void PPU::setLcdc(unsigned const lcdc, unsigned long const cc) {
-	if ((p_.lcdc ^ lcdc) & lcdc & lcdc_en) {
-		p_.now = cc;
-		p_.lastM0Time = 0;
-		p_.lyCounter.reset(0, p_.now);
-		p_.spriteMapper.enableDisplay(cc);
-		p_.weMaster = (lcdc & lcdc_we) && 0 == p_.wy;
-		p_.winDrawState = 0;
-		p_.nextCallPtr = &M3Start::f0_;
-		p_.cycles = -(m3StartLineCycle(p_.cgb) + 2);
-	} else if ((p_.lcdc ^ lcdc) & lcdc_we) {
+namespace {
+
+void lcdcChange(PPUPriv &p, unsigned const lcdc, cc_t const cc) {
+	if ((p.lcdc ^ lcdc) & p.lcdc & lcdc_en) {
+		// keep what was drawn of a line interrupted by display disable
+		if (decodeM3LoopState(p.nextCallPtr->id) && p.xpos > tile_len && p.xpos < xpos_end)
+			p.framebuf.flushLine(p.xpos - tile_len);
+	}
+
+	if ((p.lcdc ^ lcdc) & lcdc & lcdc_en) {
+		p.now = cc;
+		p.lastM0Time = 0;
+		p.lyCounter.reset(0, p.now);
+		p.spriteMapper.enableDisplay(cc);
+		p.weMaster = (lcdc & lcdc_we) && 0 == p.wy;
+		p.winDrawState = 0;
+		p.nextCallPtr = &M3Start::f0_;
+		p.cycles = -(m3StartLineCycle(p.cgb) + 2);
+	} else if ((p.lcdc ^ lcdc) & lcdc_we) {
 		if (!(lcdc & lcdc_we)) {
-			if (p_.winDrawState == win_draw_started || p_.xpos == xpos_end)
-				p_.winDrawState &= ~(1u * win_draw_started);
-		} else if (p_.winDrawState == win_draw_start) {
-			p_.winDrawState |= win_draw_started;
-			++p_.winYPos;
+			if (p.winDrawState == win_draw_started || p.xpos == xpos_end)
+				p.winDrawState &= ~(1u * win_draw_started);
+		} else if (p.winDrawState == win_draw_start) {
+			p.winDrawState |= win_draw_started;
+			++p.winYPos;
 		}
 	}
 
-	if ((p_.lcdc ^ lcdc) & lcdc_obj2x) {
-		if (p_.lcdc & lcdc & lcdc_en)
-			p_.spriteMapper.oamChange(cc);
+	if ((p.lcdc ^ lcdc) & lcdc_obj2x) {
+		if (p.lcdc & lcdc & lcdc_en)
+			p.spriteMapper.oamChange(cc);
+
+		p.spriteMapper.setLargeSpritesSource(lcdc & lcdc_obj2x);
+	}
+
+	p.lcdc = lcdc;
+}
+
+void runUntil(PPUPriv &p, cc_t const cc) {
+	// replayed events can be before the line start logged, so shift the signed difference
+	long const cycles = static_cast<long>(cc - p.now) >> p.lyCounter.isDoubleSpeed();
+
+	p.now += cycles << p.lyCounter.isDoubleSpeed();
+	p.cycles += cycles;
+
+	if (p.cycles >= 0) {
+		p.framebuf.setFbline(p.lyCounter.ly());
+
+		if (!(p.speedupFlags & GB::NO_PPU_CALL))
+			p.nextCallPtr->f(p);
+	}
+}
+
+} // anon namespace
+
+void PPU::setLcdc(unsigned const lcdc, cc_t const cc) {
+	if (p_.log) {
+		logEvent(PPUFrameLog::event_lcdc, lcdc);
+		if ((p_.lcdc ^ lcdc) & p_.lcdc & lcdc_en)
+			log_.lineOpen = false;
+		else if ((p_.lcdc ^ lcdc) & lcdc & lcdc_en)
+			log_.oamChanged = true; // OAM writes are not reported while the display is off
+	}
+
+	lcdcChange(p_, lcdc, cc);
+}
+
+void PPU::update(cc_t const cc) {
+	runUntil(p_, cc);
+}
+
+void PPU::oamChange(cc_t const cc) {
+	p_.spriteMapper.oamChange(cc);
+	if (p_.log)
+		log_.oamChanged = true;
+}
+
+void PPU::oamChange(unsigned char const *const oamram, cc_t const cc) {
+	p_.spriteMapper.oamChange(oamram, cc);
+	if (p_.log && log_.lineOpen) {
+		log_.event(p_.now, PPUFrameLog::event_oam, log_.oam.size());
+		log_.oam.insert(log_.oam.end(), oamram, oamram + oam_size);
+	} else if (p_.log)
+		log_.oamChanged = true;
+}
+
+void PPU::logPaletteChange() {
+	if (log_.lineOpen) {
+		log_.event(p_.now, PPUFrameLog::event_palettes, log_.palettes.size());
+		log_.palettes.insert(log_.palettes.end(), p_.bgPalette, p_.bgPalette + palettes_size / 2);
+		log_.palettes.insert(log_.palettes.end(), p_.spPalette, p_.spPalette + palettes_size / 2);
+	} else
+		log_.palettesChanged = true;
+}
+
+void PPU::setFrameBuf(uint_least32_t *const buf, std::ptrdiff_t const pitch) {
+	videoBuf_ = buf;
+	videoPitch_ = pitch;
+	p_.framebuf.setBuf(p_.log ? 0 : buf, pitch);
+}
+
+void PPU::setVideoFormat(GB::VideoFormat const format) {
+	dropFrames();
+	p_.framebuf.setFormat(format);
+}
+
+void PPU::setRenderWindow(unsigned const firstLine, unsigned const lastLine) {
+	p_.framebuf.setWindow(firstLine, std::min(lastLine, lcd_vres - 1u));
+}
+
+void PPU::setSpeedupFlags(unsigned const flags) {
+	unsigned const logFlags = GB::DEFER_VIDEO | GB::THREADED_VIDEO;
+	unsigned const changed = flags ^ p_.speedupFlags;
+	if (changed & logFlags) {
+		dropFrames();
+		p_.log = flags & logFlags ? &log_ : 0;
+		std::vector<uint_least32_t>(flags & GB::THREADED_VIDEO ? lcd_hres * lcd_vres : 0).swap(drawBuf_);
+	}
+
+	p_.speedupFlags = flags;
+	if (changed & logFlags)
+		setFrameBuf(videoBuf_, videoPitch_);
+}
+
+PPUFrameLog::Frame PPU::endFrame(PPUFrameLog::Frame const frame) {
+	if (!p_.log)
+		return PPUFrameLog::frame_incomplete;
+
+	if (log_.frame != PPUFrameLog::frame_incomplete)
+		log_.clear();
+
+	log_.lineOpen = false;
+	log_.frame = frame;
+	if (!threadsVideo())
+		return PPUFrameLog::frame_incomplete;
+
+	PPUFrameLog::Frame const shown = finishFrame();
+	drawnFrame_ = frame;
+	if (frame == PPUFrameLog::frame_drawn) {
+		startReplay(log_);
+		log_.swap(drawLog_);
+		worker_.start(drawFrame, this);
+	}
+
+	log_.clear();
+	return shown;
+}
+
+namespace {
 
-		p_.spriteMapper.setLargeSpritesSource(lcdc & lcdc_obj2x);
+void copyFrame(uint_least32_t *const dst, std::ptrdiff_t const pitch, uint_least32_t const *const src,
+		PPUFrameBuf const &drawn) {
+	GB::VideoFormat const format = drawn.format();
+	std::size_t const pixelSize = format == GB::RGB32
+		? sizeof *src
+		: format == GB::INDEXED8 ? 1 : sizeof(uint_least16_t);
+	for (unsigned y = drawn.firstLine(); y <= drawn.lastLine(); ++y) {
+		std::memcpy(reinterpret_cast<unsigned char *>(dst) + y * pitch * pixelSize,
+		            reinterpret_cast<unsigned char const *>(src) + y * lcd_hres * pixelSize,
+		            lcd_hres * pixelSize);
 	}
+}
+
+} // anon namespace
+
+PPUFrameLog::Frame PPU::finishFrame() {
+	worker_.wait();
+	PPUFrameLog::Frame const frame = drawnFrame_;
+	drawnFrame_ = PPUFrameLog::frame_incomplete;
+	if (frame == PPUFrameLog::frame_drawn && videoBuf_)
+		copyFrame(videoBuf_, videoPitch_, &drawBuf_[0], replay_.framebuf);
 
-	p_.lcdc = lcdc;
+	return frame;
 }
 
-void PPU::update(unsigned long const cc) {
-	long const cycles = (cc - p_.now) >> p_.lyCounter.isDoubleSpeed();
+void PPU::dropFrames() {
+	worker_.wait();
+	drawnFrame_ = PPUFrameLog::frame_incomplete;
+	log_.clear();
+}
 
-	p_.now += cycles << p_.lyCounter.isDoubleSpeed();
-	p_.cycles += cycles;
+void PPU::drawFrame(void *const ppu) {
+	PPU &p = *static_cast<PPU *>(ppu);
+	p.replay(p.drawLog_, &p.drawBuf_[0], lcd_hres);
+}
 
-	if (p_.cycles >= 0) {
-		p_.framebuf.setFbline(p_.lyCounter.ly());
+void PPU::renderLastFrame(uint_least32_t *const buf, std::ptrdiff_t const pitch) {
+	startReplay(log_);
+	replay(log_, buf, pitch);
+}
 
-		if (!(p_.speedupFlags & GB::NO_PPU_CALL))
-			p_.nextCallPtr->f(p_);
+void PPU::startReplay(PPUFrameLog const &log) {
+	// VRAM as it was when the log was started, then moved forward along with the lines.
+	std::memcpy(replayVram_, p_.vram, (1 + p_.cgb) * vram_bank_size);
+	for (std::size_t i = log.vramWrites.size(); i-- > 0;)
+		replayVram_[log.vramWrites[i].pos] = log.vramWrites[i].old;
+
+	replay_.vram = replayVram_;
+	replay_.cgb = p_.cgb;
+	replay_.trueColors = p_.trueColors;
+	replay_.framebuf.setFormat(p_.framebuf.format());
+	replay_.framebuf.setWindow(p_.framebuf.firstLine(), p_.framebuf.lastLine());
+}
+
+// Only uses what startReplay set up and the log, so that it can run on the worker thread.
+void PPU::replay(PPUFrameLog const &log, uint_least32_t *const buf, std::ptrdiff_t const pitch) {
+	PPUPriv &r = replay_;
+	r.framebuf.setBuf(buf, pitch);
+
+	std::size_t vramPos = 0;
+	std::size_t oamPos = std::size_t(-1);
+	bool lineOpen = false;
+
+	for (std::vector<PPUFrameLog::Event>::const_iterator it = log.events.begin(); it != log.events.end(); ++it) {
+		if (it->type == PPUFrameLog::event_line) {
+			PPUFrameLog::Line const &line = log.lines[it->value];
+			for (; vramPos < line.vramWrites; ++vramPos)
+				replayVram_[log.vramWrites[vramPos].pos] = log.vramWrites[vramPos].data;
+
+			static_cast<PPULineState &>(r) = line.state;
+			std::copy(&log.palettes[line.palettes], &log.palettes[line.palettes] + palettes_size / 2, r.bgPalette);
+			std::copy(&log.palettes[line.palettes] + palettes_size / 2,
+			          &log.palettes[line.palettes] + palettes_size, r.spPalette);
+			if (oamPos != line.oam) {
+				oamPos = line.oam;
+				r.spriteMapper.reset(&log.oam[oamPos], r.cgb);
+			}
+
+			r.framebuf.setFbline(r.lyCounter.ly());
+			lineOpen = r.framebuf.drawsLine();
+			if (lineOpen)
+				M3Start::startLoop(r);
+
+			continue;
+		}
+
+		if (!lineOpen)
+			continue;
+
+		runUntil(r, it->time);
+
+		switch (it->type) {
+		case PPUFrameLog::event_line_end:
+			lineOpen = false;
+			break;
+		case PPUFrameLog::event_lcdc:
+			lineOpen = (it->value & lcdc_en) != 0;
+			lcdcChange(r, it->value, it->time);
+			break;
+		case PPUFrameLog::event_scx: r.scx = it->value; break;
+		case PPUFrameLog::event_scy: r.scy = it->value; break;
+		case PPUFrameLog::event_wx: r.wx = it->value; break;
+		case PPUFrameLog::event_wy: r.wy = it->value; break;
+		case PPUFrameLog::event_wy2: r.wy2 = it->value; break;
+		case PPUFrameLog::event_palettes:
+			std::copy(&log.palettes[it->value], &log.palettes[it->value] + palettes_size / 2, r.bgPalette);
+			std::copy(&log.palettes[it->value] + palettes_size / 2,
+			          &log.palettes[it->value] + palettes_size, r.spPalette);
+			break;
+		case PPUFrameLog::event_oam:
+			oamPos = it->value;
+			r.spriteMapper.reset(&log.oam[oamPos], r.cgb);
+			break;
+		}
 	}
+
+	r.framebuf.setBuf(0, 0);
 }
@@ -22,9 +22,12 @@
 #include "lcddef.h"
 #include "ly_counter.h"
 #include "sprite_mapper.h"
+#include "gambatte.h"
 #include "gbint.h"
+#include "workerthread.h"
 
 #include <cstddef>
+#include <vector>
 
 namespace gambatte {
 
@@ -33,19 +36,69 @@ enum {
 	num_palette_entries = 4,
 	ppu_force_signed_enum = -1 };
 
+// The PPU always draws palette entries into a line of uint_least32_t. For RGB32 that is
+// the frame buffer line itself, other formats are drawn to linebuf_ and narrowed into
+// the frame buffer by flushLine once the line (or as much of it as gets drawn) is done.
 class PPUFrameBuf {
 public:
-	PPUFrameBuf() : buf_(0), fbline_(nullfbline()), pitch_(0) {}
+	PPUFrameBuf()
+	: buf_(0), fbline_(nullfbline()), pitch_(0), ly_(0), firstLine_(0), lastLine_(lcd_vres - 1)
+	, format_(GB::RGB32)
+	{
+	}
+
 	uint_least32_t * fb() const { return buf_; }
 	uint_least32_t * fbline() const { return fbline_; }
 	std::ptrdiff_t pitch() const { return pitch_; }
+	GB::VideoFormat format() const { return format_; }
+	unsigned firstLine() const { return firstLine_; }
+	unsigned lastLine() const { return lastLine_; }
+	// Whether pixels plotted now end up in the buffer, rather than in the null line.
+	bool drawsLine() const { return fbline_ != nullfbline(); }
 	void setBuf(uint_least32_t *buf, std::ptrdiff_t pitch) { buf_ = buf; pitch_ = pitch; fbline_ = nullfbline(); }
-	void setFbline(unsigned ly) { fbline_ = buf_ ? buf_ + std::ptrdiff_t(ly) * pitch_ : nullfbline(); }
+	void setFormat(GB::VideoFormat format) { format_ = format; fbline_ = nullfbline(); }
+
+	void setWindow(unsigned firstLine, unsigned lastLine) {
+		firstLine_ = firstLine;
+		lastLine_ = lastLine;
+		fbline_ = nullfbline();
+	}
+
+	void setFbline(unsigned ly) {
+		if (!buf_ || ly < firstLine_ || ly > lastLine_) {
+			fbline_ = nullfbline();
+		} else if (format_ == GB::RGB32) {
+			fbline_ = buf_ + std::ptrdiff_t(ly) * pitch_;
+		} else {
+			fbline_ = linebuf_;
+			ly_ = ly;
+		}
+	}
+
+	void flushLine(int n) const {
+		if (fbline_ != linebuf_)
+			return;
+
+		if (format_ == GB::INDEXED8) {
+			unsigned char *const dst = reinterpret_cast<unsigned char *>(buf_) + std::ptrdiff_t(ly_) * pitch_;
+			for (int i = 0; i < n; ++i)
+				dst[i] = linebuf_[i];
+		} else {
+			uint_least16_t *const dst = reinterpret_cast<uint_least16_t *>(buf_) + std::ptrdiff_t(ly_) * pitch_;
+			for (int i = 0; i < n; ++i)
+				dst[i] = linebuf_[i];
+		}
+	}
 
 private:
 	uint_least32_t *buf_;
 	uint_least32_t *fbline_;
 	std::ptrdiff_t pitch_;
+	unsigned ly_;
+	unsigned firstLine_;
+	unsigned lastLine_;
+	GB::VideoFormat format_;
+	uint_least32_t linebuf_[lcd_hres];
 
 	static uint_least32_t * nullfbline() { static uint_least32_t nullfbline_[160]; return nullfbline_; }
 };
@@ -58,27 +111,21 @@ struct PPUState {
 	unsigned char id;
 };
 
-struct PPUPriv {
-	unsigned long bgPalette[max_num_palettes * num_palette_entries];
-	unsigned long spPalette[max_num_palettes * num_palette_entries];
+// The part of the PPU state that a line is drawn from once its sprites are known,
+// which is what PPUFrameLog snapshots at the start of each line.
+struct PPULineState {
 	struct Sprite { unsigned char spx, oampos, line, attrib; } spriteList[lcd_max_num_sprites_per_line + 1];
 	unsigned short spwordList[lcd_max_num_sprites_per_line + 1];
 	unsigned char nextSprite;
 	unsigned char currentSprite;
 
-	unsigned char const *vram;
-	PPUState const *nextCallPtr;
-
-	unsigned long now;
-	unsigned long lastM0Time;
+	cc_t now;
 	long cycles;
 
 	unsigned tileword;
 	unsigned ntileword;
 
-	SpriteMapper spriteMapper;
 	LyCounter lyCounter;
-	PPUFrameBuf framebuf;
 
 	unsigned char lcdc;
 	unsigned char scy;
@@ -96,9 +143,74 @@ struct PPUPriv {
 	unsigned char xpos;
 	unsigned char endx;
 
-	bool cgb;
 	bool cgbDmg;
 	bool weMaster;
+
+	PPULineState();
+};
+
+// What is needed to draw a frame after the fact, kept while the DEFER_VIDEO or
+// THREADED_VIDEO speedup flag is set (see PPU::renderLastFrame). Each line is
+// snapshotted when its sprites are known, and anything that changes the PPU state before
+// the line is done is logged as a timestamped event. VRAM is kept as a journal of the
+// writes since the log was started, palettes and OAM as copies made on the first line
+// after they changed.
+struct PPUFrameLog {
+	enum EventType { event_line, event_line_end, event_lcdc, event_scx, event_scy,
+	                 event_wx, event_wy, event_wy2, event_palettes, event_oam };
+	enum Frame { frame_incomplete, frame_drawn, frame_lcd_off, frame_black };
+
+	struct Event {
+		cc_t time;
+		unsigned long value; // line number, register value or offset of a palette/OAM copy
+		unsigned char type;
+	};
+
+	struct Line {
+		PPULineState state;
+		std::size_t vramWrites;
+		std::size_t palettes;
+		std::size_t oam;
+	};
+
+	struct VramWrite {
+		unsigned short pos;
+		unsigned char old;
+		unsigned char data;
+	};
+
+	std::vector<Event> events;
+	std::vector<Line> lines;
+	std::vector<VramWrite> vramWrites;
+	std::vector<unsigned long> palettes;
+	std::vector<unsigned char> oam;
+	Frame frame;
+	bool lineOpen;
+	bool palettesChanged;
+	bool oamChanged;
+
+	PPUFrameLog() { clear(); }
+	void clear();
+	void swap(PPUFrameLog &log);
+	void event(cc_t time, EventType type, unsigned long value) {
+		Event const e = { time, value, static_cast<unsigned char>(type) };
+		events.push_back(e);
+	}
+};
+
+struct PPUPriv : PPULineState {
+	unsigned long bgPalette[max_num_palettes * num_palette_entries];
+	unsigned long spPalette[max_num_palettes * num_palette_entries];
+
+	unsigned char const *vram;
+	PPUState const *nextCallPtr;
+	cc_t lastM0Time;
+
+	SpriteMapper spriteMapper;
+	PPUFrameBuf framebuf;
+	PPUFrameLog *log;
+
+	bool cgb;
 	bool trueColors;
 	unsigned speedupFlags;
 
@@ -109,6 +221,10 @@ class PPU {
 public:
 	PPU(NextM0Time &nextM0Time, unsigned char const *oamram, unsigned char const *vram)
 	: p_(nextM0Time, oamram, vram)
+	, replay_(nextM0Time, oamram, vram)
+	, videoBuf_(0)
+	, videoPitch_(0)
+	, drawnFrame_(PPUFrameLog::frame_incomplete)
 	{
 	}
 
@@ -117,41 +233,103 @@ public:
 	bool cgbDmg() const { return p_.cgbDmg; }
 	bool trueColors() const { return p_.trueColors; }
 	void doLyCountEvent() { p_.lyCounter.doEvent(); }
-	unsigned long doSpriteMapEvent(unsigned long time) { return p_.spriteMapper.doEvent(time); }
+	cc_t doSpriteMapEvent(cc_t time) { return p_.spriteMapper.doEvent(time); }
 	PPUFrameBuf const & frameBuf() const { return p_.framebuf; }
 
-	bool inactivePeriodAfterDisplayEnable(unsigned long cc) const {
+	bool inactivePeriodAfterDisplayEnable(cc_t cc) const {
 		return p_.spriteMapper.inactivePeriodAfterDisplayEnable(cc);
 	}
 
-	unsigned long lastM0Time() const { return p_.lastM0Time; }
+	cc_t lastM0Time() const { return p_.lastM0Time; }
 	unsigned lcdc() const { return p_.lcdc; }
 	void loadState(SaveState const &state, unsigned char const *oamram);
 	LyCounter const & lyCounter() const { return p_.lyCounter; }
-	unsigned long now() const { return p_.now; }
-	void oamChange(unsigned long cc) { p_.spriteMapper.oamChange(cc); }
-	void oamChange(unsigned char const *oamram, unsigned long cc) { p_.spriteMapper.oamChange(oamram, cc); }
-	unsigned long predictedNextXposTime(unsigned xpos) const;
+	cc_t now() const { return p_.now; }
+	void oamChange(cc_t cc);
+	void oamChange(unsigned char const *oamram, cc_t cc);
+	cc_t predictedNextXposTime(unsigned xpos) const;
 	void reset(unsigned char const *oamram, unsigned char const *vram, bool cgb);
 	void setCgbDmg(bool enabled) { p_.cgbDmg = enabled; }
-	void resetCc(unsigned long oldCc, unsigned long newCc);
+	void resetCc(cc_t oldCc, cc_t newCc);
 	void saveState(SaveState &ss) const;
-	void setFrameBuf(uint_least32_t *buf, std::ptrdiff_t pitch) { p_.framebuf.setBuf(buf, pitch); }
-	void setLcdc(unsigned lcdc, unsigned long cc);
-	void setScx(unsigned scx) { p_.scx = scx; }
-	void setScy(unsigned scy) { p_.scy = scy; }
+	void setFrameBuf(uint_least32_t *buf, std::ptrdiff_t pitch);
+	uint_least32_t * videoBuf() const { return videoBuf_; }
+	std::ptrdiff_t videoPitch() const { return videoPitch_; }
+	void setLcdc(unsigned lcdc, cc_t cc);
+	void setScx(unsigned scx) { logEvent(PPUFrameLog::event_scx, scx); p_.scx = scx; }
+	void setScy(unsigned scy) { logEvent(PPUFrameLog::event_scy, scy); p_.scy = scy; }
 	void setStatePtrs(SaveState &ss) { p_.spriteMapper.setStatePtrs(ss); }
-	void setWx(unsigned wx) { p_.wx = wx; }
-	void setWy(unsigned wy) { p_.wy = wy; }
-	void updateWy2() { p_.wy2 = p_.wy; }
+	void setWx(unsigned wx) { logEvent(PPUFrameLog::event_wx, wx); p_.wx = wx; }
+	void setWy(unsigned wy) { logEvent(PPUFrameLog::event_wy, wy); p_.wy = wy; }
+	void updateWy2() { logEvent(PPUFrameLog::event_wy2, p_.wy); p_.wy2 = p_.wy; }
 	void speedChange();
 	unsigned long * spPalette() { return p_.spPalette; }
-	void update(unsigned long cc);
+	void update(cc_t cc);
 	void setTrueColors(bool trueColors) { p_.trueColors = trueColors; }
-	void setSpeedupFlags(unsigned flags) { p_.speedupFlags = flags; }
+	void setVideoFormat(GB::VideoFormat format);
+	void setRenderWindow(unsigned firstLine, unsigned lastLine);
+	void setSpeedupFlags(unsigned flags);
+
+	// Must be called after the palettes have been changed.
+	void paletteChange() { if (p_.log) logPaletteChange(); }
+
+	// Must be called before VRAM is written.
+	void vramWrite(unsigned char const *dst, unsigned data) {
+		if (p_.log)
+			logVramWrite(dst - p_.vram, *dst, data);
+	}
+
+	void vramWrite(unsigned char const *dst, unsigned char const *src, std::size_t n) {
+		if (p_.log) {
+			for (std::size_t i = 0; i < n; ++i)
+				logVramWrite(dst - p_.vram + i, dst[i], src[i]);
+		}
+	}
+
+	bool defersVideo() const { return p_.log; }
+	bool threadsVideo() const { return p_.speedupFlags & GB::THREADED_VIDEO; }
+
+	// With THREADED_VIDEO, frame is handed to the worker thread and the one before it is
+	// put in the video buffer. Returns the kind of the frame put there, frame_incomplete
+	// if there was none. Frames the PPU did not draw are left to the caller to clear.
+	PPUFrameLog::Frame endFrame(PPUFrameLog::Frame frame);
+
+	// Waits for the worker thread to finish the frame handed to it, if any, and puts
+	// that frame in the video buffer like endFrame.
+	PPUFrameLog::Frame finishFrame();
+
+	PPUFrameLog::Frame lastFrame() const { return log_.frame; }
+	void renderLastFrame(uint_least32_t *buf, std::ptrdiff_t pitch);
 
 private:
 	PPUPriv p_;
+	PPUPriv replay_;
+	PPUFrameLog log_;
+	uint_least32_t *videoBuf_;
+	std::ptrdiff_t videoPitch_;
+	unsigned char replayVram_[0x4000];
+	PPUFrameLog drawLog_;
+	std::vector<uint_least32_t> drawBuf_;
+	PPUFrameLog::Frame drawnFrame_;
+	WorkerThread worker_;
+
+	void logEvent(PPUFrameLog::EventType type, unsigned long value) {
+		if (p_.log && log_.lineOpen)
+			log_.event(p_.now, type, value);
+	}
+
+	void logVramWrite(std::size_t pos, unsigned old, unsigned data) {
+		PPUFrameLog::VramWrite const w = { static_cast<unsigned short>(pos),
+		                                   static_cast<unsigned char>(old),
+		                                   static_cast<unsigned char>(data) };
+		log_.vramWrites.push_back(w);
+	}
+
+	void logPaletteChange();
+	void dropFrames();
+	void startReplay(PPUFrameLog const &log);
+	void replay(PPUFrameLog const &log, uint_least32_t *buf, std::ptrdiff_t pitch);
+	static void drawFrame(void *ppu);
 };
 
 }
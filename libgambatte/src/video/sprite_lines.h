@@ -0,0 +1,169 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef SPRITE_LINES_H
+#define SPRITE_LINES_H
+
+#include "lcddef.h"
+#include <algorithm>
+
+#ifndef GAMBATTE_NO_SIMD
+#if defined __SSE2__
+#include <emmintrin.h>
+#define GAMBATTE_SPRITE_LINES_SSE2
+#endif
+#endif
+
+namespace gambatte {
+
+typedef unsigned char SpriteLine[lcd_max_num_sprites_per_line];
+
+namespace sprite_lines_detail {
+
+inline void mapSprite(int const i, unsigned char const *const posbuf, bool const *const largeSprites,
+		SpriteLine *const spritemap, unsigned char *const num, unsigned const numBase) {
+	int const spriteHeight = 8 + 8 * largeSprites[i];
+	unsigned const bottomPos = posbuf[2 * i] - 17 + spriteHeight;
+
+	if (bottomPos < lcd_vres - 1u + spriteHeight) {
+		int ly = std::max(static_cast<int>(bottomPos) + 1 - spriteHeight, 0);
+		int const end = std::min(bottomPos, lcd_vres - 1u) + 1;
+
+		do {
+			if (num[ly] < numBase + lcd_max_num_sprites_per_line)
+				spritemap[ly][num[ly]++ - numBase] = 2 * i;
+		} while (++ly != end);
+	}
+}
+
+}
+
+// Puts the first lcd_max_num_sprites_per_line sprites on each line into spritemap, as
+// their position in posbuf (2 * OAM index) and in OAM order, and sets num[ly] to numBase
+// plus how many there are. posbuf holds the Y and X position of each sprite.
+inline void mapSpriteLinesPortable(unsigned char const *const posbuf, bool const *const largeSprites,
+		SpriteLine *const spritemap, unsigned char *const num, unsigned const numBase) {
+	std::fill_n(num, 1 * lcd_vres, numBase);
+	for (int i = 0; i < lcd_num_oam_entries; ++i)
+		sprite_lines_detail::mapSprite(i, posbuf, largeSprites, spritemap, num, numBase);
+}
+
+#ifdef GAMBATTE_SPRITE_LINES_SSE2
+
+namespace sprite_lines_detail {
+
+// Below this many sprites on screen, mapping them one at a time is faster.
+enum { min_sprites_per_line_scan = 16 };
+
+inline __m128i spriteYs(unsigned char const *const posbuf, __m128i const hi) {
+	__m128i const ymask = _mm_set1_epi16(0xFF);
+	return _mm_packus_epi16(
+		_mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const *>(posbuf)), ymask),
+		_mm_and_si128(hi, ymask));
+}
+
+// largeSprites entries are bools of one byte, 0 or 1, giving height - 1 as 7 or 15.
+inline __m128i spriteLastLines(__m128i const largeSprites) {
+	return _mm_or_si128(_mm_slli_epi16(largeSprites, 3), _mm_set1_epi8(7));
+}
+
+// Index of the lowest set bit of a 32-bit mask, found with a de Bruijn sequence.
+inline int lowestBit(unsigned long const m) {
+	static unsigned char const bitpos[32] = {
+		0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+		31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9 };
+	return bitpos[((m & -m) * 0x077CB531ul & 0xFFFFFFFFul) >> 27];
+}
+
+// Number of set bits in a 32-bit mask.
+inline int bitCount(unsigned long m) {
+	m -= m >> 1 & 0x55555555;
+	m = (m & 0x33333333) + (m >> 2 & 0x33333333);
+	m = (m + (m >> 4)) & 0x0F0F0F0F;
+	return (m * 0x01010101 & 0xFFFFFFFF) >> 24;
+}
+
+inline unsigned spritesOnLine(__m128i const l, __m128i const y, __m128i const lastLine) {
+	__m128i const d = _mm_sub_epi8(l, y);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, lastLine), d));
+}
+
+// Sprites that are on some line have y - 16 + height - 1, taken modulo 256, at most
+// lcd_vres - 1 + height - 1.
+inline unsigned visibleSprites(__m128i const y, __m128i const lastLine) {
+	__m128i const d = _mm_add_epi8(_mm_sub_epi8(y, _mm_set1_epi8(16)), lastLine);
+	__m128i const end = _mm_add_epi8(lastLine, _mm_set1_epi8(lcd_vres - 1));
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, end), d));
+}
+
+}
+
+// A sprite is on line ly if ly + 16 - y, taken modulo 256, is at most its height - 1,
+// which is compared for 16 sprites at a time. The 40 sprites are padded to 48 with Y 0,
+// which is on no line.
+inline void mapSpriteLines(unsigned char const *const posbuf, bool const *const largeSprites,
+		SpriteLine *const spritemap, unsigned char *const num, unsigned const numBase) {
+	using namespace sprite_lines_detail;
+
+	__m128i const y0 = spriteYs(posbuf, _mm_loadu_si128(reinterpret_cast<__m128i const *>(posbuf + 16)));
+	__m128i const y1 = spriteYs(posbuf + 32, _mm_loadu_si128(reinterpret_cast<__m128i const *>(posbuf + 48)));
+	__m128i const y2 = spriteYs(posbuf + 64, _mm_setzero_si128());
+	__m128i const last0 = spriteLastLines(_mm_loadu_si128(reinterpret_cast<__m128i const *>(largeSprites)));
+	__m128i const last1 = spriteLastLines(_mm_loadu_si128(reinterpret_cast<__m128i const *>(largeSprites + 16)));
+	__m128i const last2 = spriteLastLines(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(largeSprites + 32)));
+
+	// sprites 0-31, and 32-39
+	unsigned long visibleLo = visibleSprites(y0, last0) | 1ul * visibleSprites(y1, last1) << 16;
+	unsigned visibleHi = visibleSprites(y2, last2);
+	if (bitCount(visibleLo) + bitCount(visibleHi) < min_sprites_per_line_scan) {
+		std::fill_n(num, 1 * lcd_vres, numBase);
+		for (; visibleLo; visibleLo &= visibleLo - 1)
+			mapSprite(lowestBit(visibleLo), posbuf, largeSprites, spritemap, num, numBase);
+		for (; visibleHi; visibleHi &= visibleHi - 1)
+			mapSprite(32 + lowestBit(visibleHi), posbuf, largeSprites, spritemap, num, numBase);
+
+		return;
+	}
+
+	for (int ly = 0; ly < lcd_vres; ++ly) {
+		__m128i const l = _mm_set1_epi8(static_cast<char>(ly + 16));
+		unsigned long lo = spritesOnLine(l, y0, last0) | 1ul * spritesOnLine(l, y1, last1) << 16;
+		int n = 0;
+		for (; lo && n < lcd_max_num_sprites_per_line; lo &= lo - 1)
+			spritemap[ly][n++] = 2 * lowestBit(lo);
+
+		unsigned hi = n < lcd_max_num_sprites_per_line ? spritesOnLine(l, y2, last2) : 0;
+		for (; hi && n < lcd_max_num_sprites_per_line; hi &= hi - 1)
+			spritemap[ly][n++] = 2 * (32 + lowestBit(hi));
+
+		num[ly] = numBase + n;
+	}
+}
+
+#else
+
+inline void mapSpriteLines(unsigned char const *posbuf, bool const *largeSprites,
+		SpriteLine *spritemap, unsigned char *num, unsigned numBase) {
+	mapSpriteLinesPortable(posbuf, largeSprites, spritemap, num, numBase);
+}
+
+#endif
+
+}
+
+#endif
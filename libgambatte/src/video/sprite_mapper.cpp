@@ -19,6 +19,7 @@
 #include "sprite_mapper.h"
 #include "counterdef.h"
 #include "next_m0_time.h"
+#include "sprite_lines.h"
 #include "../insertion_sort.h"
 
 #include <algorithm>
@@ -39,7 +40,7 @@ private:
 	unsigned char const *const spxlut_;
 };
 
-unsigned toPosCycles(unsigned long const cc, LyCounter const &lyCounter) {
+unsigned toPosCycles(cc_t const cc, LyCounter const &lyCounter) {
 	unsigned lc = lyCounter.lineCycles(cc) + 1;
 	if (lc >= lcd_cycles_per_line)
 		lc -= lcd_cycles_per_line;
@@ -70,7 +71,7 @@ void SpriteMapper::OamReader::reset(unsigned char const *const oamram, bool cons
 	}
 }
 
-void SpriteMapper::OamReader::update(unsigned long const cc) {
+void SpriteMapper::OamReader::update(cc_t const cc) {
 	if (cc > lu_) {
 		if (changed()) {
 			unsigned const lulc = toPosCycles(lu_, lyCounter_);
@@ -112,7 +113,7 @@ void SpriteMapper::OamReader::update(unsigned long const cc) {
 	}
 }
 
-void SpriteMapper::OamReader::change(unsigned long cc) {
+void SpriteMapper::OamReader::change(cc_t cc) {
 	update(cc);
 	lastChange_ = std::min(toPosCycles(lu_, lyCounter_), 2u * lcd_num_oam_entries);
 }
@@ -129,7 +130,7 @@ void SpriteMapper::OamReader::loadState(SaveState const &ss, unsigned char const
 	change(lu_);
 }
 
-void SpriteMapper::OamReader::enableDisplay(unsigned long cc) {
+void SpriteMapper::OamReader::enableDisplay(cc_t cc) {
 	std::fill_n(buf_, sizeof buf_ / sizeof *buf_, 0);
 	std::fill_n(lsbuf_, sizeof lsbuf_ / sizeof *lsbuf_, false);
 	lu_ = cc + (2 * lcd_num_oam_entries << lyCounter_.isDoubleSpeed()) + 1;
@@ -155,23 +156,7 @@ void SpriteMapper::clearMap() {
 }
 
 void SpriteMapper::mapSprites() {
-	clearMap();
-
-	for (int i = 0; i < lcd_num_oam_entries; ++i) {
-		int const spriteHeight = 8 + 8 * largeSprites(i);
-		unsigned const bottomPos = posbuf()[2 * i] - 17 + spriteHeight;
-
-		if (bottomPos < lcd_vres - 1u + spriteHeight) {
-			int ly = std::max(static_cast<int>(bottomPos) + 1 - spriteHeight, 0);
-			int const end = std::min(bottomPos, lcd_vres - 1u) + 1;
-
-			do {
-				if (num_[ly] < need_sorting_flag + lcd_max_num_sprites_per_line)
-					spritemap_[ly][num_[ly]++ - need_sorting_flag] = 2 * i;
-			} while (++ly != end);
-		}
-	}
-
+	mapSpriteLines(posbuf(), oamReader_.largeSpritesBuf(), spritemap_, num_, need_sorting_flag);
 	nextM0Time_.invalidatePredictedNextM0Time();
 }
 
@@ -181,10 +166,10 @@ void SpriteMapper::sortLine(unsigned const ly) const {
 	              SpxLess(posbuf() + 1));
 }
 
-unsigned long SpriteMapper::doEvent(unsigned long const time) {
+cc_t SpriteMapper::doEvent(cc_t const time) {
 	oamReader_.update(time);
 	mapSprites();
 	return oamReader_.changed()
 	     ? time + oamReader_.lineTime()
-	     : static_cast<unsigned long>(disabled_time);
+	     : static_cast<cc_t>(disabled_time);
 }
@@ -32,15 +32,15 @@ public:
 	             LyCounter const &lyCounter,
 	             unsigned char const *oamram);
 	void reset(unsigned char const *oamram, bool cgb);
-	unsigned long doEvent(unsigned long time);
+	cc_t doEvent(cc_t time);
 	bool largeSprites(int spno) const { return oamReader_.largeSprites(spno); }
 	int numSprites(unsigned ly) const { return num_[ly] & ~(1u * need_sorting_flag); }
-	void oamChange(unsigned long cc) { oamReader_.change(cc); }
-	void oamChange(unsigned char const *oamram, unsigned long cc) { oamReader_.change(oamram, cc); }
+	void oamChange(cc_t cc) { oamReader_.change(cc); }
+	void oamChange(unsigned char const *oamram, cc_t cc) { oamReader_.change(oamram, cc); }
 	unsigned char const * oamram() const { return oamReader_.oam(); }
 	unsigned char const * posbuf() const { return oamReader_.spritePosBuf(); }
 
-	void resetCycleCounter(unsigned long oldCc, unsigned long newCc) {
+	void resetCycleCounter(cc_t oldCc, cc_t newCc) {
 		oamReader_.update(oldCc);
 		oamReader_.resetCycleCounter(oldCc, newCc);
 	}
@@ -55,7 +55,7 @@ public:
 	}
 
 	void setStatePtrs(SaveState &state) { oamReader_.setStatePtrs(state); }
-	void enableDisplay(unsigned long cc) { oamReader_.enableDisplay(cc); }
+	void enableDisplay(cc_t cc) { oamReader_.enableDisplay(cc); }
 	void saveState(SaveState &state) const { oamReader_.saveState(state); }
 
 	void loadState(SaveState const &state, unsigned char const *oamram) {
@@ -63,11 +63,11 @@ public:
 		mapSprites();
 	}
 
-	bool inactivePeriodAfterDisplayEnable(unsigned long cc) const {
+	bool inactivePeriodAfterDisplayEnable(cc_t cc) const {
 		return oamReader_.inactivePeriodAfterDisplayEnable(cc);
 	}
 
-	static unsigned long schedule(LyCounter const &lyCounter, unsigned long cc) {
+	static cc_t schedule(LyCounter const &lyCounter, cc_t cc) {
 		return lyCounter.nextLineCycle(2 * lcd_num_oam_entries, cc);
 	}
 
@@ -76,20 +76,21 @@ private:
 	public:
 		OamReader(LyCounter const &lyCounter, unsigned char const *oamram);
 		void reset(unsigned char const *oamram, bool cgb);
-		void change(unsigned long cc);
-		void change(unsigned char const *oamram, unsigned long cc) { change(cc); oamram_ = oamram; }
+		void change(cc_t cc);
+		void change(unsigned char const *oamram, cc_t cc) { change(cc); oamram_ = oamram; }
 		bool changed() const { return lastChange_ != 0xFF; }
 		bool largeSprites(int spno) const { return lsbuf_[spno]; }
+		bool const * largeSpritesBuf() const { return lsbuf_; }
 		unsigned char const * oam() const { return oamram_; }
-		void resetCycleCounter(unsigned long oldCc, unsigned long newCc) { lu_ -= oldCc - newCc; }
+		void resetCycleCounter(cc_t oldCc, cc_t newCc) { lu_ -= oldCc - newCc; }
 		void setLargeSpritesSrc(bool src) { largeSpritesSrc_ = src; }
-		void update(unsigned long cc);
+		void update(cc_t cc);
 		unsigned char const * spritePosBuf() const { return buf_; }
 		void setStatePtrs(SaveState &state);
-		void enableDisplay(unsigned long cc);
+		void enableDisplay(cc_t cc);
 		void saveState(SaveState &state) const { state.ppu.enableDisplayM0Time = lu_; }
 		void loadState(SaveState const &ss, unsigned char const *oamram);
-		bool inactivePeriodAfterDisplayEnable(unsigned long cc) const { return cc < lu_; }
+		bool inactivePeriodAfterDisplayEnable(cc_t cc) const { return cc < lu_; }
 		unsigned lineTime() const { return lyCounter_.lineTime(); }
 
 	private:
@@ -97,7 +98,7 @@ private:
 		bool lsbuf_[lcd_num_oam_entries];
 		LyCounter const &lyCounter_;
 		unsigned char const *oamram_;
-		unsigned long lu_;
+		cc_t lu_;
 		unsigned char lastChange_;
 		bool largeSpritesSrc_;
 		bool cgb_;
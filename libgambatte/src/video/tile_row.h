@@ -0,0 +1,114 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef TILE_ROW_H
+#define TILE_ROW_H
+
+#include "gbint.h"
+
+#ifndef GAMBATTE_NO_SIMD
+#if defined __AVX2__
+#include <immintrin.h>
+#define GAMBATTE_TILE_ROW_AVX2
+#elif defined __SSSE3__
+#include <tmmintrin.h>
+#define GAMBATTE_TILE_ROW_SSSE3
+#endif
+#endif
+
+namespace gambatte {
+
+// Writes the 8 pixels of a tile row to dst. tileword holds the 2-bit color numbers
+// of the row in pixel order, pixel 0 in the low bits (as made by expand_lut).
+// Palette entries must fit in 32 bits.
+inline void writeTileRowPortable(uint_least32_t *const dst, unsigned const tileword,
+		unsigned long const *const palette) {
+	dst[0] = palette[ tileword        & 3];
+	dst[1] = palette[(tileword >>  2) & 3];
+	dst[2] = palette[(tileword >>  4) & 3];
+	dst[3] = palette[(tileword >>  6) & 3];
+	dst[4] = palette[(tileword >>  8) & 3];
+	dst[5] = palette[(tileword >> 10) & 3];
+	dst[6] = palette[(tileword >> 12) & 3];
+	dst[7] = palette[(tileword >> 14) & 3];
+}
+
+#if defined GAMBATTE_TILE_ROW_AVX2 || defined GAMBATTE_TILE_ROW_SSSE3
+
+namespace tile_row_detail {
+
+// Packs the 4 palette entries into 32-bit lanes.
+inline __m128i loadPalette(unsigned long const *const palette) {
+	if (sizeof *palette == 4)
+		return _mm_loadu_si128(reinterpret_cast<__m128i const *>(palette));
+
+	__m128 const p01 = _mm_loadu_ps(reinterpret_cast<float const *>(palette    ));
+	__m128 const p23 = _mm_loadu_ps(reinterpret_cast<float const *>(palette + 2));
+	return _mm_castps_si128(_mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+}
+
+#endif
+
+#if defined GAMBATTE_TILE_ROW_AVX2
+
+// Color numbers are shifted into one lane each and used as permute indices
+// into the palette.
+inline void writeTileRow(uint_least32_t *const dst, unsigned const tileword,
+		unsigned long const *const palette) {
+	__m256i const pal = _mm256_castsi128_si256(tile_row_detail::loadPalette(palette));
+	__m256i const idx = _mm256_and_si256(
+		_mm256_srlv_epi32(_mm256_set1_epi32(tileword), _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14)),
+		_mm256_set1_epi32(3));
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permutevar8x32_epi32(pal, idx));
+}
+
+#elif defined GAMBATTE_TILE_ROW_SSSE3
+
+// Color numbers are moved to the top of one 16-bit lane each by a multiply, turned
+// into byte offsets of palette entries and spread into pshufb controls, 4 pixels
+// at a time.
+inline void writeTileRow(uint_least32_t *const dst, unsigned const tileword,
+		unsigned long const *const palette) {
+	__m128i const pal = tile_row_detail::loadPalette(palette);
+	__m128i const c4 = _mm_and_si128(
+		_mm_srli_epi16(_mm_mullo_epi16(_mm_set1_epi16(tileword),
+			_mm_setr_epi16(1 << 14, 1 << 12, 1 << 10, 1 << 8, 1 << 6, 1 << 4, 1 << 2, 1)), 12),
+		_mm_set1_epi16(0xc));
+	__m128i const byteoffs = _mm_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+	__m128i const lo = _mm_add_epi8(byteoffs,
+		_mm_shuffle_epi8(c4, _mm_setr_epi8(0, 0, 0, 0, 2, 2, 2, 2, 4, 4, 4, 4, 6, 6, 6, 6)));
+	__m128i const hi = _mm_add_epi8(byteoffs,
+		_mm_shuffle_epi8(c4, _mm_setr_epi8(8, 8, 8, 8, 10, 10, 10, 10, 12, 12, 12, 12, 14, 14, 14, 14)));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(dst    ), _mm_shuffle_epi8(pal, lo));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4), _mm_shuffle_epi8(pal, hi));
+}
+
+#else
+
+inline void writeTileRow(uint_least32_t *const dst, unsigned const tileword,
+		unsigned long const *const palette) {
+	writeTileRowPortable(dst, tileword, palette);
+}
+
+#endif
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef VIDEO_FORMAT_H
+#define VIDEO_FORMAT_H
+
+#include "gambatte.h"
+
+namespace gambatte {
+
+// Packs an RGB32 color into the 16-bit GB::RGB565 and GB::BGR555 pixel formats, leaving
+// it as it is for GB::RGB32. Shared by the PPU palettes and the SGB recoloring.
+inline unsigned long rgb32ToVideoFormat(unsigned long const rgb32, GB::VideoFormat const format) {
+	switch (format) {
+	case GB::RGB565: return (rgb32 >> 8 & 0xF800) | (rgb32 >> 5 & 0x07E0) | (rgb32 >>  3 & 0x001F);
+	case GB::BGR555: return (rgb32 << 7 & 0x7C00) | (rgb32 >> 6 & 0x03E0) | (rgb32 >> 19 & 0x001F);
+	default: return rgb32;
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,139 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#include "vram_viewer.h"
+#include "lcddef.h"
+
+namespace gambatte {
+
+namespace {
+
+enum { attr_cgbpalno = 0x07, attr_tdbank = 0x08, attr_dmgpalno = 0x10, attr_xflip = 0x20,
+	attr_yflip = 0x40 };
+
+int const tile_len = 8;
+int const tile_size = 16;
+int const tile_map_begin = 0x1800;
+int const tile_map_len = 0x20;
+int const vram_bank_size = 0x2000;
+
+// Draws one line of the tile at tileData with the given flips.
+void drawTileLine(uint_least32_t *dest, unsigned char const *tileData, int line,
+		uint_least32_t const *palette, unsigned attrib, bool transparent) {
+	if (attrib & attr_yflip)
+		line = tile_len - 1 - line;
+
+	unsigned const lo = tileData[2 * line], hi = tileData[2 * line + 1];
+	for (int x = 0; x < tile_len; ++x) {
+		int const bit = attrib & attr_xflip ? x : tile_len - 1 - x;
+		unsigned const color = (lo >> bit & 1) | (hi >> bit & 1) << 1;
+		if (color || !transparent)
+			dest[x] = palette[color];
+	}
+}
+
+void invert(uint_least32_t &pixel) { pixel ^= 0xFFFFFF; }
+
+// Inverts the border of a w x h rectangle at x, y on a 256x256 map, wrapping around.
+void outlineRect(uint_least32_t *dest, std::ptrdiff_t pitch, unsigned x, unsigned y, unsigned w, unsigned h) {
+	for (unsigned i = 0; i < w; ++i) {
+		invert(dest[std::ptrdiff_t(y & 0xFF) * pitch + ((x + i) & 0xFF)]);
+		invert(dest[std::ptrdiff_t((y + h - 1) & 0xFF) * pitch + ((x + i) & 0xFF)]);
+	}
+
+	for (unsigned i = 1; i + 1 < h; ++i) {
+		invert(dest[std::ptrdiff_t((y + i) & 0xFF) * pitch + (x & 0xFF)]);
+		invert(dest[std::ptrdiff_t((y + i) & 0xFF) * pitch + ((x + w - 1) & 0xFF)]);
+	}
+}
+
+}
+
+void drawTileSheet(GB::VideoSnapshot const &s, uint_least32_t *const dest, std::ptrdiff_t const pitch,
+		unsigned const bank, unsigned const palette) {
+	uint_least32_t const *const pal = palette < 8
+		? s.bgPalette + palette * 4
+		: s.spPalette + (palette & 7) * 4;
+
+	for (int tile = 0; tile < 384; ++tile) {
+		unsigned char const *const tileData = s.vram + (bank & 1) * vram_bank_size + tile * tile_size;
+		uint_least32_t *const d = dest + std::ptrdiff_t(tile / 16 * tile_len) * pitch + tile % 16 * tile_len;
+		for (int line = 0; line < tile_len; ++line)
+			drawTileLine(d + line * pitch, tileData, line, pal, 0, false);
+	}
+}
+
+void drawTileMap(GB::VideoSnapshot const &s, uint_least32_t *const dest, std::ptrdiff_t const pitch,
+		unsigned const map, bool const outline) {
+	unsigned char const *const tileMap = s.vram + tile_map_begin + (map & 1) * tile_map_len * tile_map_len;
+
+	for (int pos = 0; pos < tile_map_len * tile_map_len; ++pos) {
+		unsigned const tileNo = tileMap[pos];
+		unsigned const attrib = s.cgb ? tileMap[pos + vram_bank_size] : 0;
+		unsigned const tileIndex = s.lcdc & lcdc_tdsel ? tileNo : 0x100 + (tileNo ^ 0x80) - 0x80;
+		unsigned char const *const tileData = s.vram
+			+ (attrib & attr_tdbank ? vram_bank_size : 0) + tileIndex * tile_size;
+		uint_least32_t const *const pal = s.bgPalette + (attrib & attr_cgbpalno) * 4;
+		uint_least32_t *const d = dest + std::ptrdiff_t(pos / tile_map_len * tile_len) * pitch
+			+ pos % tile_map_len * tile_len;
+
+		for (int line = 0; line < tile_len; ++line)
+			drawTileLine(d + line * pitch, tileData, line, pal, attrib, false);
+	}
+
+	if (!outline)
+		return;
+
+	if (map == (s.lcdc & lcdc_bgtmsel ? 1u : 0u))
+		outlineRect(dest, pitch, s.scx, s.scy, lcd_hres, lcd_vres);
+
+	if ((s.lcdc & lcdc_we) && map == (s.lcdc & lcdc_wtmsel ? 1u : 0u)
+			&& s.wx < lcd_hres + 7 && s.wy < lcd_vres) {
+		// the window starts at screen x wx - 7, showing its first columns off screen if wx < 7
+		if (s.wx < 7)
+			outlineRect(dest, pitch, 7 - s.wx, 0, lcd_hres, lcd_vres - s.wy);
+		else
+			outlineRect(dest, pitch, 0, 0, lcd_hres + 7 - s.wx, lcd_vres - s.wy);
+	}
+}
+
+void drawSprites(GB::VideoSnapshot const &s, uint_least32_t *const dest, std::ptrdiff_t const pitch) {
+	bool const large = s.lcdc & lcdc_obj2x;
+
+	for (int i = 0; i < lcd_num_oam_entries; ++i) {
+		unsigned char const *const oam = s.oam + 4 * i;
+		unsigned const attrib = oam[3];
+		unsigned const tileNo = large ? oam[2] & ~1u : oam[2];
+		unsigned char const *const tileData = s.vram
+			+ (s.cgb && (attrib & attr_tdbank) ? vram_bank_size : 0) + tileNo * tile_size;
+		uint_least32_t const *const pal = s.cgb
+			? s.spPalette + (attrib & attr_cgbpalno) * 4
+			: s.spPalette + (attrib & attr_dmgpalno ? 4 : 0);
+		uint_least32_t *const d = dest + std::ptrdiff_t(i / 8 * 2 * tile_len) * pitch + i % 8 * tile_len;
+		int const height = large ? 2 * tile_len : tile_len;
+
+		for (int line = 0; line < height; ++line) {
+			// with y flip, the line order of both tiles of a large sprite is reversed
+			int const srcLine = attrib & attr_yflip ? height - 1 - line : line;
+			drawTileLine(d + line * pitch, tileData + srcLine / tile_len * tile_size,
+			             srcLine % tile_len, pal, attrib & attr_xflip, true);
+		}
+	}
+}
+
+}
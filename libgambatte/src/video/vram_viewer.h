@@ -0,0 +1,35 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef VRAM_VIEWER_H
+#define VRAM_VIEWER_H
+
+#include "gambatte.h"
+
+namespace gambatte {
+
+// Debug views of a GB::VideoSnapshot. These only read the snapshot.
+void drawTileSheet(GB::VideoSnapshot const &s, uint_least32_t *dest, std::ptrdiff_t pitch,
+                   unsigned bank, unsigned palette);
+void drawTileMap(GB::VideoSnapshot const &s, uint_least32_t *dest, std::ptrdiff_t pitch,
+                 unsigned map, bool outline);
+void drawSprites(GB::VideoSnapshot const &s, uint_least32_t *dest, std::ptrdiff_t pitch);
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#include "workerthread.h"
+
+namespace gambatte {
+
+#ifdef GAMBATTE_THREADS
+
+WorkerThread::WorkerThread()
+: job_(0)
+, arg_(0)
+, running_(false)
+, quit_(false)
+{
+	pthread_mutex_init(&mutex_, 0);
+	pthread_cond_init(&cond_, 0);
+}
+
+WorkerThread::~WorkerThread() {
+	pthread_mutex_lock(&mutex_);
+	bool const started = running_ || job_;
+	quit_ = true;
+	pthread_cond_broadcast(&cond_);
+	pthread_mutex_unlock(&mutex_);
+
+	if (started)
+		pthread_join(thread_, 0);
+
+	pthread_cond_destroy(&cond_);
+	pthread_mutex_destroy(&mutex_);
+}
+
+void WorkerThread::start(Job const job, void *const arg) {
+	pthread_mutex_lock(&mutex_);
+	while (running_)
+		pthread_cond_wait(&cond_, &mutex_);
+
+	if (!job_ && pthread_create(&thread_, 0, run, this) != 0) {
+		// no thread to be had, do it here.
+		pthread_mutex_unlock(&mutex_);
+		return job(arg);
+	}
+
+	job_ = job;
+	arg_ = arg;
+	running_ = true;
+	pthread_cond_broadcast(&cond_);
+	pthread_mutex_unlock(&mutex_);
+}
+
+void WorkerThread::wait() {
+	pthread_mutex_lock(&mutex_);
+	while (running_)
+		pthread_cond_wait(&cond_, &mutex_);
+
+	pthread_mutex_unlock(&mutex_);
+}
+
+void * WorkerThread::run(void *const self) {
+	static_cast<WorkerThread *>(self)->loop();
+	return 0;
+}
+
+void WorkerThread::loop() {
+	pthread_mutex_lock(&mutex_);
+	for (;;) {
+		while (!running_ && !quit_)
+			pthread_cond_wait(&cond_, &mutex_);
+
+		if (!running_)
+			break;
+
+		pthread_mutex_unlock(&mutex_);
+		job_(arg_);
+		pthread_mutex_lock(&mutex_);
+		running_ = false;
+		pthread_cond_broadcast(&cond_);
+	}
+
+	pthread_mutex_unlock(&mutex_);
+}
+
+#else
+
+WorkerThread::WorkerThread() {}
+WorkerThread::~WorkerThread() {}
+void WorkerThread::start(Job const job, void *const arg) { job(arg); }
+void WorkerThread::wait() {}
+
+#endif
+
+}
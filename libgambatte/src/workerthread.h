@@ -0,0 +1,62 @@
+//
+//   Copyright (C) 2026 by the Gambatte-Speedrun contributors
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License version 2 for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   version 2 along with this program; if not, write to the
+//   Free Software Foundation, Inc.,
+//   51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef WORKERTHREAD_H
+#define WORKERTHREAD_H
+
+#include "uncopyable.h"
+
+#ifdef GAMBATTE_THREADS
+#include <pthread.h>
+#endif
+
+namespace gambatte {
+
+// Runs one job at a time on a thread of its own, which is started with the first job.
+// Without GAMBATTE_THREADS, jobs are run right away on the calling thread instead.
+class WorkerThread : Uncopyable {
+public:
+	typedef void (*Job)(void *arg);
+
+	WorkerThread();
+	~WorkerThread();
+
+	// Waits for the job that is running, if any, before starting this one.
+	void start(Job job, void *arg);
+
+	// Returns once no job is running.
+	void wait();
+
+private:
+#ifdef GAMBATTE_THREADS
+	pthread_t thread_;
+	pthread_mutex_t mutex_;
+	pthread_cond_t cond_;
+	Job job_;
+	void *arg_;
+	bool running_;
+	bool quit_;
+
+	static void * run(void *self);
+	void loop();
+#endif
+};
+
+}
+
+#endif
@@ -0,0 +1,155 @@
+// Times the sound path alone: a PSG with all four channels playing, run a frame at a time
+// with its output turned into samples by PSG::fillBuffer as in GB::runFor. Also times the
+// prefix sum kernel fillBuffer uses (prefixSum, see libgambatte/src/sound/prefix_sum.h)
+// against the portable version, and checks that they agree, on the deltas of those frames
+// and on random ones of every length up to 64.
+// Build with e.g. CXXFLAGS="-O2 -DGAMBATTE_NO_SIMD" to time without SSE2.
+//
+// usage: audiobench [frames]
+
+#include "sound.h"
+#include "sound/prefix_sum.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+enum { cycles_per_frame = 70224, samples_per_frame = cycles_per_frame / 2 };
+enum { buf_len = samples_per_frame + 2064 };
+
+void startChannels(PSG &psg) {
+	psg.reset(false);
+	psg.setEnabled(true);
+	psg.setSoVolume(0x77);
+	psg.mapSo(0xDE);
+	psg.setNr11(0x80);
+	psg.setNr12(0xF3);
+	psg.setNr13(0x00);
+	psg.setNr14(0x86, false);
+	psg.setNr21(0x40);
+	psg.setNr22(0xA0);
+	psg.setNr23(0x40);
+	psg.setNr24(0x87, false);
+	for (unsigned i = 0; i < 0x10; ++i)
+		psg.waveRamWrite(i, i * 0x11 ^ 0x0F);
+
+	psg.setNr30(0x80);
+	psg.setNr32(0x20);
+	psg.setNr33(0x80);
+	psg.setNr34(0x85);
+	psg.setNr42(0xF1);
+	psg.setNr43(0x34);
+	psg.setNr44(0x80);
+}
+
+// Runs a frame, changing pitches four times in it like a music driver would.
+std::size_t runFrame(PSG &psg, uint_least32_t *buf, long const frame) {
+	psg.setBuffer(buf);
+	for (int q = 0; q < 4; ++q) {
+		psg.generateSamples((q + 1) * cycles_per_frame / 4, false);
+		psg.setNr13((frame * 4 + q) * 37 & 0xFF);
+		psg.setNr23((frame * 4 + q) * 53 & 0xFF);
+		psg.setNr33((frame * 4 + q) * 29 & 0xFF);
+	}
+
+	psg.resetCounter(0, cycles_per_frame, false);
+	return psg.fillBuffer();
+}
+
+template<uint_least32_t (*sum)(uint_least32_t *, std::size_t, uint_least32_t)>
+double nsPerSample(std::vector<uint_least32_t> const &deltas, long const n, uint_least32_t &out) {
+	std::vector<uint_least32_t> buf(deltas.size());
+	uint_least32_t s = 0x8000;
+	double total = 0;
+	for (long i = 0; i < n; ++i) {
+		buf = deltas;
+		std::clock_t const start = std::clock();
+		s = sum(&buf[0], buf.size(), s);
+		total += std::clock() - start;
+	}
+
+	out = s ^ buf.back();
+	return total * 1.0e9 / CLOCKS_PER_SEC / n / deltas.size();
+}
+
+bool kernelsAgree(std::vector<uint_least32_t> const &deltas) {
+	std::vector<uint_least32_t> a(deltas), b(deltas);
+	if (prefixSumPortable(&a[0], a.size(), 0x8000) != prefixSum(&b[0], b.size(), 0x8000)
+			|| a != b) {
+		std::printf("prefixSum mismatch on frame deltas\n");
+		return false;
+	}
+
+	for (std::size_t n = 0; n <= 64; ++n) {
+		uint_least32_t r[64], p[64];
+		for (std::size_t i = 0; i < n; ++i)
+			r[i] = p[i] = (std::rand() & 0xFFFF) << 16 ^ std::rand();
+
+		uint_least32_t const s = std::rand();
+		if (prefixSumPortable(r, n, s) != prefixSum(p, n, s) || std::memcmp(r, p, sizeof *r * n)) {
+			std::printf("prefixSum mismatch on %d random deltas\n", static_cast<int>(n));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	long const frames = argc > 1 ? std::atol(argv[1]) : 6000;
+	if (frames <= 0) {
+		std::printf("usage: %s [frames]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::vector<uint_least32_t> buf(buf_len);
+	std::vector<uint_least32_t> deltas;
+	PSG psg;
+	psg.init(false);
+	startChannels(psg);
+
+	// keep the deltas of one frame for the kernels, by running it without fillBuffer
+	psg.setBuffer(&buf[0]);
+	psg.generateSamples(cycles_per_frame, false);
+	deltas.assign(buf.begin(), buf.begin() + samples_per_frame);
+	psg.setBuffer(&buf[0]);
+	psg.resetCounter(0, cycles_per_frame, false);
+
+	std::srand(1);
+	if (!kernelsAgree(deltas))
+		return EXIT_FAILURE;
+
+	uint_least32_t sink = 0;
+	std::clock_t const start = std::clock();
+	for (long f = 0; f < frames; ++f) {
+		std::size_t const n = runFrame(psg, &buf[0], f);
+		sink += buf[n - 1];
+	}
+
+	double const seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+	uint_least32_t portableOut = 0, selectedOut = 0;
+	double const portable = nsPerSample<prefixSumPortable>(deltas, frames, portableOut);
+	double const selected = nsPerSample<prefixSum>(deltas, frames, selectedOut);
+	std::printf("psg: %.0f frames/s, %.2f ns/sample\n",
+	            frames / seconds, seconds * 1.0e9 / frames / samples_per_frame);
+	std::printf("%s: portable prefix sum %.3f ns/sample, prefixSum %.3f ns/sample\n",
+#if defined GAMBATTE_PREFIX_SUM_SSE2
+	            "sse2",
+#else
+	            "no simd",
+#endif
+	            portable, selected);
+
+	// keep the work from being optimized out
+	uint_least32_t volatile const result = sink + portableOut + selectedOut;
+	(void)result;
+
+	return portableOut == selectedOut ? EXIT_SUCCESS : EXIT_FAILURE;
+}
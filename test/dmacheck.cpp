@@ -0,0 +1,160 @@
+// Checks the HDMA/GDMA transfers that Memory::dma copies in bulk when nothing can see
+// the single bytes (see Memory::bulkDmaCopy) against what copying byte by byte gives.
+// A ROM does general purpose transfers with the LCD off from ROM, from WRAM across the
+// switchable bank, from echo RAM, into both VRAM banks and wrapping around the end of
+// VRAM, and from VRAM, which is never copied in bulk, then HBlank transfers with the LCD
+// on. It times the general purpose transfers with TIMA, restarted along with DIV just
+// before each.
+// The VRAM must then hold the source bytes, and the times must be those of the byte by
+// byte copy, recorded with the bulk copy taken out of Memory::dma.
+//
+// usage: dmacheck
+
+#include "gambatte.h"
+#include "testrom.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "dmacheck.gbc";
+std::size_t const samples_per_frame = 35112;
+
+struct Transfer {
+	unsigned src;
+	unsigned dest;
+	unsigned vramBank;
+	unsigned blocks;
+	unsigned time; // TIMA at 262144 Hz once done, 0 for HBlank transfers
+};
+
+Transfer const transfers[] = {
+	{ 0x4000, 0x8000, 0, 0x70, 227 },
+	{ 0x4800, 0x9F80, 0, 0x10,  35 },
+	{ 0x5000, 0x8400, 0, 0x01,   5 },
+	{ 0x5800, 0x8C00, 0, 0x40, 131 },
+	{ 0xCFF0, 0x8000, 1, 0x04,  11 },
+	{ 0xC400, 0x8800, 1, 0x08,  19 },
+	{ 0xE100, 0x9200, 1, 0x02,   7 },
+	{ 0x8000, 0x9000, 1, 0x02,   7 },
+	{ 0x6000, 0x9400, 0, 0x08,   0 },
+};
+
+std::size_t const num_transfers = sizeof transfers / sizeof *transfers;
+std::size_t const num_gdma = num_transfers - 1;
+
+unsigned romByte(unsigned const p) { return (p * 7 + (p >> 8)) & 0xFF; }
+unsigned wram0Byte(unsigned const p) { return (p * 13 + 5) & 0xFF; }
+unsigned wram2Byte(unsigned const p) { return ((p * 29 + 3) ^ 0x5A) & 0xFF; }
+
+unsigned sourceByte(unsigned const p) {
+	if (p < 0x8000)
+		return romByte(p);
+	if (p < 0xC000)
+		return 0xFF;
+	if (p < 0xD000)
+		return wram0Byte(p);
+	if (p < 0xE000)
+		return wram2Byte(p);
+
+	return wram0Byte(p - 0x2000);
+}
+
+TestRom makeRom() {
+	TestRom rom;
+	for (unsigned p = 0x4000; p < TestRom::size; ++p)
+		rom[p] = romByte(p);
+
+	rom.writeIo(0x40, 0x00); // LCD off
+	rom.writeIo(0x07, 0x05); // TIMA at 262144 Hz
+	for (std::size_t i = 0; i < num_transfers; ++i) {
+		Transfer const &t = transfers[i];
+		rom.writeIo(0x4F, t.vramBank);
+		rom.writeIo(0x51, t.src >> 8).writeIo(0x52, t.src);
+		rom.writeIo(0x53, t.dest >> 8).writeIo(0x54, t.dest);
+		if (i < num_gdma) {
+			rom.op(0xAF).op(0xE0, 0x04).op(0xE0, 0x05); // xor a; ldh ($04),a; ldh ($05),a
+			rom.writeIo(0x55, t.blocks - 1);
+			rom.copyIo(0x80 + i, 0x05);
+		} else {
+			rom.writeIo(0x40, 0x91); // LCD on
+			rom.writeIo(0x55, 0x80 | (t.blocks - 1));
+			rom.waitIo(0x55, 0xFF);
+			rom.writeIo(0x40, 0x00);
+		}
+	}
+
+	rom.finish(0xA5);
+	return rom;
+}
+
+} // anon namespace
+
+int main() {
+	if (!makeRom().save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	GB gb;
+	LoadRes const loadres = gb.load(rom_file, GB::CGB_MODE);
+	std::remove(rom_file);
+	if (loadres != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned p = 0xC000; p < 0xD000; ++p)
+		gb.externalWrite(p, wram0Byte(p));
+
+	gb.externalWrite(0xFF70, 2);
+	for (unsigned p = 0xD000; p < 0xE000; ++p)
+		gb.externalWrite(p, wram2Byte(p));
+
+	std::vector<uint_least32_t> audio(samples_per_frame + 2064);
+	for (int frame = 0; frame < 10; ++frame) {
+		std::size_t samples = samples_per_frame;
+		gb.runFor(0, 160, &audio[0], samples);
+	}
+
+	if (gb.externalRead(0xFFFE) != 0xA5) {
+		std::printf("the transfers did not finish\n");
+		return EXIT_FAILURE;
+	}
+
+	int failures = 0;
+	std::vector<int> expected(2 * 0x2000, -1);
+	for (std::size_t i = 0; i < num_transfers; ++i) {
+		Transfer const &t = transfers[i];
+		for (unsigned n = 0; n < t.blocks * 0x10; ++n)
+			expected[t.vramBank * 0x2000 + (t.dest + n) % 0x2000] = sourceByte(t.src + n);
+
+		unsigned const time = gb.externalRead(0xFF80 + i);
+		if (i < num_gdma && time != t.time) {
+			std::printf("transfer %d took %u TIMA ticks, not %u\n",
+			            static_cast<int>(i), time, t.time);
+			++failures;
+		}
+	}
+
+	for (unsigned bank = 0; bank < 2; ++bank) {
+		gb.externalWrite(0xFF4F, bank);
+		for (unsigned p = 0; p < 0x2000; ++p) {
+			int const e = expected[bank * 0x2000 + p];
+			unsigned const v = gb.externalRead(0x8000 + p);
+			if (e >= 0 && v != static_cast<unsigned>(e)) {
+				std::printf("VRAM bank %u %04x is %02x, not %02x\n", bank, 0x8000 + p, v, e);
+				++failures;
+			}
+		}
+	}
+
+	if (failures)
+		return EXIT_FAILURE;
+
+	std::printf("dma: %d transfers agree\n", static_cast<int>(num_transfers));
+	return EXIT_SUCCESS;
+}
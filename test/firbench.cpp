@@ -0,0 +1,108 @@
+// Times the multiply-accumulate of the polyphase FIR resamplers (firDotStereo, see
+// common/resample/src/firdot.h) against the portable version, on Kaiser windowed sinc
+// kernels of a few lengths as used by the Kaiser70Sinc resampler, and checks that they
+// agree on every phase of those and on random taps of every length up to 64.
+// Build with e.g. CXXFLAGS="-O2 -mavx2" to time the AVX2 version, or with
+// -DGAMBATTE_NO_SIMD to time without SIMD.
+//
+// usage: firbench [outputs]
+
+#include "firdot.h"
+#include "kaiser70sinc.h"
+#include "makesinckernel.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace {
+
+enum { phases = 32, frames = 0x1000 };
+
+typedef void (*FirDot)(long &accl, long &accr, short const *k, short const *s, std::size_t n);
+
+short randomSample() {
+	return static_cast<short>((std::rand() & 0xFFFF) - 0x8000);
+}
+
+template<FirDot dot>
+double nsPerOutput(std::vector<short> const &kernel, std::size_t const phaseLen,
+		std::vector<short> const &in, long const n, long &sink) {
+	std::clock_t const start = std::clock();
+	for (long i = 0; i < n; ++i) {
+		long accl = 0, accr = 0;
+		std::size_t const ph = i % phases;
+		std::size_t const frame = i / phases % (frames - phaseLen);
+		dot(accl, accr, &kernel[ph * phaseLen], &in[frame * 2], phaseLen);
+		sink += accl ^ accr;
+	}
+
+	return (std::clock() - start) * 1.0e9 / CLOCKS_PER_SEC / n;
+}
+
+bool agree(short const *k, short const *s, std::size_t n) {
+	long rl = 0, rr = 0, l = 0, r = 0;
+	firDotStereoPortable(rl, rr, k, s, n);
+	firDotStereo(l, r, k, s, n);
+	return l == rl && r == rr;
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	long const n = argc > 1 ? std::atol(argv[1]) : 2000000;
+	if (n <= 0) {
+		std::printf("usage: %s [outputs]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::srand(1);
+	std::vector<short> in(frames * 2);
+	for (std::size_t i = 0; i < in.size(); ++i)
+		in[i] = randomSample();
+
+	// the taps are kept to an absolute sum of 0x10000, like the kernels makeSincKernel makes
+	for (std::size_t len = 0; len <= 64; ++len) {
+		short k[64];
+		for (std::size_t i = 0; i < len; ++i)
+			k[i] = randomSample() / static_cast<short>(len / 2 + 1);
+
+		if (!agree(k, &in[len], len)) {
+			std::printf("firDotStereo mismatch on %d random taps\n", static_cast<int>(len));
+			return EXIT_FAILURE;
+		}
+	}
+
+	unsigned const phaseLens[] = { 12, 35, 64, 151 };
+	long sink = 0;
+	for (std::size_t i = 0; i < sizeof phaseLens / sizeof *phaseLens; ++i) {
+		std::size_t const phaseLen = phaseLens[i];
+		std::vector<short> kernel(phaseLen * phases);
+		makeSincKernel(&kernel[0], phases, phaseLen, 0.9, kaiser70SincWin, 1.0);
+		for (std::size_t ph = 0; ph < phases; ++ph) {
+			if (!agree(&kernel[ph * phaseLen], &in[ph * 2], phaseLen)) {
+				std::printf("firDotStereo mismatch on phase %d of %d taps\n",
+				            static_cast<int>(ph), static_cast<int>(phaseLen));
+				return EXIT_FAILURE;
+			}
+		}
+
+		double const portable = nsPerOutput<firDotStereoPortable>(kernel, phaseLen, in, n, sink);
+		double const selected = nsPerOutput<firDotStereo>(kernel, phaseLen, in, n, sink);
+		std::printf("%s, %3d taps: portable %.2f ns/output, firDotStereo %.2f ns/output\n",
+#if defined FIR_DOT_AVX2
+		            "avx2",
+#elif defined FIR_DOT_SSE2
+		            "sse2",
+#else
+		            "no simd",
+#endif
+		            static_cast<int>(phaseLen), portable, selected);
+	}
+
+	// keep the work from being optimized out
+	long volatile const result = sink;
+	(void)result;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// Times whole frames of emulation with the background on, for the PPU drawing lines in
+// one go when nothing can change within them (see M3Loop::renderLine in
+// libgambatte/src/video/ppu.cpp). A ROM fills VRAM, turns the LCD on and then either
+// halts until each VBlank, so that lines are drawn whole, with and without 40 sprites
+// in OAM, or writes LY to SCX in a loop, so that every line is split by writes and
+// drawn a few pixels at a time. Run it against a library built without renderLine to
+// compare. With --threaded, frames are drawn with the THREADED_VIDEO speedup flag, on a
+// worker thread if the library was built with threads=1.
+//
+// usage: framebench [--threaded] [frames]
+
+#include "gambatte.h"
+#include "testrom.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/time.h>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "framebench.gbc";
+std::size_t const samples_per_frame = 35112;
+
+struct Workload {
+	char const *name;
+	bool sprites;
+	bool scxWrites;
+};
+
+Workload const workloads[] = {
+	{ "halted, bg",          false, false },
+	{ "halted, bg, sprites", true,  false },
+	{ "scx writes, bg",      false, true  },
+};
+
+TestRom makeRom(Workload const &w) {
+	TestRom rom;
+	rom.writeIo(0x40, 0x00); // LCD off
+	// tile data and the first tile map: ld hl,$8000; ld a,l; xor h; ld (hl+),a;
+	// ld a,h; cp $9C; jr nz,<ld a,l>
+	rom.op(0x21, 0x00, 0x80).op(0x7D).op(0xAC).op(0x22).op(0x7C).op(0xFE, 0x9C).op(0x20, 0xF8);
+	// BG palettes: ld a,$80; ldh ($68),a; ld b,64; ld a,b; rlca; xor b; ldh ($69),a;
+	// dec b; jr nz,<ld a,b>
+	rom.writeIo(0x68, 0x80).op(0x06, 64).op(0x78).op(0x07).op(0xA8).op(0xE0, 0x69).op(0x05).op(0x20, 0xF8);
+	rom.writeIo(0x47, 0xE4);
+	if (w.sprites) {
+		// sprite b at y 16 + 3b, so 10 to a line, and x 8 + 4b: ld hl,$FE00; ld b,0;
+		// ld a,b; add a,a; add a,b; add a,16; ld (hl+),a; ld a,b; add a,a; add a,a;
+		// add a,8; ld (hl+),a; ld a,b; ld (hl+),a; and 7; ld (hl+),a; inc b; ld a,b;
+		// cp 40; jr nz,<ld a,b>
+		rom.op(0x21, 0x00, 0xFE).op(0x06, 0x00);
+		rom.op(0x78).op(0x87).op(0x80).op(0xC6, 16).op(0x22);
+		rom.op(0x78).op(0x87).op(0x87).op(0xC6, 8).op(0x22);
+		rom.op(0x78).op(0x22).op(0xE6, 7).op(0x22);
+		rom.op(0x04).op(0x78).op(0xFE, 40).op(0x20, 0xE9);
+
+		rom.writeIo(0x6A, 0x80).op(0x06, 64).op(0x78).op(0x2F).op(0xE0, 0x6B).op(0x05).op(0x20, 0xF9);
+	}
+
+	rom.writeIo(0x40, w.sprites ? 0x93 : 0x91);
+	if (w.scxWrites) {
+		rom.op(0xF0, 0x44).op(0xE0, 0x43).op(0x18, 0xFA); // ldh a,($44); ldh ($43),a; jr
+	} else {
+		rom.writeIo(0xFF, 0x01); // VBlank only, taken without IME
+		// xor a; ldh ($0F),a; halt; nop; jr <xor a>
+		rom.op(0xAF).op(0xE0, 0x0F).op(0x76).op(0x00).op(0x18, 0xF9);
+	}
+
+	return rom;
+}
+
+// wall time rather than std::clock, which adds up the time of a worker thread too
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1.0e6;
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	bool const threaded = argc > 1 && std::strcmp(argv[1], "--threaded") == 0;
+	long const frames = argc > 1 + threaded ? std::atol(argv[1 + threaded]) : 3000;
+	if (frames <= 0) {
+		std::printf("usage: %s [--threaded] [frames]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::vector<uint_least32_t> video(160 * 144);
+	std::vector<uint_least32_t> audio(samples_per_frame + 2064);
+	uint_least32_t sink = 0;
+	for (std::size_t i = 0; i < sizeof workloads / sizeof *workloads; ++i) {
+		if (!makeRom(workloads[i]).save(rom_file)) {
+			std::printf("failed to write %s\n", rom_file);
+			return EXIT_FAILURE;
+		}
+
+		GB gb;
+		LoadRes const loadres = gb.load(rom_file, GB::CGB_MODE);
+		std::remove(rom_file);
+		if (loadres != LOADRES_OK) {
+			std::printf("failed to load %s\n", rom_file);
+			return EXIT_FAILURE;
+		}
+
+		if (threaded)
+			gb.setSpeedupFlags(GB::THREADED_VIDEO);
+
+		// get past filling VRAM with the LCD off
+		for (int f = 0; f < 10; ++f) {
+			std::size_t samples = samples_per_frame;
+			gb.runFor(&video[0], 160, &audio[0], samples);
+		}
+
+		double const start = seconds();
+		for (long f = 0; f < frames;) {
+			std::size_t samples = samples_per_frame;
+			f += gb.runFor(&video[0], 160, &audio[0], samples) >= 0;
+		}
+
+		std::printf("%s: %.0f frames/s\n", workloads[i].name, frames / (seconds() - start));
+		for (std::size_t p = 0; p < video.size(); p += 97)
+			sink += video[p];
+	}
+
+	// keep the frames from being optimized out
+	uint_least32_t volatile const result = sink;
+	(void)result;
+
+	return EXIT_SUCCESS;
+}
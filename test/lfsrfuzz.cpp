@@ -0,0 +1,156 @@
+// Checks the block stepping of the channel 4 LFSR (see libgambatte/src/sound/lfsr_table.h)
+// against single shifts. First the table functions themselves, for every register value,
+// then the channel: two PSGs get the same random noise register writes at random times, one
+// generating samples a sound cycle at a time, which leaves it a single shift per block, the
+// other a whole stretch between writes at a time. Their samples must be the same.
+//
+// usage: lfsrfuzz [frames]
+
+#include "sound.h"
+#include "sound/lfsr_table.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+enum { cycles_per_frame = 70224, samples_per_frame = cycles_per_frame / 2 };
+enum { buf_len = samples_per_frame + 2064 };
+
+unsigned shiftsByOne(unsigned reg, bool const sevenBit, unsigned long n) {
+	for (; n; --n)
+		reg = lfsr_table::shift(reg, sevenBit);
+
+	return reg;
+}
+
+bool tablesAgree() {
+	for (unsigned reg = 0; reg < 0x10000; ++reg) {
+		for (unsigned n = 0; n <= lfsr_table::max_shifts15; ++n) {
+			for (int sevenBit = 0; sevenBit < 2; ++sevenBit) {
+				if (reg > 0x7FFF || (sevenBit && n > lfsr_table::max_shifts7))
+					continue;
+
+				unsigned changes = 0;
+				for (unsigned i = 0, r = reg; i < n; ++i) {
+					unsigned const next = lfsr_table::shift(r, sevenBit);
+					changes |= ((r ^ next) & 1) << i;
+					r = next;
+				}
+
+				unsigned lowest = 0;
+				while (changes && !(changes >> lowest & 1))
+					++lowest;
+
+				if (lfsr_table::shifts(reg, sevenBit, n) != shiftsByOne(reg, sevenBit, n)
+						|| lfsr_table::changes(reg, n) != changes
+						|| (changes && lfsr_table::lowestChange(changes) != lowest)) {
+					std::printf("shifts mismatch: reg %04x, %u shifts, %s\n",
+					            reg, n, sevenBit ? "7-bit" : "15-bit");
+					return false;
+				}
+			}
+		}
+
+		unsigned long const n = std::rand() % 1000;
+		if (lfsr_table::advance7(reg, n) != shiftsByOne(reg, true, n)) {
+			std::printf("advance7 mismatch: reg %04x, %lu shifts\n", reg, n);
+			return false;
+		}
+
+		// the 15-bit shortcut for 15 periods at a time in Channel4 repeats every 16 times
+		unsigned r = reg;
+		for (int i = 0; i < 16; ++i)
+			r ^= r >> 1;
+
+		if (r != reg) {
+			std::printf("15-bit shortcut of %04x does not repeat\n", reg);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void startNoise(PSG &psg) {
+	psg.init(false);
+	psg.reset(false);
+	psg.setEnabled(true);
+	psg.setSoVolume(0x77);
+	psg.mapSo(0x88);
+}
+
+// Writes to a noise register, with the clock shifts and 7-bit mode picked more often
+// at high noise frequencies, and with the counter step 0 and up.
+void randomWrite(PSG &a, PSG &b) {
+	unsigned const data = std::rand() & 0xFF;
+	switch (std::rand() % 8) {
+	case 0:
+		a.setNr41(data);
+		b.setNr41(data);
+		break;
+	case 1:
+	case 2:
+		a.setNr42(data);
+		b.setNr42(data);
+		break;
+	case 3:
+	case 4: {
+		unsigned const nr43 = std::rand() % 2 ? data & 0x3F : data;
+		a.setNr43(nr43);
+		b.setNr43(nr43);
+		break;
+	}
+	default:
+		a.setNr44(data | 0x80);
+		b.setNr44(data | 0x80);
+		break;
+	}
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	long const frames = argc > 1 ? std::atol(argv[1]) : 200;
+	if (frames <= 0) {
+		std::printf("usage: %s [frames]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::srand(1);
+	if (!tablesAgree())
+		return EXIT_FAILURE;
+
+	std::vector<uint_least32_t> bufA(buf_len), bufB(buf_len);
+	PSG a, b;
+	startNoise(a);
+	startNoise(b);
+	for (long f = 0; f < frames; ++f) {
+		a.setBuffer(&bufA[0]);
+		b.setBuffer(&bufB[0]);
+		for (unsigned long cc = 0; cc < cycles_per_frame;) {
+			unsigned long const next = std::min<unsigned long>(
+				cc + (std::rand() % 4 ? std::rand() % 0x400 : std::rand() % 0x8000) * 2 + 2,
+				cycles_per_frame);
+			for (; cc < next; cc += 2)
+				a.generateSamples(cc + 2, false);
+
+			b.generateSamples(next, false);
+			randomWrite(a, b);
+		}
+
+		a.resetCounter(0, cycles_per_frame, false);
+		b.resetCounter(0, cycles_per_frame, false);
+		std::size_t const n = a.fillBuffer();
+		if (b.fillBuffer() != n || !std::equal(bufA.begin(), bufA.begin() + n, bufB.begin())) {
+			std::printf("sample mismatch in frame %ld\n", f);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::printf("lfsr: %ld frames agree\n", frames);
+	return EXIT_SUCCESS;
+}
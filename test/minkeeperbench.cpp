@@ -0,0 +1,132 @@
+// Replays MinKeeper update sequences recorded by a libgambatte built with
+// minkeepertrace=1 (which writes minkeeper.trace while running a game), checking
+// that TreeMinKeeper and LinearMinKeeper agree and timing each of them.
+// Use the result to pick minkeeper=tree/linear when building libgambatte.
+//
+// usage: minkeeperbench minkeeper.trace [repetitions]
+
+#include "minkeeper.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace {
+
+struct Rec {
+	unsigned char id;
+	unsigned long value;
+};
+
+enum { id_init = 0xff };
+
+static bool readTrace(char const *filename, std::vector<Rec> byIds[]) {
+	std::FILE *const file = std::fopen(filename, "rb");
+	if (!file)
+		return false;
+
+	unsigned char buf[10];
+	while (std::fread(buf, 1, sizeof buf, file) == sizeof buf) {
+		Rec rec = { buf[1], 0 };
+		for (int i = 2; i < 10; ++i)
+			rec.value = rec.value << 4 << 4 | buf[i];
+
+		byIds[buf[0]].push_back(rec);
+	}
+
+	std::fclose(file);
+	return true;
+}
+
+template<class Keeper>
+static unsigned long replay(std::vector<Rec> const &recs) {
+	Keeper k(~0ul);
+	unsigned long sink = 0;
+	for (std::size_t i = 0; i < recs.size(); ++i) {
+		if (recs[i].id == id_init) {
+			k = Keeper(recs[i].value);
+		} else {
+			k.setValue(recs[i].id, recs[i].value);
+			sink += k.minValue() + k.min();
+		}
+	}
+
+	return sink;
+}
+
+template<class Keeper>
+static double nsPerUpdate(std::vector<Rec> const &recs, int reps, unsigned long &sink) {
+	std::clock_t const start = std::clock();
+	for (int i = 0; i < reps; ++i)
+		sink += replay<Keeper>(recs);
+
+	return (std::clock() - start) * 1.0e9 / CLOCKS_PER_SEC / (double(recs.size()) * reps);
+}
+
+template<int ids>
+static bool verify(std::vector<Rec> const &recs) {
+	TreeMinKeeper<ids> tree(~0ul);
+	LinearMinKeeper<ids> linear(~0ul);
+	for (std::size_t i = 0; i < recs.size(); ++i) {
+		if (recs[i].id == id_init) {
+			tree = TreeMinKeeper<ids>(recs[i].value);
+			linear = LinearMinKeeper<ids>(recs[i].value);
+		} else {
+			tree.setValue(recs[i].id, recs[i].value);
+			linear.setValue(recs[i].id, recs[i].value);
+		}
+
+		if (tree.min() != linear.min() || tree.minValue() != linear.minValue()) {
+			std::printf("%d ids: mismatch at update %lu\n", ids, static_cast<unsigned long>(i));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<int ids>
+static bool bench(std::vector<Rec> const &recs, int reps, unsigned long &sink) {
+	if (recs.empty())
+		return true;
+	if (!verify<ids>(recs))
+		return false;
+
+	double const tree = nsPerUpdate<TreeMinKeeper<ids> >(recs, reps, sink);
+	double const linear = nsPerUpdate<LinearMinKeeper<ids> >(recs, reps, sink);
+	std::printf("%d ids, %lu updates: tree %.2f ns, linear %.2f ns\n",
+	            ids, static_cast<unsigned long>(recs.size()), tree, linear);
+	return true;
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	if (argc < 2) {
+		std::printf("usage: %s minkeeper.trace [repetitions]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	static std::vector<Rec> byIds[0x100];
+	if (!readTrace(argv[1], byIds)) {
+		std::printf("failed to open %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	int const reps = argc > 2 ? std::atoi(argv[2]) : 10;
+	unsigned long sink = 0;
+	bool ok = bench<2>(byIds[2], reps, sink)   // LCD events
+	       && bench<8>(byIds[8], reps, sink)   // LCD memevents
+	       && bench<9>(byIds[9], reps, sink);  // InterruptRequester
+
+	for (int ids = 0; ids < 0x100; ++ids) {
+		if (!byIds[ids].empty() && ids != 2 && ids != 8 && ids != 9)
+			std::printf("%d ids: not replayed\n", ids);
+	}
+
+	// keep the replays from being optimized out
+	unsigned long volatile const result = sink;
+	(void)result;
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
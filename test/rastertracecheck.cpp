@@ -0,0 +1,173 @@
+// Checks the raster register write trace (GB::setRasterTrace). A ROM writes SCX with the
+// value of LY at every tenth line and BGP at the start of VBlank, every frame, and each
+// frame's trace must hold exactly those writes on those lines. Another ROM writes SCX
+// over and over, more often than the trace keeps per frame, which must then be counted
+// but only stored up to GB::RASTER_TRACE_SIZE. getRasterTrace must not store more than
+// asked for, and disabling the trace must clear it.
+//
+// usage: rastertracecheck
+
+#include "gambatte.h"
+#include "testrom.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "rastertracecheck.gbc";
+std::size_t const samples_per_frame = 35112;
+unsigned const first_line = 10, line_step = 10, last_line = 130;
+std::size_t const num_line_writes = (last_line - first_line) / line_step + 1;
+
+TestRom makeRom(bool const flood) {
+	TestRom rom;
+	rom.writeIo(0x40, 0x91);
+	std::size_t const loop = rom.pos();
+	if (flood) {
+		// ld c,$43; ld (c),a eight times; inc a; jr <ld (c),a>
+		rom.op(0x0E, 0x43);
+		for (int i = 0; i < 8; ++i)
+			rom.op(0xE2);
+
+		rom.op(0x3C).op(0x18, 0xF5);
+	} else {
+		for (unsigned ly = first_line; ly <= last_line; ly += line_step)
+			rom.waitIo(0x44, ly).writeIo(0x43, ly);
+
+		rom.waitIo(0x44, 144).writeIo(0x47, 0xE4);
+		rom.op(0xC3, loop, loop >> 8); // jp loop
+	}
+
+	return rom;
+}
+
+bool load(GB &gb, bool const flood) {
+	if (!makeRom(flood).save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return false;
+	}
+
+	LoadRes const loadres = gb.load(rom_file, GB::CGB_MODE);
+	std::remove(rom_file);
+	if (loadres != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return false;
+	}
+
+	return true;
+}
+
+void runFrame(GB &gb) {
+	std::vector<uint_least32_t> audio(samples_per_frame + 2064);
+	std::ptrdiff_t done;
+	do {
+		std::size_t samples = samples_per_frame;
+		done = gb.runFor(0, 160, &audio[0], samples);
+	} while (done < 0);
+}
+
+int checkLineWrites() {
+	GB gb;
+	if (!load(gb, false))
+		return 1;
+
+	gb.setRasterTrace(true);
+	for (int frame = 0; frame < 5; ++frame)
+		runFrame(gb);
+
+	int failures = 0;
+	std::vector<GB::RasterWrite> writes(GB::RASTER_TRACE_SIZE);
+	for (int frame = 0; frame < 3; ++frame) {
+		runFrame(gb);
+		std::size_t const n = gb.getRasterTrace(&writes[0], writes.size());
+		if (n != num_line_writes + 1) {
+			std::printf("frame %d has %d writes, not %d\n",
+			            frame, static_cast<int>(n), static_cast<int>(num_line_writes + 1));
+			++failures;
+			continue;
+		}
+
+		std::size_t scxWrites = 0, bgpWrites = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			GB::RasterWrite const &w = writes[i];
+			bool const scx = w.reg == 0x43 && w.ly == w.data;
+			bool const bgp = w.reg == 0x47 && w.ly == 144 && w.data == 0xE4;
+			scxWrites += scx;
+			bgpWrites += bgp;
+			if (!(scx || bgp) || w.lineCycle >= 456) {
+				std::printf("frame %d write %d is FF%02X=%02X on line %u cycle %u\n", frame,
+				            static_cast<int>(i), w.reg, w.data, w.ly, w.lineCycle);
+				++failures;
+			}
+		}
+
+		if (scxWrites != num_line_writes || bgpWrites != 1) {
+			std::printf("frame %d has %d SCX and %d BGP writes\n",
+			            frame, static_cast<int>(scxWrites), static_cast<int>(bgpWrites));
+			++failures;
+		}
+	}
+
+	GB::RasterWrite few[4];
+	few[3].reg = 0;
+	if (gb.getRasterTrace(few, 3) != num_line_writes + 1 || few[3].reg != 0) {
+		std::printf("getRasterTrace does not stop at the size asked for\n");
+		++failures;
+	}
+
+	gb.setRasterTrace(false);
+	runFrame(gb);
+	if (gb.getRasterTrace(&writes[0], writes.size()) != 0) {
+		std::printf("writes are still traced after disabling the trace\n");
+		++failures;
+	}
+
+	return failures;
+}
+
+int checkOverflow() {
+	GB gb;
+	if (!load(gb, true))
+		return 1;
+
+	gb.setRasterTrace(true);
+	for (int frame = 0; frame < 3; ++frame)
+		runFrame(gb);
+
+	std::vector<GB::RasterWrite> writes(GB::RASTER_TRACE_SIZE + 1);
+	writes.back().reg = 0;
+	std::size_t const n = gb.getRasterTrace(&writes[0], writes.size());
+	if (n <= GB::RASTER_TRACE_SIZE) {
+		std::printf("only %d writes counted in a frame of SCX writes\n", static_cast<int>(n));
+		return 1;
+	}
+
+	int failures = 0;
+	for (std::size_t i = 0; i < GB::RASTER_TRACE_SIZE; ++i)
+		failures += writes[i].reg != 0x43;
+
+	if (writes.back().reg != 0) {
+		std::printf("more than RASTER_TRACE_SIZE writes stored\n");
+		++failures;
+	}
+
+	if (failures)
+		std::printf("%d bad writes in a frame of %d SCX writes\n", failures, static_cast<int>(n));
+
+	return failures;
+}
+
+} // anon namespace
+
+int main() {
+	int const failures = checkLineWrites() + checkOverflow();
+	if (failures)
+		return EXIT_FAILURE;
+
+	std::printf("raster trace: %d writes per frame and overflow agree\n",
+	            static_cast<int>(num_line_writes + 1));
+	return EXIT_SUCCESS;
+}
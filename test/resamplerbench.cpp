@@ -0,0 +1,239 @@
+// Compares the resamplers of the frontends (ResamplerInfo, see
+// common/resample/resamplerinfo.h) going from the 2097152 Hz sound of the GB to common
+// output rates. For each it gives:
+//  - the throughput in millions of input samples (stereo frames) per second, on GB
+//    sound made with the PSG, or on a recording of it if one is given,
+//  - the latency, from a step in the input to the output getting halfway to where it
+//    settles,
+//  - the SNR of a 1 kHz tone, what is left of the output once the tone is fitted away,
+//  - the aliasing, how far below the 1 kHz tone one as loud at the output rate less
+//    1 kHz comes out, at 1 kHz, inf if none of it is left after rounding,
+//  - the time it takes to create the resampler the first time, and again, with the sinc
+//    kernels shared (see sharedSincKernel).
+// Input is fed a frame (35112 samples) at a time, like the frontends do.
+//
+// usage: resamplerbench [seconds] [recording]
+// where recording is raw signed 16-bit native endian stereo at 2097152 Hz.
+
+#include "sound.h"
+#include "resample/resampler.h"
+#include "resample/resamplerinfo.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+enum { in_rate = 2097152, period = 35112, cycles_per_frame = 2 * period };
+enum { buf_len = period + 2064 };
+
+double const pi = 3.14159265358979323846;
+
+struct Output {
+	std::vector<short> samples;
+	double rate;
+};
+
+Output resampleAll(ResamplerInfo const &info, long const outRate, std::vector<short> const &in) {
+	Resampler *const r = info.create(in_rate, outRate, period);
+	unsigned long mul = 1, div = 1;
+	r->exactRatio(mul, div);
+
+	Output out;
+	out.rate = static_cast<double>(in_rate) * mul / div;
+	std::vector<short> buf(r->maxOut(period) * 2);
+	for (std::size_t pos = 0; pos < in.size() / 2; pos += period) {
+		std::size_t const n = std::min<std::size_t>(period, in.size() / 2 - pos);
+		std::size_t const produced = r->resample(&buf[0], &in[pos * 2], n);
+		out.samples.insert(out.samples.end(), buf.begin(), buf.begin() + produced * 2);
+	}
+
+	delete r;
+	return out;
+}
+
+std::vector<short> tone(double const freq, double const seconds) {
+	std::vector<short> in(static_cast<std::size_t>(seconds * in_rate) * 2);
+	for (std::size_t i = 0; i < in.size() / 2; ++i)
+		in[i * 2] = in[i * 2 + 1] = static_cast<short>(std::floor(
+			16384 * std::sin(2 * pi * freq * i / in_rate) + 0.5));
+
+	return in;
+}
+
+// Fits a * sin + b * cos + c at freq to the left channel of out past skip seconds by least
+// squares. Returns the amplitude of the fit, and the RMS of what is left in residual.
+double fitTone(Output const &out, double const freq, double const skip, double &residual) {
+	std::size_t const begin = static_cast<std::size_t>(skip * out.rate);
+	std::size_t const end = out.samples.size() / 2;
+	double m[3][4] = { { 0 } };
+	for (std::size_t i = begin; i < end; ++i) {
+		double const w = 2 * pi * freq * i / out.rate;
+		double const v[4] = { std::sin(w), std::cos(w), 1, static_cast<double>(out.samples[i * 2]) };
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 4; ++c)
+				m[r][c] += v[r] * v[c];
+		}
+	}
+
+	for (int p = 0; p < 3; ++p) {
+		for (int r = 0; r < 3; ++r) {
+			if (r != p) {
+				double const f = m[r][p] / m[p][p];
+				for (int c = 0; c < 4; ++c)
+					m[r][c] -= f * m[p][c];
+			}
+		}
+	}
+
+	double const a = m[0][3] / m[0][0], b = m[1][3] / m[1][1], c = m[2][3] / m[2][2];
+	double sum = 0;
+	for (std::size_t i = begin; i < end; ++i) {
+		double const w = 2 * pi * freq * i / out.rate;
+		double const e = out.samples[i * 2] - (a * std::sin(w) + b * std::cos(w) + c);
+		sum += e * e;
+	}
+
+	residual = std::sqrt(sum / (end - begin));
+	return std::sqrt(a * a + b * b);
+}
+
+double latencyMs(ResamplerInfo const &info, long const outRate) {
+	double const stepTime = 0.05;
+	std::vector<short> in(static_cast<std::size_t>(0.1 * in_rate) * 2);
+	std::fill(in.begin() + static_cast<std::size_t>(stepTime * in_rate) * 2, in.end(), 16384);
+
+	// the sinc resamplers leave headroom, so halfway is to where the output settles
+	Output const out = resampleAll(info, outRate, in);
+	double const half = 0.5 * out.samples[out.samples.size() - 2];
+	for (std::size_t i = 1; i < out.samples.size() / 2; ++i) {
+		double const y0 = out.samples[i * 2 - 2], y1 = out.samples[i * 2];
+		if (y0 < half && y1 >= half)
+			return ((i - 1 + (half - y0) / (y1 - y0)) / out.rate - stepTime) * 1000;
+	}
+
+	return -1;
+}
+
+double createUs(ResamplerInfo const &info, long const outRate) {
+	std::clock_t const start = std::clock();
+	delete info.create(in_rate, outRate, period);
+	return (std::clock() - start) * 1.0e6 / CLOCKS_PER_SEC;
+}
+
+double dB(double const ratio) {
+	return 20 * std::log10(ratio);
+}
+
+// GB sound to time the resamplers on: the four channels playing notes that change
+// every frame, as in test/audiobench.
+std::vector<short> gbSound(long const frames) {
+	PSG psg;
+	psg.init(false);
+	psg.reset(false);
+	psg.setEnabled(true);
+	psg.setSoVolume(0x77);
+	psg.mapSo(0xDE);
+	psg.setNr11(0x80);
+	psg.setNr12(0xF3);
+	psg.setNr14(0x86, false);
+	psg.setNr21(0x40);
+	psg.setNr22(0xA0);
+	psg.setNr24(0x87, false);
+	for (unsigned i = 0; i < 0x10; ++i)
+		psg.waveRamWrite(i, i * 0x11 ^ 0x0F);
+
+	psg.setNr30(0x80);
+	psg.setNr32(0x20);
+	psg.setNr34(0x85);
+	psg.setNr42(0xF1);
+	psg.setNr43(0x34);
+	psg.setNr44(0x80);
+
+	std::vector<uint_least32_t> buf(buf_len);
+	std::vector<short> sound;
+	for (long f = 0; f < frames; ++f) {
+		psg.setBuffer(&buf[0]);
+		psg.setNr13(f * 37 & 0xFF);
+		psg.setNr23(f * 53 & 0xFF);
+		psg.setNr33(f * 29 & 0xFF);
+		psg.generateSamples(cycles_per_frame, false);
+		psg.resetCounter(0, cycles_per_frame, false);
+		std::size_t const n = psg.fillBuffer();
+		std::size_t const size = sound.size();
+		sound.resize(size + n * 2);
+		std::memcpy(&sound[size], &buf[0], n * sizeof buf[0]);
+	}
+
+	return sound;
+}
+
+bool readRecording(char const *const path, std::vector<short> &sound) {
+	std::FILE *const file = std::fopen(path, "rb");
+	if (!file)
+		return false;
+
+	short frame[2];
+	sound.clear();
+	while (std::fread(frame, sizeof frame, 1, file) == 1)
+		sound.insert(sound.end(), frame, frame + 2);
+
+	std::fclose(file);
+	return !sound.empty();
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	double const seconds = argc > 1 ? std::atof(argv[1]) : 10;
+	std::vector<short> sound;
+	if (seconds <= 0 || (argc > 2 && !readRecording(argv[2], sound))) {
+		std::printf("usage: %s [seconds] [recording]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (sound.empty())
+		sound = gbSound(static_cast<long>(seconds * in_rate / period) + 1);
+
+	long const outRates[] = { 44100, 48000, 96000 };
+	std::vector<short> const tone1k = tone(1000, 0.5);
+	int descWidth = 0;
+	for (std::size_t i = 0; i < ResamplerInfo::num(); ++i)
+		descWidth = std::max<int>(descWidth, std::strlen(ResamplerInfo::get(i).desc));
+
+	std::printf("%-*s %6s %8s %11s %7s %9s %8s %10s\n", descWidth, "resampler", "rate", "MS/s",
+	            "latency ms", "SNR dB", "alias dB", "init us", "reinit us");
+	for (std::size_t i = 0; i < ResamplerInfo::num(); ++i) {
+		ResamplerInfo const &info = ResamplerInfo::get(i);
+		for (std::size_t j = 0; j < sizeof outRates / sizeof *outRates; ++j) {
+			long const outRate = outRates[j];
+			double const init = createUs(info, outRate);
+			double const reinit = createUs(info, outRate);
+			double played = 0;
+			std::clock_t const start = std::clock();
+			do {
+				played += sound.size() / 2;
+				resampleAll(info, outRate, sound);
+			} while (std::clock() - start < CLOCKS_PER_SEC);
+
+			double const cpuSeconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+			double residual = 0, aliasResidual = 0;
+			double const amplitude = fitTone(resampleAll(info, outRate, tone1k), 1000, 0.1, residual);
+			double const alias = fitTone(resampleAll(info, outRate, tone(outRate - 1000, 0.5)),
+			                             1000, 0.1, aliasResidual);
+			std::printf("%-*s %6ld %8.1f %11.2f %7.1f %9.1f %8.0f %10.0f\n",
+			            descWidth, info.desc, outRate,
+			            played / cpuSeconds / 1.0e6, latencyMs(info, outRate),
+			            dB(amplitude / std::sqrt(2.0) / residual), dB(amplitude / alias),
+			            init, reinit);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+// Checks that playing input with GB::setInputSchedule and one GB::runSchedule call gives
+// the same run as the same input given by an InputGetter, changed each time runFor
+// returns a completed frame.
+// A ROM keeps reading both halves of the joypad register into a ring in WRAM, and turns
+// the LCD off and on every few frames, so that the blank frames of the LCD being off are
+// counted too. WRAM, the cycle based time and the last frame must then be the same.
+// It also checks that the first entry of a schedule is seen at once, and plays a schedule
+// of more frames than fit between two cycle counter rebases, with the NO_SOUND speedup
+// flag and no audio buffer.
+//
+// usage: schedulecheck
+
+#include "gambatte.h"
+#include "testrom.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "schedulecheck.gbc";
+std::size_t const samples_per_frame = 35112;
+std::size_t const num_frames = 60;
+std::size_t const long_num_frames = 64000;
+std::ptrdiff_t const video_pitch = 160;
+
+TestRom makeRom() {
+	TestRom rom;
+	rom.op(0x21, 0x00, 0xC0); // ld hl,$C000
+	rom.op(0x11, 0x00, 0x00); // ld de,0
+	std::size_t const loop = rom.pos();
+	rom.writeIo(0x00, 0x10).op(0xF0, 0x00).op(0x22); // buttons: ldh a,($00); ld (hl+),a
+	rom.writeIo(0x00, 0x20).op(0xF0, 0x00).op(0x22); // d-pad
+	rom.op(0x7C).op(0xE6, 0x1F).op(0xF6, 0xC0).op(0x67); // ld a,h; and $1F; or $C0; ld h,a
+	rom.op(0x06, 0x40).op(0x05).op(0x20, 0xFD); // ld b,$40; dec b; jr nz,<dec b>
+	rom.op(0x13); // inc de
+	// LCDC = $11 with bit 7 from bit 0 of d, toggling the LCD every 256 loops, a few frames
+	rom.op(0x7A).op(0x0F).op(0xE6, 0x80).op(0xF6, 0x11).op(0xE0, 0x40);
+	rom.op(0x18, loop - (rom.pos() + 2)); // jr loop
+	return rom;
+}
+
+unsigned frameInput(std::size_t frame) {
+	return (frame * 0x9E + (frame >> 2) * 0x35 + 1) & 0xFF;
+}
+
+unsigned getInput(void *p) { return *static_cast<unsigned *>(p); }
+
+bool load(GB &gb) {
+	if (gb.load(rom_file, GB::CGB_MODE) != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return false;
+	}
+
+	gb.setTimeMode(true);
+	return true;
+}
+
+std::vector<unsigned char> wram(GB &gb) {
+	std::vector<unsigned char> mem;
+	for (unsigned p = 0xC000; p < 0xE000; ++p)
+		mem.push_back(gb.externalRead(p));
+
+	return mem;
+}
+
+int check(std::size_t const numFrames) {
+	// a long schedule does not fit an audio buffer, so run it without sound
+	bool const longRun = numFrames > num_frames;
+	std::vector<unsigned char> inputs(numFrames);
+	for (std::size_t i = 0; i < numFrames; ++i)
+		inputs[i] = frameInput(i);
+
+	GB getterGb, scheduleGb;
+	bool const loaded = load(getterGb) && load(scheduleGb);
+	if (!loaded)
+		return 1;
+
+	if (longRun) {
+		getterGb.setSpeedupFlags(GB::NO_SOUND);
+		scheduleGb.setSpeedupFlags(GB::NO_SOUND);
+	}
+
+	std::vector<uint_least32_t> getterVideo(160 * 144), scheduleVideo(160 * 144);
+	// turning the LCD off makes the frame it is in longer, so leave room for more
+	std::vector<uint_least32_t> audio(longRun ? 1 : 2 * numFrames * samples_per_frame + 2064);
+	uint_least32_t *const audioBuf = longRun ? 0 : &audio[0];
+
+	unsigned input = 0;
+	getterGb.setInputGetter(getInput, &input);
+	std::size_t lcdOffFrames = 0;
+	std::size_t getterSamples = 0;
+	std::size_t getterFrameSample = 0;
+	for (std::size_t frame = 0; frame < numFrames; ++frame) {
+		input = inputs[frame];
+		std::ptrdiff_t done;
+		do {
+			std::size_t samples = samples_per_frame;
+			done = getterGb.runFor(&getterVideo[0], video_pitch, audioBuf, samples);
+			if (done >= 0)
+				getterFrameSample = getterSamples + done;
+
+			getterSamples += samples;
+		} while (done < 0);
+
+		lcdOffFrames += !(getterGb.externalRead(0xFF40) & 0x80);
+	}
+
+	int failures = 0;
+	scheduleGb.externalWrite(0xFF00, 0x10);
+	scheduleGb.setInputSchedule(&inputs[0], numFrames);
+	unsigned const p1 = scheduleGb.externalRead(0xFF00) & 0xF;
+	if (p1 != (~inputs[0] & 0xF)) {
+		std::printf("the first scheduled input is not seen at once, P1 reads %x\n", p1);
+		++failures;
+	}
+
+	std::size_t samples = getterSamples + samples_per_frame;
+	std::ptrdiff_t const done = scheduleGb.runSchedule(&scheduleVideo[0], video_pitch,
+	                                                   audioBuf, samples);
+	if (done < 0 || static_cast<std::size_t>(done) != getterFrameSample) {
+		std::printf("runSchedule did not stop at the frame that ends the schedule\n");
+		++failures;
+	}
+
+	if (wram(getterGb) != wram(scheduleGb)) {
+		std::printf("WRAM differs\n");
+		++failures;
+	}
+
+	if (getterGb.timeNow() != scheduleGb.timeNow()) {
+		std::printf("the runs stopped at different times, %u and %u\n",
+		            getterGb.timeNow(), scheduleGb.timeNow());
+		++failures;
+	}
+
+	if (getterVideo != scheduleVideo) {
+		std::printf("the last frames differ\n");
+		++failures;
+	}
+
+	if (!lcdOffFrames) {
+		std::printf("no frames were run with the LCD off\n");
+		++failures;
+	}
+
+	if (!failures) {
+		std::printf("schedule: %d frames (%d with the LCD off) agree\n",
+		            static_cast<int>(numFrames), static_cast<int>(lcdOffFrames));
+	}
+
+	return failures;
+}
+
+} // anon namespace
+
+int main() {
+	if (!makeRom().save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	// the long schedule runs past the point where runFor would rebase the cycle counters
+	int const failures = check(num_frames) + check(long_num_frames);
+	std::remove(rom_file);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,283 @@
+// Checks the sound log of GB::setSoundLogging against the runFor audio buffer. A ROM
+// plays all four channels and writes the sound registers and wave RAM in a tight loop.
+// The log, read in odd sized pieces and rendered by a SoundLogRenderer as it comes, must
+// give back the runFor samples exactly, also when logged with the NO_SOUND speedup flag.
+// A log not read past PSG::max_log_size must start over from the sound state, keeping
+// the rest of a record partly read, and still render the runFor samples from there.
+// Records of ops that are not ones, such as writes past wave RAM, must not be taken.
+//
+// usage: soundlogcheck
+
+#include "gambatte.h"
+#include "soundlog.h"
+#include "sound.h"
+#include "sound/sound_log.h"
+#include "testrom.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "soundlogcheck.gbc";
+std::size_t const samples_per_frame = 35112;
+std::size_t const read_piece = 777;
+
+TestRom makeRom() {
+	TestRom rom;
+	rom.writeIo(0x26, 0x80).writeIo(0x24, 0x77);
+	// wave RAM: ld hl,$FF30; ld a,l; swap a; xor l; ld (hl+),a; ld a,l; cp $40; jr nz,<ld a,l>
+	rom.op(0x21, 0x30, 0xFF).op(0x7D).op(0xCB, 0x37).op(0xAD).op(0x22).op(0x7D).op(0xFE, 0x40).op(0x20, 0xF6);
+	rom.writeIo(0x11, 0x80).writeIo(0x12, 0xF3).writeIo(0x14, 0x86);
+	rom.writeIo(0x16, 0x40).writeIo(0x17, 0xA0).writeIo(0x19, 0x87);
+	rom.writeIo(0x1A, 0x80).writeIo(0x1C, 0x20).writeIo(0x1E, 0x85);
+	rom.writeIo(0x21, 0xF1).writeIo(0x22, 0x34).writeIo(0x23, 0x80);
+	rom.writeIo(0x40, 0x91);
+	// ld hl,$FF3F; then forever: inc b; ld a,b; ldh ($13),a; swap a; ldh ($1D),a;
+	// ldh ($25),a; ld (hl),a; and 7; or $20; ldh ($22),a
+	rom.op(0x21, 0x3F, 0xFF);
+	std::size_t const loop = rom.pos();
+	rom.op(0x04).op(0x78).op(0xE0, 0x13).op(0xCB, 0x37).op(0xE0, 0x1D).op(0xE0, 0x25);
+	rom.op(0x77).op(0xE6, 7).op(0xF6, 0x20).op(0xE0, 0x22);
+	rom.op(0xC3, loop, loop >> 8); // jp loop
+	return rom;
+}
+
+bool load(GB &gb) {
+	if (gb.load(rom_file, GB::CGB_MODE) != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return false;
+	}
+
+	return true;
+}
+
+// Runs a frame, adding its samples to audio.
+void runFrame(GB &gb, std::vector<uint_least32_t> &audio) {
+	std::size_t const pos = audio.size();
+	std::size_t samples = samples_per_frame;
+	audio.resize(pos + samples_per_frame + 2064);
+	gb.runFor(0, 160, &audio[pos], samples);
+	audio.resize(pos + samples);
+}
+
+// Moves the whole log of gb, in pieces of read_piece bytes, to log.
+void readLog(GB &gb, std::vector<char> &log) {
+	for (;;) {
+		std::size_t const pos = log.size();
+		log.resize(pos + read_piece);
+		log.resize(pos + gb.readSoundLog(&log[pos], read_piece));
+		if (log.size() != pos + read_piece)
+			return;
+	}
+}
+
+// Writes log to renderer, from and to end, and adds what it renders to out.
+void render(SoundLogRenderer &renderer, std::vector<char> const &log, std::size_t const begin,
+            std::size_t const end, std::vector<uint_least32_t> &out) {
+	if (begin != end)
+		renderer.write(&log[begin], end - begin);
+
+	uint_least32_t buf[4096];
+	while (std::size_t const n = renderer.render(buf, sizeof buf / sizeof *buf))
+		out.insert(out.end(), buf, buf + n);
+}
+
+// The number of samples of rendered that differ from audio, starting at sample first.
+std::size_t countDiffering(std::vector<uint_least32_t> const &rendered, std::size_t const first,
+                           std::vector<uint_least32_t> const &audio) {
+	std::size_t differ = 0;
+	for (std::size_t i = 0; i < rendered.size(); ++i)
+		differ += first + i >= audio.size() || rendered[i] != audio[first + i];
+
+	return differ;
+}
+
+// Logging as the frames are run, with and without NO_SOUND.
+int checkRendered() {
+	GB gb, quietGb;
+	if (!load(gb) || !load(quietGb))
+		return 1;
+
+	quietGb.setSpeedupFlags(GB::NO_SOUND);
+	gb.setSoundLogging(true);
+	quietGb.setSoundLogging(true);
+
+	SoundLogRenderer renderer, quietRenderer;
+	std::vector<uint_least32_t> audio, rendered, quietRendered, quietAudio;
+	std::vector<char> log, quietLog;
+	for (int frame = 0; frame < 60; ++frame) {
+		runFrame(gb, audio);
+		runFrame(quietGb, quietAudio);
+		std::size_t const pos = log.size(), quietPos = quietLog.size();
+		readLog(gb, log);
+		readLog(quietGb, quietLog);
+		render(renderer, log, pos, log.size(), rendered);
+		render(quietRenderer, quietLog, quietPos, quietLog.size(), quietRendered);
+	}
+
+	int failures = 0;
+	if (rendered.size() != audio.size() || countDiffering(rendered, 0, audio)) {
+		std::printf("%d of %d rendered samples differ from the %d runFor samples\n",
+		            static_cast<int>(countDiffering(rendered, 0, audio)),
+		            static_cast<int>(rendered.size()), static_cast<int>(audio.size()));
+		++failures;
+	}
+
+	if (quietRendered.size() != audio.size() || countDiffering(quietRendered, 0, audio)) {
+		std::printf("%d of %d samples rendered with NO_SOUND differ from the %d runFor samples\n",
+		            static_cast<int>(countDiffering(quietRendered, 0, audio)),
+		            static_cast<int>(quietRendered.size()), static_cast<int>(audio.size()));
+		++failures;
+	}
+
+	std::printf("%d bytes of log rendered to %d samples\n",
+	            static_cast<int>(log.size()), static_cast<int>(rendered.size()));
+	return failures;
+}
+
+// Whether log ends at the end of a record.
+bool endsWithRecord(std::vector<char> const &log) {
+	unsigned char const *const begin = reinterpret_cast<unsigned char const *>(&log[0]);
+	unsigned char const *p = begin;
+	while (p != begin + log.size()) {
+		if (!sound_log::skipRecord(p, begin + log.size()))
+			return false;
+	}
+
+	return true;
+}
+
+// Logging while the log is not read for long.
+int checkStartedOver() {
+	GB gb;
+	if (!load(gb))
+		return 1;
+
+	gb.setSoundLogging(true);
+	std::vector<uint_least32_t> audio, rendered;
+	std::vector<char> log;
+	runFrame(gb, audio);
+	log.resize(read_piece);
+	log.resize(gb.readSoundLog(&log[0], read_piece));
+	// then a byte at a time until the log read ends within a record
+	while (endsWithRecord(log) && log.size() < 2 * read_piece) {
+		log.push_back(0);
+		log.resize(log.size() - 1 + gb.readSoundLog(&log[log.size() - 1], 1));
+	}
+
+	std::size_t const read = log.size();
+	for (int frame = 0; frame < 200; ++frame)
+		runFrame(gb, audio);
+
+	readLog(gb, log);
+
+	// the last state, where the log started over
+	unsigned char const *const begin = reinterpret_cast<unsigned char const *>(&log[0]);
+	unsigned char const *p = begin;
+	std::size_t lastState = 0;
+	int states = 0;
+	while (p != begin + log.size()) {
+		if (*p == sound_log::op_state) {
+			lastState = p - begin;
+			++states;
+		}
+
+		if (!sound_log::skipRecord(p, begin + log.size())) {
+			std::printf("the log does not end at the end of a record\n");
+			return 1;
+		}
+	}
+
+	std::size_t const unread = log.size() - read;
+	if (states != 2 || unread > PSG::max_log_size + samples_per_frame) {
+		std::printf("%d bytes left unread, with %d states in the log\n", static_cast<int>(unread), states);
+		return 1;
+	}
+
+	// up to the last state, the log gives the start of the run
+	SoundLogRenderer renderer;
+	render(renderer, log, 0, lastState, rendered);
+	int failures = 0;
+	if (countDiffering(rendered, 0, audio)) {
+		std::printf("%d of %d samples rendered up to the restart differ from the runFor samples\n",
+		            static_cast<int>(countDiffering(rendered, 0, audio)), static_cast<int>(rendered.size()));
+		++failures;
+	}
+
+	std::vector<uint_least32_t> tail;
+	render(renderer, log, lastState, log.size(), tail);
+	std::size_t const first = audio.size() - std::min(tail.size(), audio.size());
+	if (tail.size() < samples_per_frame || countDiffering(tail, first, audio)) {
+		std::printf("%d of %d samples rendered after the restart differ from the runFor samples\n",
+		            static_cast<int>(countDiffering(tail, first, audio)), static_cast<int>(tail.size()));
+		++failures;
+	}
+
+	std::printf("log started over with %d bytes unread, %d samples rendered after it\n",
+	            static_cast<int>(unread), static_cast<int>(tail.size()));
+	return failures;
+}
+
+// A log with records that are not valid after it.
+int checkRejected() {
+	GB gb;
+	if (!load(gb))
+		return 1;
+
+	gb.setSoundLogging(true);
+	std::vector<uint_least32_t> audio, rendered;
+	std::vector<char> log;
+	runFrame(gb, audio);
+	readLog(gb, log);
+
+	SoundLogRenderer renderer;
+	render(renderer, log, 0, log.size(), rendered);
+
+	// a time with more number bytes than cc_t has bits for, then the bad op, then a time
+	std::vector<char> longTime(1, sound_log::op_time);
+	longTime.insert(longTime.end(), 40, static_cast<char>(0x80));
+	longTime.push_back(0);
+	unsigned char const badOps[] = { 0x08, 0x0F, sound_log::op_write + sound_log::num_write_regs,
+	                                 sound_log::op_wave + sound_log::num_wave_bytes, 0xFF };
+	int failures = 0;
+	for (std::size_t i = 0; i < sizeof badOps / sizeof *badOps; ++i) {
+		char const bad[] = { static_cast<char>(badOps[i]), 0x10, 0x55, sound_log::op_time, 0x40 };
+		std::vector<char> badLog(log);
+		badLog.insert(badLog.end(), longTime.begin(), longTime.end());
+		badLog.insert(badLog.end(), bad, bad + sizeof bad);
+
+		unsigned char const *const begin = reinterpret_cast<unsigned char const *>(&badLog[0]);
+		unsigned char const *p = begin;
+		while (p != begin + badLog.size() && sound_log::skipRecord(p, begin + badLog.size())) {}
+
+		SoundLogRenderer badRenderer;
+		std::vector<uint_least32_t> badRendered;
+		render(badRenderer, badLog, 0, badLog.size(), badRendered);
+		if (p != begin + log.size() + longTime.size() || badRendered != rendered) {
+			std::printf("op %02X is taken as a record\n", badOps[i]);
+			++failures;
+		}
+	}
+
+	if (!failures)
+		std::printf("%d bad ops rejected\n", static_cast<int>(sizeof badOps / sizeof *badOps));
+
+	return failures;
+}
+
+} // anon namespace
+
+int main() {
+	if (!makeRom().save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	int const failures = checkRendered() + checkStartedOver() + checkRejected();
+	std::remove(rom_file);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
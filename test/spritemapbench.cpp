@@ -0,0 +1,144 @@
+// Times the sprite line mapping done by the PPU on OAM changes (mapSpriteLines, see
+// libgambatte/src/video/sprite_lines.h) against the portable version, apart for crowded
+// OAMs, with many sprites on the same lines, and sparse ones, with a few sprites on
+// screen like most games have. Checks that both map the same sprites to each line.
+// Build with e.g. CXXFLAGS="-O2 -DGAMBATTE_NO_SIMD" to time without SSE2.
+//
+// usage: spritemapbench [oams]
+
+#include "video/sprite_lines.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+enum { num_oams = 0x100 };
+
+struct Oam {
+	unsigned char posbuf[2 * lcd_num_oam_entries];
+	bool largeSprites[lcd_num_oam_entries];
+};
+
+struct Map {
+	SpriteLine spritemap[lcd_vres];
+	unsigned char num[lcd_vres];
+
+	bool operator==(Map const &rhs) const {
+		if (std::memcmp(num, rhs.num, sizeof num))
+			return false;
+
+		for (int ly = 0; ly < lcd_vres; ++ly) {
+			if (std::memcmp(spritemap[ly], rhs.spritemap[ly], num[ly] & 0x7F))
+				return false;
+		}
+
+		return true;
+	}
+};
+
+typedef void (*MapSpriteLines)(unsigned char const *posbuf, bool const *largeSprites,
+		SpriteLine *spritemap, unsigned char *num, unsigned numBase);
+
+// All 40 sprites clustered in Y, so that many lines have more than 10. Every other OAM
+// mixes 8x16 sprites in.
+Oam crowdedOam(int const o) {
+	Oam oam;
+	int const ybase = std::rand() % 0xA0;
+	for (int i = 0; i < lcd_num_oam_entries; ++i) {
+		oam.posbuf[2 * i] = ybase + std::rand() % 24;
+		oam.posbuf[2 * i + 1] = std::rand() % 0xB0;
+		oam.largeSprites[i] = o & 1 ? std::rand() & 1 : false;
+	}
+
+	return oam;
+}
+
+// Up to 12 sprites anywhere on screen, and the others hidden at Y 0.
+Oam sparseOam(int const o) {
+	Oam oam;
+	int const numShown = std::rand() % 13;
+	for (int i = 0; i < lcd_num_oam_entries; ++i) {
+		oam.posbuf[2 * i] = i < numShown ? std::rand() % (lcd_vres + 16) : 0;
+		oam.posbuf[2 * i + 1] = std::rand() % 0xB0;
+		oam.largeSprites[i] = o & 1 ? std::rand() & 1 : false;
+	}
+
+	return oam;
+}
+
+template<MapSpriteLines map>
+double nsPerMap(std::vector<Oam> const &oams, long const n, Map &m) {
+	std::clock_t const start = std::clock();
+	for (long i = 0; i < n; ++i) {
+		Oam const &oam = oams[i % num_oams];
+		map(oam.posbuf, oam.largeSprites, m.spritemap, m.num, 0x80);
+	}
+
+	return (std::clock() - start) * 1.0e9 / CLOCKS_PER_SEC / n;
+}
+
+bool mapsAgree(std::vector<Oam> const &oams, char const *name) {
+	for (int o = 0; o < num_oams; ++o) {
+		Map ref, m;
+		mapSpriteLinesPortable(oams[o].posbuf, oams[o].largeSprites, ref.spritemap, ref.num, 0x80);
+		mapSpriteLines(oams[o].posbuf, oams[o].largeSprites, m.spritemap, m.num, 0x80);
+		if (!(ref == m)) {
+			std::printf("mapSpriteLines mismatch on %s oam %d\n", name, o);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	long const n = argc > 1 ? std::atol(argv[1]) : 1000000;
+	if (n <= 0) {
+		std::printf("usage: %s [oams]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::srand(1);
+	std::vector<Oam> crowded, sparse;
+	for (int o = 0; o < num_oams; ++o) {
+		crowded.push_back(crowdedOam(o));
+		sparse.push_back(sparseOam(o));
+	}
+
+	// Y positions around the first and last lines, as both 8x8 and 8x16 sprites
+	Oam &edge = crowded[0];
+	static unsigned char const edgeY[] = { 0, 1, 8, 9, 16, 17, 152, 153, 159, 160, 161, 255 };
+	for (int i = 0; i < lcd_num_oam_entries; ++i) {
+		edge.posbuf[2 * i] = edgeY[i % sizeof edgeY];
+		edge.largeSprites[i] = i / sizeof edgeY & 1;
+	}
+
+	if (!mapsAgree(crowded, "crowded") || !mapsAgree(sparse, "sparse"))
+		return EXIT_FAILURE;
+
+	Map m;
+	std::printf("%s:\n",
+#if defined GAMBATTE_SPRITE_LINES_SSE2
+	            "sse2"
+#else
+	            "no simd"
+#endif
+	);
+	std::printf("crowded: portable %.0f ns/oam, mapSpriteLines %.0f ns/oam\n",
+	            nsPerMap<mapSpriteLinesPortable>(crowded, n, m), nsPerMap<mapSpriteLines>(crowded, n, m));
+	std::printf("sparse: portable %.0f ns/oam, mapSpriteLines %.0f ns/oam\n",
+	            nsPerMap<mapSpriteLinesPortable>(sparse, n, m), nsPerMap<mapSpriteLines>(sparse, n, m));
+
+	// keep the stores from being optimized out
+	unsigned char volatile const result = m.num[n % lcd_vres];
+	(void)result;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+// Checks which sprites the PPU draws where they overlap, on DMG and CGB. A ROM puts 40
+// flipped sprites with transparent pixels in two crowded bands, so that lines have more
+// than the 10 sprites a line can show, and some sprites share their X position. The
+// frames must then match a plain reference: the first 10 sprites on a line in OAM order
+// are shown, and where their pixels overlap, the sprite with the lowest X wins on DMG,
+// with OAM order breaking ties, and the first one in OAM order wins on CGB.
+//
+// usage: spriteprioritycheck
+
+#include "gambatte.h"
+#include "testrom.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "spriteprioritycheck.gbc";
+std::size_t const samples_per_frame = 35112;
+std::size_t const tiles_pos = 0x200, oam_pos = 0x300;
+int const num_tiles = 4;
+
+TestRom makeRom() {
+	TestRom rom;
+	std::srand(1);
+	for (int i = 0; i < 16 * num_tiles; ++i)
+		rom[tiles_pos + i] = std::rand() & 0xFF;
+
+	for (int i = 0; i < 40; ++i) {
+		bool const lowerBand = i & 1;
+		rom[oam_pos + 4 * i] = 16 + (lowerBand ? 100 : 40) + std::rand() % 12;
+		// every fourth sprite at the X of the one before it in its band, and some partly
+		// off screen
+		rom[oam_pos + 4 * i + 1] = i % 4 == 3
+			? rom[oam_pos + 4 * i - 7]
+			: (lowerBand ? 110 : 0) + std::rand() % 56;
+		rom[oam_pos + 4 * i + 2] = 1 + std::rand() % num_tiles;
+		// palettes and flips, without BG priority or the CGB tile bank
+		rom[oam_pos + 4 * i + 3] = std::rand() & 0x77;
+	}
+
+	rom.writeIo(0x40, 0x00); // LCD off
+	// clear both VRAM banks: ld hl,$8000; xor a; ld (hl+),a; ld a,h; cp $A0; jr nz,<xor a>
+	rom.writeIo(0x4F, 1).op(0x21, 0x00, 0x80).op(0xAF).op(0x22).op(0x7C).op(0xFE, 0xA0).op(0x20, 0xF9);
+	rom.writeIo(0x4F, 0).op(0x21, 0x00, 0x80).op(0xAF).op(0x22).op(0x7C).op(0xFE, 0xA0).op(0x20, 0xF9);
+	// tiles from 1 on, then OAM: ld hl,src; ld de,dest; ld c,n; ld a,(hl+); ld (de),a;
+	// inc de; dec c; jr nz,<ld a,(hl+)>
+	rom.op(0x21, tiles_pos, tiles_pos >> 8).op(0x11, 0x10, 0x80).op(0x0E, 16 * num_tiles);
+	rom.op(0x2A).op(0x12).op(0x13).op(0x0D).op(0x20, 0xFA);
+	rom.op(0x21, oam_pos, oam_pos >> 8).op(0x11, 0x00, 0xFE).op(0x0E, 0xA0);
+	rom.op(0x2A).op(0x12).op(0x13).op(0x0D).op(0x20, 0xFA);
+	// CGB sprite palettes: ld b,64; ld a,b; cpl; ldh ($6B),a; dec b; jr nz,<ld a,b>
+	rom.writeIo(0x6A, 0x80).op(0x06, 64).op(0x78).op(0x2F).op(0xE0, 0x6B).op(0x05).op(0x20, 0xF9);
+	rom.writeIo(0x47, 0xE4).writeIo(0x48, 0xE4).writeIo(0x49, 0x27);
+	rom.writeIo(0x40, 0x83); // BG and 8x8 sprites on
+	rom.writeIo(0xFF, 0x01); // VBlank only, taken without IME
+	// xor a; ldh ($0F),a; halt; nop; jr <xor a>
+	rom.op(0xAF).op(0xE0, 0x0F).op(0x76).op(0x00).op(0x18, 0xF9);
+	return rom;
+}
+
+// The color number of sprite pixel x of line ly, 0 if transparent or not on it.
+unsigned spritePixel(GB::VideoSnapshot const &s, unsigned const sprite, int const x, int const ly) {
+	unsigned char const *const oam = s.oam + 4 * sprite;
+	int row = ly - (oam[0] - 16), col = x - (oam[1] - 8);
+	if (row < 0 || row > 7 || col < 0 || col > 7)
+		return 0;
+
+	if (oam[3] & 0x40)
+		row = 7 - row;
+	if (oam[3] & 0x20)
+		col = 7 - col;
+
+	unsigned char const *const line = s.vram + 16 * oam[2] + 2 * row;
+	return (line[0] >> (7 - col) & 1) | (line[1] >> (7 - col) & 1) << 1;
+}
+
+std::vector<uint_least32_t> expectedFrame(GB::VideoSnapshot const &s) {
+	std::vector<uint_least32_t> frame(160 * 144, s.bgPalette[0]);
+	for (int ly = 0; ly < 144; ++ly) {
+		std::vector<unsigned> shown;
+		for (unsigned i = 0; i < 40 && shown.size() < 10; ++i) {
+			if (static_cast<unsigned>(ly + 16 - s.oam[4 * i]) < 8)
+				shown.push_back(i);
+		}
+
+		for (int x = 0; x < 160; ++x) {
+			int best = -1;
+			for (std::size_t j = 0; j < shown.size(); ++j) {
+				if (!spritePixel(s, shown[j], x, ly))
+					continue;
+
+				// shown is in OAM order, so only a lower X takes over, and only on DMG
+				if (best < 0 || (!s.cgb && s.oam[4 * shown[j] + 1] < s.oam[4 * best + 1]))
+					best = shown[j];
+			}
+
+			if (best >= 0) {
+				unsigned const attrib = s.oam[4 * best + 3];
+				unsigned const palette = s.cgb ? attrib & 7 : attrib >> 4 & 1;
+				frame[ly * 160 + x] = s.spPalette[4 * palette + spritePixel(s, best, x, ly)];
+			}
+		}
+	}
+
+	return frame;
+}
+
+int check(bool const cgb) {
+	GB gb;
+	if (gb.load(rom_file, cgb ? GB::CGB_MODE : 0) != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return 1;
+	}
+
+	// tell the DMG palettes apart
+	for (int i = 0; i < 12; ++i)
+		gb.setDmgPaletteColor(i / 4, i % 4, 0x102030ul * (i + 1));
+
+	std::vector<uint_least32_t> video(160 * 144);
+	std::vector<uint_least32_t> audio(samples_per_frame + 2064);
+	for (int frames = 0; frames < 10;) {
+		std::size_t samples = samples_per_frame;
+		frames += gb.runFor(&video[0], 160, &audio[0], samples) >= 0;
+	}
+
+	GB::VideoSnapshot snapshot;
+	gb.getVideoSnapshot(snapshot);
+	std::vector<uint_least32_t> const expected = expectedFrame(snapshot);
+	int failures = 0;
+	for (std::size_t i = 0; i < video.size(); ++i)
+		failures += video[i] != expected[i];
+
+	if (failures)
+		std::printf("%s: %d pixels differ from the reference\n", cgb ? "cgb" : "dmg", failures);
+
+	return failures;
+}
+
+} // anon namespace
+
+int main() {
+	if (!makeRom().save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	int const failures = check(false) + check(true);
+	std::remove(rom_file);
+	if (failures)
+		return EXIT_FAILURE;
+
+	std::printf("sprite priority: dmg and cgb frames agree with the reference\n");
+	return EXIT_SUCCESS;
+}
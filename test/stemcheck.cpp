@@ -0,0 +1,209 @@
+// Checks the per-channel stems of GB::setAudioStems. A ROM plays all four channels and
+// writes the sound registers, panning included, in a tight loop, on GBs run side by side.
+// The mixed runFor samples must be the same with stems off, on, and turned on and off
+// between runFor calls. The stems must be the same with the NO_SOUND speedup flag, and
+// decimated stems must be the means of the full rate stems, rounded down to the 16-bit
+// stem format.
+//
+// usage: stemcheck
+
+#include "gambatte.h"
+#include "testrom.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "stemcheck.gbc";
+std::size_t const samples_per_frame = 35112;
+int const num_channels = 4;
+int const num_frames = 120;
+// neither divides samples_per_frame, so their blocks go across runFor calls
+unsigned const decimations[] = { 13, 4096 };
+int const num_decimations = sizeof decimations / sizeof *decimations;
+
+TestRom makeRom() {
+	TestRom rom;
+	rom.writeIo(0x26, 0x80).writeIo(0x24, 0x77);
+	// wave RAM: ld hl,$FF30; ld a,l; swap a; xor l; ld (hl+),a; ld a,l; cp $40; jr nz,<ld a,l>
+	rom.op(0x21, 0x30, 0xFF).op(0x7D).op(0xCB, 0x37).op(0xAD).op(0x22).op(0x7D).op(0xFE, 0x40).op(0x20, 0xF6);
+	rom.writeIo(0x11, 0x80).writeIo(0x12, 0xF3).writeIo(0x14, 0x86);
+	rom.writeIo(0x16, 0x40).writeIo(0x17, 0xA0).writeIo(0x19, 0x87);
+	rom.writeIo(0x1A, 0x80).writeIo(0x1C, 0x20).writeIo(0x1E, 0x85);
+	rom.writeIo(0x21, 0xF1).writeIo(0x22, 0x34).writeIo(0x23, 0x80);
+	rom.writeIo(0x40, 0x91);
+	// ld hl,$FF3F; then forever: inc b; ld a,b; ldh ($13),a; swap a; ldh ($1D),a;
+	// ldh ($25),a; ld (hl),a; and 7; or $20; ldh ($22),a; ld c,b; dec c; jr nz,<dec c>
+	rom.op(0x21, 0x3F, 0xFF);
+	std::size_t const loop = rom.pos();
+	rom.op(0x04).op(0x78).op(0xE0, 0x13).op(0xCB, 0x37).op(0xE0, 0x1D).op(0xE0, 0x25);
+	rom.op(0x77).op(0xE6, 7).op(0xF6, 0x20).op(0xE0, 0x22);
+	rom.op(0x48).op(0x0D).op(0x20, 0xFD);
+	rom.op(0xC3, loop, loop >> 8); // jp loop
+	return rom;
+}
+
+// A GB with its mixed samples and stems so far.
+struct Run {
+	GB gb;
+	std::vector<uint_least16_t> buf[num_channels];
+	std::vector<uint_least32_t> audio;
+	std::vector<uint_least16_t> stems[num_channels];
+	bool stemsOn;
+
+	Run() : stemsOn(false) {}
+};
+
+bool load(Run &run) {
+	if (run.gb.load(rom_file, GB::CGB_MODE) != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return false;
+	}
+
+	return true;
+}
+
+// Turns stems on with decimation, or off with 0.
+void setStems(Run &run, unsigned const decimation) {
+	run.stemsOn = decimation;
+	if (!decimation) {
+		run.gb.setAudioStems(0);
+		return;
+	}
+
+	uint_least16_t *stems[num_channels];
+	for (int ch = 0; ch < num_channels; ++ch) {
+		run.buf[ch].resize((samples_per_frame + 2064) / decimation + 1);
+		stems[ch] = &run.buf[ch][0];
+	}
+
+	run.gb.setAudioStems(stems, decimation);
+}
+
+// Runs a frame's worth of samples, adding the samples and stems it gives to those of run.
+void runFrame(Run &run) {
+	std::size_t const pos = run.audio.size();
+	std::size_t samples = samples_per_frame;
+	run.audio.resize(pos + samples_per_frame + 2064);
+	run.gb.runFor(0, 160, &run.audio[pos], samples);
+	run.audio.resize(pos + samples);
+
+	if (run.stemsOn) {
+		std::size_t const n = run.gb.audioStemSamples();
+		for (int ch = 0; ch < num_channels; ++ch)
+			run.stems[ch].insert(run.stems[ch].end(), run.buf[ch].begin(), run.buf[ch].begin() + n);
+	}
+}
+
+// signed value of a stem sample
+long stemValue(uint_least16_t const sample) {
+	return static_cast<long>(sample & 0xFFFF) - (sample & 0x8000) * 2l;
+}
+
+// The number of samples of decimated that are not the means of every decimation
+// samples of full, plus the number of samples missing at either end.
+std::size_t countMeansDiffering(std::vector<uint_least16_t> const &full,
+                                std::vector<uint_least16_t> const &decimated,
+                                unsigned const decimation) {
+	std::size_t const n = full.size() / decimation;
+	std::size_t differ = n > decimated.size() ? n - decimated.size() : decimated.size() - n;
+	for (std::size_t i = 0; i < n && i < decimated.size(); ++i) {
+		long sum = 0;
+		for (unsigned k = 0; k < decimation; ++k)
+			sum += stemValue(full[i * decimation + k]) / 0x800;
+
+		// the mean of levels -15 to 15, times 0x800, rounded down
+		long const mean = (sum + 15l * decimation) * 0x800 / decimation - 15 * 0x800;
+		differ += stemValue(decimated[i]) != mean;
+	}
+
+	return differ;
+}
+
+} // anon namespace
+
+int main() {
+	if (!makeRom().save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	Run plain, full, quiet, toggled, decimated[num_decimations];
+	bool loaded = load(plain) && load(full) && load(quiet) && load(toggled);
+	for (int i = 0; i < num_decimations; ++i)
+		loaded = loaded && load(decimated[i]);
+
+	std::remove(rom_file);
+	if (!loaded)
+		return EXIT_FAILURE;
+
+	setStems(full, 1);
+	quiet.gb.setSpeedupFlags(GB::NO_SOUND);
+	setStems(quiet, 1);
+	for (int i = 0; i < num_decimations; ++i)
+		setStems(decimated[i], decimations[i]);
+
+	for (int frame = 0; frame < num_frames; ++frame) {
+		// on and off again, also from one decimation to another
+		if (frame % 20 == 10)
+			setStems(toggled, frame % 40 == 10 ? 3 : frame % 60 == 30 ? 0 : 1);
+
+		runFrame(plain);
+		runFrame(full);
+		runFrame(quiet);
+		runFrame(toggled);
+		for (int i = 0; i < num_decimations; ++i)
+			runFrame(decimated[i]);
+	}
+
+	int failures = 0;
+	Run const *const mixed[] = { &full, &toggled, &decimated[0], &decimated[1] };
+	char const *const mixedNames[] = { "full rate stems", "stems toggled", "stems decimated", "stems decimated" };
+	for (std::size_t i = 0; i < sizeof mixed / sizeof *mixed; ++i) {
+		if (mixed[i]->audio != plain.audio) {
+			std::printf("the mixed samples differ with %s\n", mixedNames[i]);
+			++failures;
+		}
+	}
+
+	for (int ch = 0; ch < num_channels; ++ch) {
+		if (full.stems[ch].size() != plain.audio.size()) {
+			std::printf("channel %d has %d full rate stem samples for %d samples\n", ch + 1,
+			            static_cast<int>(full.stems[ch].size()), static_cast<int>(plain.audio.size()));
+			++failures;
+		}
+
+		std::size_t changes = 0;
+		for (std::size_t i = 1; i < full.stems[ch].size(); ++i)
+			changes += full.stems[ch][i] != full.stems[ch][i - 1];
+
+		if (!changes) {
+			std::printf("channel %d stem does not change\n", ch + 1);
+			++failures;
+		}
+
+		if (quiet.stems[ch] != full.stems[ch]) {
+			std::printf("channel %d stem differs with NO_SOUND\n", ch + 1);
+			++failures;
+		}
+
+		for (int i = 0; i < num_decimations; ++i) {
+			if (std::size_t const differ =
+					countMeansDiffering(full.stems[ch], decimated[i].stems[ch], decimations[i])) {
+				std::printf("%d channel %d stem samples decimated by %u differ from the means\n",
+				            static_cast<int>(differ), ch + 1, decimations[i]);
+				++failures;
+			}
+		}
+	}
+
+	if (failures)
+		return EXIT_FAILURE;
+
+	std::printf("stems: %d samples agree, decimated by 1, %u and %u\n",
+	            static_cast<int>(plain.audio.size()), decimations[0], decimations[1]);
+	return EXIT_SUCCESS;
+}
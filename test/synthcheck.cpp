@@ -0,0 +1,274 @@
+// Checks the band-limited sound of GB::setAudioOutputRate against the runFor audio buffer.
+// A ROM plays all four channels, changing notes, noise and panning every frame, on two
+// GBs, one of them with its sound synthesized at 48 kHz. The runFor samples of the other,
+// put through the impulse of the synth (BandLimitedSynth::impulse) in double precision
+// at their exact times, must then come out as the synthesized samples, but for rounding
+// and the phases of the kernel. Samples not read must be dropped, oldest first, past
+// BandLimitedSynth::max_samples.
+//
+// The filter itself is measured as in resamplerbench: the SNR of a 1 kHz tone, what is
+// left of the output once the tone is fitted away, and the aliasing, how far below the
+// 1 kHz tone one as loud at the output rate less 1 kHz comes out, at 1 kHz.
+//
+// usage: synthcheck
+
+#include "gambatte.h"
+#include "sound/band_limited_synth.h"
+#include "testrom.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "synthcheck.gbc";
+std::size_t const samples_per_frame = 35112;
+long const out_rate = 48000;
+double const psg_rate = BandLimitedSynth::psg_rate;
+double const pi = 3.14159265358979323846;
+// lowest SNR against the reference, and of the tone, and the least aliasing attenuation
+double const min_snr = 80, min_tone_snr = 85, min_alias = 70;
+
+TestRom makeRom() {
+	TestRom rom;
+	rom.writeIo(0x26, 0x80).writeIo(0x24, 0x55);
+	// wave RAM: ld hl,$FF30; ld a,l; swap a; xor l; ld (hl+),a; ld a,l; cp $40; jr nz,<ld a,l>
+	rom.op(0x21, 0x30, 0xFF).op(0x7D).op(0xCB, 0x37).op(0xAD).op(0x22).op(0x7D).op(0xFE, 0x40).op(0x20, 0xF6);
+	rom.writeIo(0x11, 0x80).writeIo(0x12, 0xF3).writeIo(0x14, 0x86);
+	rom.writeIo(0x16, 0x40).writeIo(0x17, 0xA0).writeIo(0x19, 0x87);
+	rom.writeIo(0x1A, 0x80).writeIo(0x1C, 0x20).writeIo(0x1E, 0x85);
+	rom.writeIo(0x21, 0xF1).writeIo(0x22, 0x34).writeIo(0x23, 0x80);
+	rom.writeIo(0x40, 0x91);
+	std::size_t const loop = rom.pos();
+	// every frame: inc b; ld a,b; add a,a; add a,b; ldh ($13),a; add a,a; ldh ($18),a;
+	// add a,b; ldh ($1D),a; ld a,b; ldh ($25),a; and 7; or $20; ldh ($22),a; ld a,$87;
+	// ldh ($14),a
+	rom.waitIo(0x44, 144);
+	rom.op(0x04).op(0x78).op(0x87).op(0x80).op(0xE0, 0x13).op(0x87).op(0xE0, 0x18);
+	rom.op(0x80).op(0xE0, 0x1D).op(0x78).op(0xE0, 0x25).op(0xE6, 7).op(0xF6, 0x20).op(0xE0, 0x22);
+	rom.writeIo(0x14, 0x87);
+	rom.waitIo(0x44, 0);
+	rom.op(0xC3, loop, loop >> 8); // jp loop
+	return rom;
+}
+
+// signed value of half h (0 low, 1 high) of a sample
+long half(uint_least32_t const sample, int const h) {
+	long const v = sample >> 16 * h & 0xFFFF;
+	return v - (v & 0x8000) * 2;
+}
+
+// Output samples 0 to n - 1 of half h of the PSG samples in, with a band-limited step
+// for each change at the exact time of the PSG sample, from the impulse of the synth
+// normalized to 1 like its kernel.
+std::vector<double> reference(std::vector<uint_least32_t> const &in, int const h, std::size_t const n) {
+	int const len = 2 * BandLimitedSynth::delay;
+	std::vector<double> out(n + len + 1), settled(n + len + 1);
+	long prev = 0;
+	for (std::size_t k = 0; k < in.size(); ++k) {
+		long const v = half(in[k], h);
+		if (v == prev)
+			continue;
+
+		double const d = v - prev;
+		double const u = k * (out_rate / psg_rate);
+		std::size_t const at = static_cast<std::size_t>(u) + 1;
+		if (at >= n)
+			break;
+
+		double taps[len], sum = 0;
+		for (int t = 0; t < len; ++t)
+			sum += taps[t] = BandLimitedSynth::impulse(at + t - BandLimitedSynth::delay - u);
+
+		double level = 0;
+		for (int t = 0; t < len; ++t) {
+			level += taps[t] / sum;
+			out[at + t] += d * level;
+		}
+
+		settled[at + len] += d;
+		prev = v;
+	}
+
+	double level = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		level += settled[i];
+		out[i] += level;
+	}
+
+	out.resize(n);
+	return out;
+}
+
+double dB(double const ratio) {
+	return 20 * std::log10(ratio);
+}
+
+// The SNR of samples, starting at output sample first, against the reference.
+double snr(std::vector<uint_least32_t> const &samples, std::size_t const first,
+           std::vector<double> const (&ref)[2]) {
+	double signal = 0, noise = 0;
+	for (std::size_t i = 0; i < samples.size(); ++i) {
+		for (int h = 0; h < 2; ++h) {
+			double const r = ref[h][first + i];
+			double const e = half(samples[i], h) - r;
+			signal += r * r;
+			noise += e * e;
+		}
+	}
+
+	return noise ? 10 * std::log10(signal / noise) : 999;
+}
+
+int checkAgainstRunFor() {
+	if (!makeRom().save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return 1;
+	}
+
+	GB gb, synthGb;
+	LoadRes const loadres = gb.load(rom_file, GB::CGB_MODE);
+	LoadRes const synthLoadres = synthGb.load(rom_file, GB::CGB_MODE);
+	std::remove(rom_file);
+	if (loadres != LOADRES_OK || synthLoadres != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return 1;
+	}
+
+	synthGb.setAudioOutputRate(out_rate);
+
+	// 60 frames read as they come, then 40 not read, which is more than the synth keeps
+	std::vector<uint_least32_t> audio(samples_per_frame + 2064), psgSamples, read;
+	for (int frame = 0; frame < 100; ++frame) {
+		std::size_t samples = samples_per_frame, synthSamples = samples_per_frame;
+		gb.runFor(0, 160, &audio[0], samples);
+		synthGb.runFor(0, 160, 0, synthSamples);
+		if (samples != synthSamples) {
+			std::printf("runFor ran for %d samples with the synth and %d without\n",
+			            static_cast<int>(synthSamples), static_cast<int>(samples));
+			return 1;
+		}
+
+		psgSamples.insert(psgSamples.end(), audio.begin(), audio.begin() + samples);
+		if (frame < 60) {
+			std::size_t const pos = read.size();
+			read.resize(pos + BandLimitedSynth::max_samples);
+			read.resize(pos + synthGb.readAudio(&read[pos], BandLimitedSynth::max_samples));
+		}
+	}
+
+	std::vector<uint_least32_t> kept(BandLimitedSynth::max_samples + 1);
+	kept.resize(synthGb.readAudio(&kept[0], kept.size()));
+
+	std::size_t const total = static_cast<std::size_t>(psgSamples.size() * (out_rate / psg_rate));
+	int failures = 0;
+	if (kept.size() != BandLimitedSynth::max_samples || read.size() + kept.size() > total) {
+		std::printf("%d samples read and %d kept of %d\n", static_cast<int>(read.size()),
+		            static_cast<int>(kept.size()), static_cast<int>(total));
+		return 1;
+	}
+
+	std::vector<double> const ref[2] = {
+		reference(psgSamples, 0, total),
+		reference(psgSamples, 1, total)
+	};
+	double const readSnr = snr(read, 0, ref);
+	double const keptSnr = snr(kept, total - kept.size(), ref);
+	std::printf("%ld Hz: SNR against the runFor samples %.1f dB, %.1f dB for the samples kept\n",
+	            out_rate, readSnr, keptSnr);
+	if (readSnr < min_snr || keptSnr < min_snr) {
+		std::printf("the synthesized samples differ from the runFor samples\n");
+		++failures;
+	}
+
+	return failures;
+}
+
+// Synthesizes a tone of amplitude 16384 at freq, given at the PSG rate, for seconds.
+std::vector<short> synthTone(double const freq, double const seconds) {
+	BandLimitedSynth synth;
+	synth.setRate(out_rate, 0x8000);
+
+	std::size_t const len = static_cast<std::size_t>(seconds * psg_rate);
+	std::vector<uint_least32_t> buf(BandLimitedSynth::max_steps_len);
+	std::vector<short> out;
+	unsigned long prev = 0;
+	for (std::size_t pos = 0; pos < len; pos += BandLimitedSynth::max_steps_len) {
+		std::size_t const n = std::min<std::size_t>(BandLimitedSynth::max_steps_len, len - pos);
+		for (std::size_t i = 0; i < n; ++i) {
+			long const v = static_cast<long>(std::floor(16384 * std::sin(2 * pi * freq * (pos + i) / psg_rate) + 0.5));
+			unsigned long const level = static_cast<unsigned long>(v) * 0x10001;
+			synth.addStep(i, level - prev);
+			prev = level;
+		}
+
+		synth.advance(n);
+		std::size_t const got = synth.read(&buf[0], buf.size());
+		for (std::size_t i = 0; i < got; ++i)
+			out.push_back(static_cast<short>(half(buf[i], 0)));
+	}
+
+	return out;
+}
+
+// Fits a * sin + b * cos + c at freq to out past skip seconds by least squares. Returns
+// the amplitude of the fit, and the RMS of what is left in residual.
+double fitTone(std::vector<short> const &out, double const freq, double const skip, double &residual) {
+	std::size_t const begin = static_cast<std::size_t>(skip * out_rate);
+	double m[3][4] = { { 0 } };
+	for (std::size_t i = begin; i < out.size(); ++i) {
+		double const w = 2 * pi * freq * i / out_rate;
+		double const v[4] = { std::sin(w), std::cos(w), 1, static_cast<double>(out[i]) };
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 4; ++c)
+				m[r][c] += v[r] * v[c];
+		}
+	}
+
+	for (int p = 0; p < 3; ++p) {
+		for (int r = 0; r < 3; ++r) {
+			if (r != p) {
+				double const f = m[r][p] / m[p][p];
+				for (int c = 0; c < 4; ++c)
+					m[r][c] -= f * m[p][c];
+			}
+		}
+	}
+
+	double const a = m[0][3] / m[0][0], b = m[1][3] / m[1][1], c = m[2][3] / m[2][2];
+	double sum = 0;
+	for (std::size_t i = begin; i < out.size(); ++i) {
+		double const w = 2 * pi * freq * i / out_rate;
+		double const e = out[i] - (a * std::sin(w) + b * std::cos(w) + c);
+		sum += e * e;
+	}
+
+	residual = std::sqrt(sum / (out.size() - begin));
+	return std::sqrt(a * a + b * b);
+}
+
+int checkFilter() {
+	double residual = 0, aliasResidual = 0;
+	double const amplitude = fitTone(synthTone(1000, 0.5), 1000, 0.1, residual);
+	double const alias = fitTone(synthTone(out_rate - 1000, 0.5), 1000, 0.1, aliasResidual);
+	double const toneSnr = dB(amplitude / std::sqrt(2.0) / residual);
+	double const aliasDb = alias ? dB(amplitude / alias) : 999;
+	std::printf("%ld Hz: 1 kHz tone SNR %.1f dB, aliasing %.1f dB\n", out_rate, toneSnr, aliasDb);
+	if (toneSnr < min_tone_snr || aliasDb < min_alias) {
+		std::printf("the synth is not band-limited enough\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+} // anon namespace
+
+int main() {
+	int const failures = checkAgainstRunFor() + checkFilter();
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+// Builds the small ROM only cartridges that the checks in this directory run. Without a
+// boot ROM loaded, the CPU starts at 0 with the boot ROM still mapped (see GB::loadBios),
+// so the code starts there, by leaving it like the CGB boot ROM does. The ROM is 32 KiB,
+// code and whatever data the check puts in it.
+
+#ifndef TESTROM_H
+#define TESTROM_H
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+class TestRom {
+public:
+	enum { size = 0x8000 };
+
+	TestRom() : data_(size), pos_(0) {
+		writeIo(0x4C, 0x80); // KEY0, CGB mode
+		writeIo(0x50, 0x11); // boot ROM off
+	}
+
+	std::size_t pos() const { return pos_; }
+	unsigned char & operator[](std::size_t i) { return data_[i]; }
+	unsigned char operator[](std::size_t i) const { return data_[i]; }
+
+	TestRom & op(unsigned b0) {
+		data_[pos_++] = b0;
+		return *this;
+	}
+
+	TestRom & op(unsigned b0, unsigned b1) { return op(b0).op(b1 & 0xFF); }
+	TestRom & op(unsigned b0, unsigned b1, unsigned b2) { return op(b0, b1).op(b2 & 0xFF); }
+
+	// ld a,value; ldh (reg),a
+	TestRom & writeIo(unsigned reg, unsigned value) { return op(0x3E, value).op(0xE0, reg); }
+
+	// ldh a,(reg); ldh (dest),a
+	TestRom & copyIo(unsigned dest, unsigned reg) { return op(0xF0, reg).op(0xE0, dest); }
+
+	// ldh a,(reg); cp value; jr nz,<back to ldh>
+	TestRom & waitIo(unsigned reg, unsigned value) { return op(0xF0, reg).op(0xFE, value).op(0x20, 0xFA); }
+
+	// ld a,value; ldh ($FE),a; jr <itself>, for the check to see that it got this far
+	TestRom & finish(unsigned value) { return writeIo(0xFE, value).op(0x18, 0xFE); }
+
+	bool save(char const *path) const {
+		std::FILE *const file = std::fopen(path, "wb");
+		if (!file)
+			return false;
+
+		bool const ok = std::fwrite(&data_[0], size, 1, file) == 1;
+		return std::fclose(file) == 0 && ok;
+	}
+
+private:
+	std::vector<unsigned char> data_;
+	std::size_t pos_;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "gambatte.h"
+#include "scoped_ptr.h"
 #include "transfer_ptr.h"
 #include <png.h>
 #include <algorithm>
@@ -19,6 +20,26 @@ std::size_t const samples_per_frame = 35112;
 std::size_t const audiobuf_size = samples_per_frame + 2064;
 std::size_t const framebuf_size = gb_width * gb_height;
 
+// Other ways of getting the video frames out, which the frames they give are compared
+// against those of runFor (see runModeTest).
+enum VideoMode {
+	video_runfor,
+	video_indexed8, // INDEXED8 expanded with getIndexedPalette, the last frame exactly
+	video_deferred, // DEFER_VIDEO, with renderLastFrame after each frame
+	video_threaded  // THREADED_VIDEO, each frame a frame later, run for one more at the end
+};
+
+struct VideoModeName {
+	char const *option;
+	VideoMode mode;
+};
+
+VideoModeName const video_mode_names[] = {
+	{ "--indexed8", video_indexed8 },
+	{ "--deferred", video_deferred },
+	{ "--threaded", video_threaded }
+};
+
 static void readPng(gambatte::uint_least32_t out[], std::FILE &file) {
 	struct PngContext {
 		png_structp png;
@@ -272,13 +293,8 @@ static bool evaluateStrTestResults(
 	return false;
 }
 
-static void runTestRom(
-		gambatte::uint_least32_t framebuf[],
-		gambatte::uint_least32_t audiobuf[],
-		std::string const &file,
-		bool const cgb) {
-	gambatte::GB gb;
-
+static void loadTestRom(gambatte::GB &gb, std::string const &file, bool const cgb,
+		VideoMode const mode) {
 	if (cgb) {
 		if (gb.loadBios("bios.gbc", 0x900, 0x31672598)) {
 			std::fprintf(stderr, "Failed to load bios image file bios.gbc\n");
@@ -303,16 +319,48 @@ static void runTestRom(
 
 	gb.setTrueColors(false);
 
+	if (mode == video_indexed8)
+		gb.setVideoFormat(gambatte::GB::INDEXED8);
+	if (mode == video_deferred)
+		gb.setSpeedupFlags(gambatte::GB::DEFER_VIDEO);
+	if (mode == video_threaded)
+		gb.setSpeedupFlags(gambatte::GB::THREADED_VIDEO);
+}
+
+static long testRomSamples(bool const cgb) {
+	return samples_per_frame * ((cgb ? 186 : 334) + 15);
+}
+
+static void runTestRom(
+		gambatte::uint_least32_t framebuf[],
+		gambatte::uint_least32_t audiobuf[],
+		std::string const &file,
+		bool const cgb,
+		VideoMode const mode = video_runfor) {
+	gambatte::GB gb;
+	loadTestRom(gb, file, cgb, mode);
+
 	std::putchar(cgb ? 'c' : 'd');
 	std::fflush(stdout);
 
-	long samplesLeft = samples_per_frame * ((cgb ? 186 : 334) + 15);
+	// where runFor draws when framebuf gets its frame some other way
+	gambatte::uint_least32_t modebuf[framebuf_size];
+	gambatte::uint_least32_t *const videobuf = mode == video_indexed8 ? modebuf : framebuf;
+	long samplesLeft = testRomSamples(cgb);
 
 	while (samplesLeft >= 0) {
 		std::size_t samples = samples_per_frame;
-		gb.runFor(framebuf, gb_width, audiobuf, samples);
+		gb.runFor(videobuf, gb_width, audiobuf, samples);
 		samplesLeft -= samples;
 	}
+
+	if (mode == video_indexed8) {
+		gambatte::uint_least32_t palette[gambatte::GB::INDEXED_PALETTE_SIZE];
+		gb.getIndexedPalette(palette);
+		unsigned char const *const indexedbuf = reinterpret_cast<unsigned char *>(modebuf);
+		for (std::size_t i = 0; i < framebuf_size; ++i)
+			framebuf[i] = palette[indexedbuf[i]];
+	}
 }
 
 static bool runStrTest(std::string const &romfile, bool cgb, std::string const &outstr) {
@@ -338,6 +386,112 @@ static bool runPngTest(std::string const &romfile, bool cgb, std::FILE &pngfile)
 	return true;
 }
 
+// Runs a test ROM with runFor and in a video mode that gives frames later side by side,
+// checking every frame: each renderLastFrame frame against the runFor frame just
+// completed, and each THREADED_VIDEO frame against the runFor frame before it.
+class FrameModeTest {
+public:
+	FrameModeTest(std::string const &file, bool const cgb, VideoMode const mode)
+	: mode_(mode)
+	, numFrames_(0)
+	, failedFrame_(-1)
+	{
+		loadTestRom(gb_, file, cgb, video_runfor);
+		loadTestRom(modeGb_, file, cgb, mode);
+		std::fill(framebuf_, framebuf_ + framebuf_size, 0);
+		std::fill(prevbuf_, prevbuf_ + framebuf_size, 0);
+		std::fill(modebuf_, modebuf_ + framebuf_size, 0);
+	}
+
+	// Runs both for a frame's worth of samples. Returns true if a frame was completed.
+	bool step(std::size_t &samples) {
+		std::size_t modeSamples = samples;
+		bool const done = gb_.runFor(framebuf_, gb_width, audiobuf_, samples) >= 0;
+		bool const modeDone = modeGb_.runFor(modebuf_, gb_width, audiobuf_, modeSamples) >= 0;
+		if (done != modeDone || samples != modeSamples)
+			fail();
+
+		if (done) {
+			if (mode_ == video_deferred) {
+				if (!modeGb_.renderLastFrame(renderbuf_, gb_width)
+						|| !frameBufsEqual(framebuf_, renderbuf_)) {
+					fail();
+				}
+			} else if (numFrames_ > 0 && !frameBufsEqual(prevbuf_, modebuf_))
+				fail();
+
+			std::copy(framebuf_, framebuf_ + framebuf_size, prevbuf_);
+			++numFrames_;
+		}
+
+		return done;
+	}
+
+	long failedFrame() const { return failedFrame_; }
+
+private:
+	gambatte::GB gb_;
+	gambatte::GB modeGb_;
+	VideoMode const mode_;
+	long numFrames_;
+	long failedFrame_;
+	gambatte::uint_least32_t audiobuf_[audiobuf_size];
+	gambatte::uint_least32_t framebuf_[framebuf_size];
+	gambatte::uint_least32_t prevbuf_[framebuf_size];
+	gambatte::uint_least32_t modebuf_[framebuf_size];
+	gambatte::uint_least32_t renderbuf_[framebuf_size];
+
+	void fail() {
+		if (failedFrame_ < 0)
+			failedFrame_ = numFrames_;
+	}
+};
+
+static bool runModeTest(std::string const &romfile, bool cgb, VideoMode mode, char const *name) {
+	if (mode == video_indexed8) {
+		gambatte::uint_least32_t audiobuf[audiobuf_size];
+		gambatte::uint_least32_t framebuf[framebuf_size];
+		gambatte::uint_least32_t modebuf[framebuf_size];
+		runTestRom(framebuf, audiobuf, romfile, cgb);
+		runTestRom(modebuf, audiobuf, romfile, cgb, mode);
+
+		// the palette entries must be the RGB32 pixels themselves, alpha included
+		if (!std::equal(framebuf, framebuf + framebuf_size, modebuf)) {
+			std::printf("\nFAILED: %s %s %s\n", romfile.c_str(), cgb ? "cgb" : "dmg", name);
+			return false;
+		}
+
+		return true;
+	}
+
+	scoped_ptr<FrameModeTest> const test(new FrameModeTest(romfile, cgb, mode));
+	std::putchar(cgb ? 'c' : 'd');
+	std::fflush(stdout);
+
+	long samplesLeft = testRomSamples(cgb);
+	while (samplesLeft >= 0) {
+		std::size_t samples = samples_per_frame;
+		test->step(samples);
+		samplesLeft -= samples;
+	}
+
+	// the last frame completed above is put in the buffer at the end of the next one
+	if (mode == video_threaded) {
+		std::size_t samples;
+		do {
+			samples = samples_per_frame;
+		} while (!test->step(samples));
+	}
+
+	if (test->failedFrame() >= 0) {
+		std::printf("\nFAILED: %s %s %s frame %ld\n", romfile.c_str(), cgb ? "cgb" : "dmg",
+		            name, test->failedFrame());
+		return false;
+	}
+
+	return true;
+}
+
 static std::string extensionStripped(std::string const &s) {
 	return s.substr(0, s.rfind('.'));
 }
@@ -348,11 +502,25 @@ static file_ptr openFile(std::string const &filename) {
 
 } // anon ns
 
+// usage: testrunner [--indexed8 | --deferred | --threaded] <test ROMs>
+// With a video mode option, the frames of the test ROMs are checked against plain runFor
+// frames instead of against the expected results, on the models that have expected
+// results.
 int main(int const argc, char *argv[]) {
 	int numTestsRun = 0;
 	int numTestsSucceeded = 0;
+	int firstRom = 1;
+	VideoMode mode = video_runfor;
+	char const *modeName = 0;
+
+	for (std::size_t i = 0; i < sizeof video_mode_names / sizeof *video_mode_names; ++i) {
+		if (argc > 1 && std::strcmp(argv[1], video_mode_names[i].option) == 0) {
+			mode = video_mode_names[i].mode;
+			modeName = argv[firstRom++] + 2;
+		}
+	}
 
-	for (int i = 1; i < argc; ++i) {
+	for (int i = firstRom; i < argc; ++i) {
 		std::string const s = extensionStripped(argv[i]);
 		char const *dmgout = 0;
 		char const *cgbout = 0;
@@ -368,6 +536,21 @@ int main(int const argc, char *argv[]) {
 			} else if (s.find("_out") != std::string::npos)
 				cgbout = "_out";
 		}
+		if (mode != video_runfor) {
+			bool const dmg = dmgout || openFile(s + "_dmg08_cgb04c.png") || openFile(s + "_dmg08.png");
+			bool const cgb = cgbout || openFile(s + "_dmg08_cgb04c.png") || openFile(s + "_cgb04c.png");
+			if (cgb) {
+				numTestsSucceeded += runModeTest(argv[i],  true, mode, modeName);
+				++numTestsRun;
+			}
+			if (dmg) {
+				numTestsSucceeded += runModeTest(argv[i], false, mode, modeName);
+				++numTestsRun;
+			}
+
+			continue;
+		}
+
 		if (cgbout) {
 			numTestsSucceeded += runStrTest(argv[i],  true, cgbout);
 			++numTestsRun;
@@ -0,0 +1,91 @@
+// Times the tile row palette lookup used by the PPU for whole background tiles
+// (writeTileRow, see libgambatte/src/video/tile_row.h) against the portable version,
+// one 160-pixel line at a time, and checks that they write the same pixels.
+// Build with e.g. CXXFLAGS="-O2 -mssse3" or "-O2 -mavx2" to time the SIMD versions.
+//
+// usage: tilerowbench [lines]
+
+#include "video/tile_row.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace {
+
+enum { tiles_per_line = 20, line_len = 8 * tiles_per_line, num_lines = 0x100 };
+
+struct Line {
+	unsigned short tileword[tiles_per_line];
+	unsigned char palno[tiles_per_line];
+};
+
+typedef void (*WriteTileRow)(uint_least32_t *dst, unsigned tileword, unsigned long const *palette);
+
+template<WriteTileRow write>
+static void renderLine(uint_least32_t *const dst, Line const &line, unsigned long const *const palettes) {
+	for (int i = 0; i < tiles_per_line; ++i)
+		write(dst + 8 * i, line.tileword[i], palettes + 4 * line.palno[i]);
+}
+
+template<WriteTileRow write>
+static double nsPerLine(std::vector<Line> const &lines, unsigned long const *const palettes,
+		long const n, uint_least32_t *const dst) {
+	std::clock_t const start = std::clock();
+	for (long i = 0; i < n; ++i)
+		renderLine<write>(dst + (i & 1) * line_len, lines[i % num_lines], palettes);
+
+	return (std::clock() - start) * 1.0e9 / CLOCKS_PER_SEC / n;
+}
+
+} // anon namespace
+
+int main(int const argc, char *argv[]) {
+	long const n = argc > 1 ? std::atol(argv[1]) : 10000000;
+	if (n <= 0) {
+		std::printf("usage: %s [lines]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::srand(1);
+	unsigned long palettes[8 * 4];
+	for (int i = 0; i < 8 * 4; ++i)
+		palettes[i] = (std::rand() & 0xffff) * 0x100ul + (std::rand() & 0xff);
+
+	std::vector<Line> lines(num_lines);
+	for (int l = 0; l < num_lines; ++l) {
+		for (int i = 0; i < tiles_per_line; ++i) {
+			lines[l].tileword[i] = std::rand() & 0xffff;
+			lines[l].palno[i] = l & 1 ? std::rand() & 7 : 0;
+		}
+	}
+
+	std::vector<uint_least32_t> ref(line_len), out(line_len);
+	for (int l = 0; l < num_lines; ++l) {
+		renderLine<gambatte::writeTileRowPortable>(&ref[0], lines[l], palettes);
+		renderLine<gambatte::writeTileRow>(&out[0], lines[l], palettes);
+		if (ref != out) {
+			std::printf("mismatch at line %d\n", l);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<uint_least32_t> buf(2 * line_len);
+	double const portable = nsPerLine<gambatte::writeTileRowPortable>(lines, palettes, n, &buf[0]);
+	double const selected = nsPerLine<gambatte::writeTileRow>(lines, palettes, n, &buf[0]);
+	std::printf("%s: portable %.2f ns/line, writeTileRow %.2f ns/line\n",
+#if defined GAMBATTE_TILE_ROW_AVX2
+	            "avx2",
+#elif defined GAMBATTE_TILE_ROW_SSSE3
+	            "ssse3",
+#else
+	            "no simd",
+#endif
+	            portable, selected);
+
+	// keep the stores from being optimized out
+	uint_least32_t volatile const result = buf[n & 1 ? 0 : line_len];
+	(void)result;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,198 @@
+// Checks the VRAM viewers (GB::getVideoSnapshot, drawTileMap, drawSprites and
+// drawTileSheet) against the frames the PPU draws. A ROM fills both VRAM banks, the
+// palettes and a few sprites with patterns, tile map attributes included, and scrolls
+// the background so that the screen wraps around the map. The BG map drawn from the
+// snapshot, moved by the scroll registers and with the sprites drawn by drawSprites on
+// top, must then be the frame. The tile sheet is checked pixel by pixel against the tile
+// data, and the screen outline of drawTileMap against the scroll registers.
+//
+// usage: vramviewercheck
+
+#include "gambatte.h"
+#include "testrom.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gambatte;
+
+namespace {
+
+char const rom_file[] = "vramviewercheck.gbc";
+std::size_t const samples_per_frame = 35112;
+unsigned const scx = 0x63, scy = 0x9A;
+
+struct Sprite {
+	unsigned char y, x, tile, attrib;
+};
+
+// x and y flips, the second VRAM bank and a few palettes, none of them overlapping
+Sprite const sprites[] = {
+	{  30,  20, 0x12, 0x00 },
+	{  50,  60, 0x35, 0x2B },
+	{  90, 100, 0x80, 0x45 },
+	{ 140, 150, 0xFE, 0x6E },
+};
+
+std::size_t const num_sprites = sizeof sprites / sizeof *sprites;
+
+TestRom makeRom() {
+	TestRom rom;
+	rom.writeIo(0x40, 0x00); // LCD off
+	// VRAM bank 1: ld hl,$8000; ld a,l; rlca; xor h; ld (hl+),a; ld a,h; cp $9C;
+	// jr nz,<ld a,l>
+	rom.writeIo(0x4F, 1).op(0x21, 0x00, 0x80).op(0x7D).op(0x07).op(0xAC).op(0x22).op(0x7C).op(0xFE, 0x9C).op(0x20, 0xF7);
+	// no BG priority in the map attributes: ld hl,$9800; res 7,(hl); inc hl; ld a,h;
+	// cp $9C; jr nz,<res>
+	rom.op(0x21, 0x00, 0x98).op(0xCB, 0xBE).op(0x23).op(0x7C).op(0xFE, 0x9C).op(0x20, 0xF8);
+	// VRAM bank 0: ld hl,$8000; ld a,l; xor h; ld (hl+),a; ld a,h; cp $9C; jr nz,<ld a,l>
+	rom.writeIo(0x4F, 0).op(0x21, 0x00, 0x80).op(0x7D).op(0xAC).op(0x22).op(0x7C).op(0xFE, 0x9C).op(0x20, 0xF8);
+	// BG palettes: ld b,64; ld a,b; rlca; xor b; ldh ($69),a; dec b; jr nz,<ld a,b>
+	rom.writeIo(0x68, 0x80).op(0x06, 64).op(0x78).op(0x07).op(0xA8).op(0xE0, 0x69).op(0x05).op(0x20, 0xF8);
+	// sprite palettes: ld b,64; ld a,b; cpl; ldh ($6B),a; dec b; jr nz,<ld a,b>
+	rom.writeIo(0x6A, 0x80).op(0x06, 64).op(0x78).op(0x2F).op(0xE0, 0x6B).op(0x05).op(0x20, 0xF9);
+	// OAM: ld hl,$FE00; xor a; ld (hl+),a; ld a,l; cp $A0; jr nz,<xor a>
+	rom.op(0x21, 0x00, 0xFE).op(0xAF).op(0x22).op(0x7D).op(0xFE, 0xA0).op(0x20, 0xF9);
+	rom.op(0x21, 0x00, 0xFE);
+	for (std::size_t i = 0; i < num_sprites; ++i) {
+		// ld (hl),n; inc l
+		rom.op(0x36, sprites[i].y).op(0x2C).op(0x36, sprites[i].x).op(0x2C);
+		rom.op(0x36, sprites[i].tile).op(0x2C).op(0x36, sprites[i].attrib).op(0x2C);
+	}
+
+	rom.writeIo(0x43, scx).writeIo(0x42, scy);
+	rom.writeIo(0x40, 0x97); // tile data at $8000, 8x16 sprites
+	rom.writeIo(0xFF, 0x01); // VBlank only, taken without IME
+	// xor a; ldh ($0F),a; halt; nop; jr <xor a>
+	rom.op(0xAF).op(0xE0, 0x0F).op(0x76).op(0x00).op(0x18, 0xF9);
+	return rom;
+}
+
+// the frame as the BG map moved by the scroll registers, with the sprites on top
+std::vector<uint_least32_t> expectedFrame(GB::VideoSnapshot const &s) {
+	std::vector<uint_least32_t> map(256 * 256);
+	GB::drawTileMap(s, &map[0], 256, 0, false);
+
+	// sprite pixels are those drawn over both fills
+	std::vector<uint_least32_t> spr0(64 * 80, 0), spr1(64 * 80, 0xFFFFFFFF);
+	GB::drawSprites(s, &spr0[0], 64);
+	GB::drawSprites(s, &spr1[0], 64);
+
+	std::vector<uint_least32_t> frame(160 * 144);
+	for (unsigned y = 0; y < 144; ++y) {
+		for (unsigned x = 0; x < 160; ++x)
+			frame[y * 160 + x] = map[((y + s.scy) & 0xFF) * 256 + ((x + s.scx) & 0xFF)];
+	}
+
+	for (std::size_t i = 0; i < num_sprites; ++i) {
+		std::size_t const cell = (i / 8 * 16) * 64 + i % 8 * 8;
+		for (int y = 0; y < 16; ++y) {
+			for (int x = 0; x < 8; ++x) {
+				std::size_t const p = cell + y * 64 + x;
+				if (spr0[p] == spr1[p])
+					frame[(sprites[i].y - 16 + y) * 160 + sprites[i].x - 8 + x] = spr0[p];
+			}
+		}
+	}
+
+	return frame;
+}
+
+int checkTileSheet(GB::VideoSnapshot const &s) {
+	int failures = 0;
+	std::vector<uint_least32_t> sheet(128 * 192);
+	for (unsigned bank = 0; bank < 2; ++bank) {
+		for (unsigned palette = 0; palette < 16; palette += 5) {
+			GB::drawTileSheet(s, &sheet[0], 128, bank, palette);
+			uint_least32_t const *const pal = palette < 8
+				? s.bgPalette + palette * 4
+				: s.spPalette + (palette - 8) * 4;
+			for (unsigned y = 0; y < 192; ++y) {
+				for (unsigned x = 0; x < 128; ++x) {
+					unsigned char const *const line =
+						s.vram + bank * 0x2000 + (y / 8 * 16 + x / 8) * 16 + y % 8 * 2;
+					unsigned const color = (line[0] >> (7 - x % 8) & 1) | (line[1] >> (7 - x % 8) & 1) << 1;
+					failures += sheet[y * 128 + x] != pal[color];
+				}
+			}
+		}
+	}
+
+	if (failures)
+		std::printf("%d tile sheet pixels differ from the tile data\n", failures);
+
+	return failures;
+}
+
+int checkOutline(GB::VideoSnapshot const &s) {
+	std::vector<uint_least32_t> plain(256 * 256), outlined(256 * 256);
+	GB::drawTileMap(s, &plain[0], 256, 0, false);
+	GB::drawTileMap(s, &outlined[0], 256, 0, true);
+
+	int failures = 0;
+	for (unsigned y = 0; y < 256; ++y) {
+		for (unsigned x = 0; x < 256; ++x) {
+			unsigned const sx = (x - s.scx) & 0xFF, sy = (y - s.scy) & 0xFF;
+			bool const border = sx < 160 && sy < 144 && (sx == 0 || sx == 159 || sy == 0 || sy == 143);
+			uint_least32_t const expected = border ? plain[y * 256 + x] ^ 0xFFFFFF : plain[y * 256 + x];
+			failures += outlined[y * 256 + x] != expected;
+		}
+	}
+
+	if (failures)
+		std::printf("%d map pixels differ from the screen outline\n", failures);
+
+	return failures;
+}
+
+} // anon namespace
+
+int main() {
+	if (!makeRom().save(rom_file)) {
+		std::printf("failed to write %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	GB gb;
+	LoadRes const loadres = gb.load(rom_file, GB::CGB_MODE);
+	std::remove(rom_file);
+	if (loadres != LOADRES_OK) {
+		std::printf("failed to load %s\n", rom_file);
+		return EXIT_FAILURE;
+	}
+
+	std::vector<uint_least32_t> video(160 * 144);
+	std::vector<uint_least32_t> audio(samples_per_frame + 2064);
+	for (int frames = 0; frames < 10;) {
+		std::size_t samples = samples_per_frame;
+		frames += gb.runFor(&video[0], 160, &audio[0], samples) >= 0;
+	}
+
+	GB::VideoSnapshot snapshot;
+	gb.getVideoSnapshot(snapshot);
+
+	int failures = 0;
+	if (snapshot.scx != scx || snapshot.scy != scy || !snapshot.cgb) {
+		std::printf("the snapshot has SCX %02X, SCY %02X and cgb %d\n",
+		            snapshot.scx, snapshot.scy, snapshot.cgb);
+		++failures;
+	}
+
+	std::vector<uint_least32_t> const expected = expectedFrame(snapshot);
+	int differ = 0;
+	for (std::size_t i = 0; i < video.size(); ++i)
+		differ += video[i] != expected[i];
+
+	if (differ) {
+		std::printf("%d frame pixels differ from the tile map and sprites\n", differ);
+		failures += differ;
+	}
+
+	failures += checkTileSheet(snapshot);
+	failures += checkOutline(snapshot);
+	if (failures)
+		return EXIT_FAILURE;
+
+	std::printf("vram viewers: tile map, sprites, tile sheet and outline agree with the frame\n");
+	return EXIT_SUCCESS;
+}